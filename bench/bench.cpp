@@ -0,0 +1,586 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Command.hpp"
+#include "Random.h"
+
+#include "Gen.hpp"
+#include "GenGrid.hpp"
+#include "GenMarker.hpp"
+#include "GenSample.hpp"
+#include "GenSimulate.hpp"
+#include "GenVariant.hpp"
+
+#include "IBD.hpp"
+#include "IBD_HMM.hpp"
+
+#include "LoadHMM.hpp"
+
+#include "Age.hpp"
+#include "AgeDensity.hpp"
+#include "AgeEstimate.hpp"
+#include "AgeInfer.hpp"
+#include "AgeWindow.hpp"
+#include "AgePipeline.hpp"
+
+
+//
+// Benchmarks of hot kernels and end-to-end scenarios over a synthetic grid, reported as JSON
+//
+namespace
+{
+	using clock_t = std::chrono::steady_clock;
+
+
+	// Measured throughput
+	struct Result
+	{
+		std::string name;
+		std::string unit;
+
+		size_t calls;
+		size_t items;
+		double seconds;
+	};
+
+
+	// Repeat function until minimum time has elapsed; function returns number of items processed per call
+	template< typename F >
+	Result measure(const std::string & name, const std::string & unit, const double min_seconds, F func)
+	{
+		Result r{ name, unit, 0, 0, 0.0 };
+
+		const clock_t::time_point begin = clock_t::now();
+
+		do
+		{
+			r.items += func();
+			r.calls += 1;
+			r.seconds = std::chrono::duration<double>(clock_t::now() - begin).count();
+		}
+		while (r.seconds < min_seconds);
+
+		std::clog << " " << std::left << std::setw(32) << name << " " << std::right << std::setw(14) << std::fixed << std::setprecision(1) << r.items / r.seconds << " " << unit << "/s" << std::endl;
+
+		return r;
+	}
+
+
+	// Synthetic panel
+	Gen::Grid::Data make_panel(const std::string & filename, const size_t n_samples, const size_t n_markers)
+	{
+		const size_t buffer_limit = std::max(size_t(1), std::min(n_markers, size_t(1 << 30) / n_samples)); // markers held before saving to temporary file
+
+		Gen::Simulate simulate(Gen::Simulate::Param(n_samples, n_markers));
+		Gen::Grid::Make buffer(filename, n_samples, buffer_limit, false);
+
+		while (simulate.next(buffer))
+		{
+			if (buffer.full)
+				buffer.save(true);
+		}
+
+		buffer.finish(simulate.sample, simulate.marker);
+
+		return std::make_shared< Gen::Grid >(filename);
+	}
+
+
+	// Markers with at least two allele copies
+	Gen::Marker::Key::Vector make_eligible(const Gen::Grid::Data grid)
+	{
+		Gen::Marker::Key::Vector eligible;
+
+		for (size_t i = 0; i < grid->marker_size(); ++i)
+		{
+			const size_t count = grid->marker(i).hap_count[Gen::H1];
+
+			if (count >= 2 && count < grid->sample_size()) // not fixed
+				eligible.push_back(i);
+		}
+
+		return eligible;
+	}
+
+
+	// Target sites, evenly spaced over eligible markers
+	Gen::Marker::Key::Vector make_targets(const Gen::Grid::Data grid, const size_t n)
+	{
+		const Gen::Marker::Key::Vector eligible = make_eligible(grid);
+
+		Gen::Marker::Key::Vector target;
+
+		const size_t k = std::min(n, eligible.size());
+
+		for (size_t i = 0; i < k; ++i)
+			target.push_back(eligible[(i * eligible.size()) / k]);
+
+		return target;
+	}
+
+
+	// Target sites, consecutive eligible markers from middle of grid
+	Gen::Marker::Key::Vector make_adjacent(const Gen::Grid::Data grid, const size_t n)
+	{
+		const Gen::Marker::Key::Vector eligible = make_eligible(grid);
+
+		const size_t k = std::min(n, eligible.size());
+		const size_t a = (eligible.size() - k) / 2;
+
+		return Gen::Marker::Key::Vector(eligible.begin() + a, eligible.begin() + a + k);
+	}
+
+
+	// Individuals carrying focal allele, once per allele copy
+	Gen::Sample::Key::Vector carriers(const Gen::Grid::Data grid, const Gen::Marker::Key & focus)
+	{
+		Gen::Sample::Key::Vector share;
+
+		for (size_t i = 0; i < grid->sample_size(); ++i)
+		{
+			const Gen::hap_pair_t h = Gen::genotype_to_haplotypes(grid->get(i)->gen(focus));
+
+			if (Gen::is_haplotype<Gen::H1>(h[Gen::MATERNAL])) share.push_back(i);
+			if (Gen::is_haplotype<Gen::H1>(h[Gen::PATERNAL])) share.push_back(i);
+		}
+
+		return share;
+	}
+
+
+	// Closed-form CCF of exponential distribution (Erlang, shape 1)
+	Age::CCF make_ccf(const decimal_t rate)
+	{
+		Age::CCF ccf;
+
+		ccf.shape  = 1;
+		ccf.rate   = rate;
+		ccf.q25    = std::log(decimal_t(4) / decimal_t(3)) / rate;
+		ccf.q50    = std::log(decimal_t(2)) / rate;
+		ccf.q75    = std::log(decimal_t(4)) / rate;
+		ccf.closed = true;
+		ccf.good   = true;
+
+		return ccf;
+	}
+
+
+	// Receiver counting completed sites and pairs
+	class Count : public Age::Sink
+	{
+	public:
+
+		size_t sites = 0;
+		size_t pairs = 0;
+
+		void write(const Age::Site::Data site)
+		{
+			if (!site->done)
+				return;
+
+			++this->sites;
+
+			Age::Pair::List::const_iterator p, p_end = site->list.cend();
+
+			for (p = site->list.cbegin(); p != p_end; ++p)
+				if ((*p)->done)
+					++this->pairs;
+		}
+
+		void warn(const std::string &) {}
+	};
+
+
+	void print_json(std::ostream & stream, const size_t n_samples, const size_t n_markers, const size_t n_sites, const size_t threads, const std::vector< Result > & results)
+	{
+		stream << "{" << std::endl;
+		stream << "  \"scenario\": { \"samples\": " << n_samples << ", \"markers\": " << n_markers << ", \"sites\": " << n_sites << ", \"threads\": " << threads << " }," << std::endl;
+		stream << "  \"results\": [" << std::endl;
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result & r = results[i];
+
+			stream << "    { \"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\"";
+			stream << ", \"calls\": " << r.calls << ", \"items\": " << r.items;
+			stream << ", \"seconds\": " << std::fixed << std::setprecision(6) << r.seconds;
+			stream << ", \"per_second\": " << std::fixed << std::setprecision(3) << ((r.seconds > 0) ? r.items / r.seconds: 0.0) << " }";
+			stream << ((i + 1 < results.size()) ? "," : "") << std::endl;
+		}
+
+		stream << "  ]" << std::endl;
+		stream << "}" << std::endl;
+	}
+}
+
+
+
+//
+// Main
+//
+int main(int argc, const char * argv[])
+{
+	Command::Line line(argc, argv);
+
+	Command::Value< size_t >         n_samples("samples", "Number of individuals in synthetic grid (default: 250)");
+	Command::Value< size_t >         n_markers("markers", "Number of markers in synthetic grid (default: 10000)");
+	Command::Value< size_t >         n_sites("sites", "Number of target sites (default: 10)");
+	Command::Value< size_t >         threads('t', "threads", "Number of threads in end-to-end scenario (default: 1)");
+	Command::Value< double >         min_time("minTime", "Minimum time per microbenchmark, in seconds (default: 0.5)");
+	Command::Value< size_t >         seed("seed", "Seed of synthetic grid and random operations (default: 1)");
+	Command::Array< std::string, 2 > hmm_file("hmm", "Hidden Markov Model, 2 input files (default: ./hmm/)");
+	Command::Value< std::string >    output('o', "out", "JSON output file (default: stdout)");
+
+	try
+	{
+		line.parse();
+
+		line.get(n_samples, false, size_t(250));
+		line.get(n_markers, false, size_t(10000));
+		line.get(n_sites, false, size_t(10));
+		line.get(threads, false, size_t(1));
+		line.get(min_time, false, 0.5);
+		line.get(seed, false, size_t(1));
+		line.get(hmm_file, false, std::array< std::string, 2 >{{ "hmm/hmm_initial_probs.txt", "hmm/hmm_emission_probs.txt" }});
+		line.get(output, false);
+
+		line.finish();
+	}
+	catch (const int &)
+	{
+		return EXIT_SUCCESS;
+	}
+	catch (const std::exception & error)
+	{
+		std::cerr << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+
+	std::vector< Result > results;
+
+	const std::string grid_file = "bench.tmp." + random_string(8) + ".bin";
+
+	try
+	{
+		set_random_seed(seed);
+
+
+		// synthetic grid
+
+		Gen::Grid::Data grid;
+
+		results.push_back(measure("make_panel", "markers", 0.0, [&]
+		{
+			grid = make_panel(grid_file, n_samples, n_markers);
+			return n_markers.value;
+		}));
+
+		std::remove(grid_file.c_str());
+
+		const size_t n_sample = grid->sample_size();
+		const size_t n_marker = grid->marker_size();
+
+
+		// model and parameters
+
+		LoadHMM load(10000, n_sample * 2);
+
+		load.make_initial(grid, hmm_file[0]);
+		load.make_emission(grid, hmm_file[1]);
+		load.make_transition(grid);
+
+		const IBD::HMM::Model::Data model = load.make_model();
+
+		Age::Param::Data param = std::make_shared< Age::Param >(grid, 10000, 1e-08);
+
+		param->threads = 1;
+
+		const Gen::Marker::Key::Vector target = make_targets(grid, n_sites);
+
+
+		// genotype vectors
+
+		std::vector< Gen::gen_vector_t > gen(n_sample);
+		std::vector< Gen::value_vector_t > zip(n_sample);
+
+		for (size_t i = 0; i < n_sample; ++i)
+		{
+			gen[i] = grid->get(i)->gen();
+			zip[i] = Gen::compress_genotype_vector(gen[i], gen[i].size());
+		}
+
+		results.push_back(measure("compress_genotype_vector", "markers", min_time, [&]
+		{
+			for (size_t i = 0; i < n_sample; ++i)
+				zip[i] = Gen::compress_genotype_vector(gen[i], gen[i].size());
+			return n_sample * n_marker;
+		}));
+
+		results.push_back(measure("decompress_genotype_vector", "markers", min_time, [&]
+		{
+			for (size_t i = 0; i < n_sample; ++i)
+				gen[i] = Gen::decompress_genotype_vector(zip[i], zip[i].size(), n_marker);
+			return n_sample * n_marker;
+		}));
+
+		results.push_back(measure("Variant::Vector::hap", "markers", min_time, [&]
+		{
+			for (size_t i = 0; i < n_sample; ++i)
+			{
+				Gen::Variant::Vector v(gen[i]);
+
+				v.hap(Gen::MATERNAL);
+				v.hap(Gen::PATERNAL);
+			}
+			return n_sample * n_marker;
+		}));
+
+
+		// nearest neighbours, once per site; ranking of chunks dominates construction of sites
+
+		std::vector< Age::Site::Data > sites;
+
+		results.push_back(measure("Near::pairwise", "sites", 0.0, [&]
+		{
+			for (size_t k = 0; k < target.size(); ++k)
+			{
+				const Gen::Sample::Key::Vector share = carriers(grid, target[k]);
+
+				sites.push_back(std::make_shared< Age::Site >(share.size(), target[k], share, grid, param));
+			}
+			return target.size();
+		}));
+
+		sites.erase(std::remove_if(sites.begin(), sites.end(), [](const Age::Site::Data & site) { return site->done; }), sites.end());
+
+
+		// inferred pairs, once per pair
+
+		size_t n_pairs = 0;
+
+		for (size_t k = 0; k < sites.size(); ++k)
+			n_pairs += sites[k]->list.size();
+
+		results.push_back(measure("Infer::run", "pairs", 0.0, [&]
+		{
+			for (size_t k = 0; k < sites.size(); ++k)
+			{
+				Age::Pair::List::const_iterator p, p_end = sites[k]->list.cend();
+
+				for (p = sites[k]->list.cbegin(); p != p_end; ++p)
+				{
+					(*p)->site = sites[k];
+
+					Age::Infer(param, IBD::DETECT_HMM, 0.10, *p, grid, model).run();
+				}
+
+				sites[k]->estimate(param);
+			}
+			return n_pairs;
+		}));
+
+
+		// pairwise kernels
+
+		std::array< size_t, Age::n_clocks > n_good{{ 0, 0, 0 }}; // pairs estimated per clock
+
+		std::vector< std::pair< Age::Site::Data, Age::Pair::Data > > detected; // pairs with segment
+
+		for (size_t k = 0; k < sites.size(); ++k)
+		{
+			Age::Pair::List::const_iterator p, p_end = sites[k]->list.cend();
+
+			for (p = sites[k]->list.cbegin(); p != p_end; ++p)
+			{
+				bool good = false;
+
+				for (int c = 0; c < Age::n_clocks; ++c)
+				{
+					if ((*p)->ccf[c].good)
+					{
+						++n_good[c];
+						good = true;
+					}
+				}
+
+				if (good)
+					detected.push_back(std::make_pair(sites[k], *p));
+			}
+		}
+
+		results.push_back(measure("HMM::Algorithm::detect", "pairs", min_time, [&]
+		{
+			for (size_t i = 0; i < detected.size(); ++i)
+			{
+				const Age::Site::Data site = detected[i].first;
+				const Age::Pair::Data pair = detected[i].second;
+
+				IBD::HMM::Algorithm algorithm(grid->get(pair->pair.first.individual)->hap(pair->pair.first.chromosome), grid->get(pair->pair.second.individual)->hap(pair->pair.second.chromosome), model, !pair->sharing);
+
+				algorithm.detect(site->fk, site->focus);
+			}
+			return detected.size();
+		}));
+
+		for (int c = 0; c < Age::n_clocks; ++c)
+		{
+			const Age::ClockType clock = static_cast<Age::ClockType>(c);
+
+			const std::string label = (c == 0) ? "M": (c == 1) ? "R": "J";
+
+			results.push_back(measure("Density::estimate(" + label + ")", "pairs", min_time, [&]
+			{
+				for (size_t k = 0; k < sites.size(); ++k)
+				{
+					Age::Pair::List::const_iterator p, p_end = sites[k]->list.cend();
+
+					for (p = sites[k]->list.cbegin(); p != p_end; ++p)
+					{
+						if (!(*p)->ccf[c].good)
+							continue;
+
+						Age::Density age(param, (*p)->sharing, sites[k]->focus, (*p)->segment);
+
+						age.differences((*p)->segdiff);
+						age.estimate(clock);
+					}
+				}
+				return n_good[c];
+			}));
+		}
+
+		results.push_back(measure("Site::filter", "sites", min_time, [&]
+		{
+			for (size_t k = 0; k < sites.size(); ++k)
+				for (int c = 0; c < Age::n_clocks; ++c)
+					sites[k]->filter(static_cast<Age::ClockType>(c), param);
+			return sites.size();
+		}));
+
+
+		// nearest neighbours of consecutive sites, ranked per site or from sliding window reused between sites
+
+		{
+			const Gen::Marker::Key::Vector adjacent = make_adjacent(grid, n_sites * 10);
+
+			std::vector< Gen::Sample::Key::Vector > share(adjacent.size());
+
+			for (size_t k = 0; k < adjacent.size(); ++k)
+				share[k] = carriers(grid, adjacent[k]);
+
+			results.push_back(measure("Near::pairwise(adjacent)", "sites", min_time, [&]
+			{
+				for (size_t k = 0; k < adjacent.size(); ++k)
+					Age::Site site(share[k].size(), adjacent[k], share[k], grid, param);
+				return adjacent.size();
+			}));
+
+			results.push_back(measure("Window::move(adjacent)", "sites", min_time, [&]
+			{
+				Age::Window window(grid, param);
+
+				for (size_t k = 0; k < adjacent.size(); ++k)
+				{
+					window.move(adjacent[k]);
+
+					Age::Site site(share[k].size(), adjacent[k], window.share(), grid, param, &window);
+				}
+				return adjacent.size();
+			}));
+		}
+
+
+		// adaptive and fixed time grid on flat likelihood surface
+
+		{
+			Age::Param::Data adapt = std::make_shared< Age::Param >(*param, grid, 10000, 1e-08);
+
+			adapt->adaptive_grid = true;
+
+			const Age::Gamete::Pair gametes;
+
+			Age::CCF share = make_ccf(decimal_t(1)); // one pair each, likelihood within few log units over time prior
+			Age::CCF other = make_ccf(decimal_t(0.5));
+
+			results.push_back(measure("Estimate::estimate(flat)", "sites", min_time, [&]
+			{
+				Age::Estimate age(param, target.front());
+
+				age.include(share, true, gametes);
+				age.include(other, false, gametes);
+				age.estimate();
+				return 1;
+			}));
+
+			results.push_back(measure("Estimate::adaptive(flat)", "sites", min_time, [&]
+			{
+				Age::Estimate age(adapt, target.front());
+
+				age.include(share, true, gametes);
+				age.include(other, false, gametes);
+				age.estimate();
+				return 1;
+			}));
+		}
+
+
+		// end-to-end, sweep over target sites through pipeline
+
+		param->threads = threads;
+
+		Count count;
+
+		results.push_back(measure("pipeline", "sites", 0.0, [&]
+		{
+			Age::Queue queue(grid, param, target);
+			Age::Pipeline pipeline(queue, param, IBD::DETECT_HMM, 0.10, grid, model, nullptr, threads);
+
+			pipeline.run(count);
+
+			return count.sites;
+		}));
+
+		Result pairs = results.back();
+
+		pairs.name  = "pipeline";
+		pairs.unit  = "pairs";
+		pairs.items = count.pairs;
+
+		results.push_back(pairs);
+	}
+	catch (const std::exception & error)
+	{
+		std::remove(grid_file.c_str());
+
+		std::cerr << "Error: " << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+
+	if (output.good())
+	{
+		std::ofstream stream(output.value);
+
+		print_json(stream, n_samples, n_markers, n_sites, threads, results);
+	}
+	else
+	{
+		print_json(std::cout, n_samples, n_markers, n_sites, threads, results);
+	}
+
+	return EXIT_SUCCESS;
+}
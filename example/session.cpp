@@ -0,0 +1,93 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Geva.hpp"
+
+
+//
+// Minimal use of the library interface (libgeva), built by `make lib`
+//
+// Loads a binary input file and the HMM once, then estimates the age of the given target positions
+// and prints the site results in the layout of the sites file, e.g.
+//
+//  ./geva_example data.bin hmm/hmm_initial_probs.txt hmm/hmm_emission_probs.txt 10176 20001 35007
+//
+namespace
+{
+	// Receiver of site results, printed as they are completed
+	class Print : public Geva::Sink
+	{
+	public:
+
+		void site(const Geva::SiteResult & result)
+		{
+			std::printf("%zu %c %d %zu %zu ", result.marker, result.clock, result.filtered, result.n_concordant, result.n_discordant);
+
+			print(result.mean);
+			std::printf(" ");
+			print(result.mode);
+			std::printf(" ");
+			print(result.median);
+			std::printf("\n");
+		}
+
+
+	private:
+
+		static void print(const double value)
+		{
+			if (std::isnan(value))
+				std::printf("NA");
+			else
+				std::printf("%.8f", value);
+		}
+	};
+}
+
+
+int main(int argc, char * argv[])
+{
+	if (argc < 5)
+	{
+		std::cerr << "Usage: " << argv[0] << " <input.bin> <hmm_initial> <hmm_emission> <position> [<position> ...]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		std::vector< size_t > positions;
+
+		for (int i = 4; i < argc; ++i)
+			positions.push_back(std::stoul(argv[i]));
+
+		Geva::Options options;
+
+		options.seed = 1;
+
+		Geva::Session session(argv[1], argv[2], argv[3], options);
+
+		Print sink;
+
+		std::printf("MarkerID Clock Filtered N_Concordant N_Discordant PostMean PostMode PostMedian\n");
+
+		const size_t warn = session.estimate(positions, sink);
+
+		std::cerr << positions.size() << " target positions, " << warn << " warnings" << std::endl;
+	}
+	catch (const std::exception & error)
+	{
+		std::cerr << "Error: " << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
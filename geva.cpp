@@ -16,6 +16,7 @@
 
 #include "load_map.h"
 #include "load_vcf.h"
+#include "simulate_bin.h"
 //#include "load_gen.h"
 //#include "load_hap.h"
 #include "load_bin.h"
@@ -33,8 +34,14 @@
 //#include "count_share.h"
 
 #include "infer_age.h"
+#include "serve_age.h"
+#include "sweep_age.h"
+#include "convert_columns.h"
+#include "merge_results.h"
 
 #include "Command.hpp"
+#include "Memory.hpp"
+#include "Metrics.hpp"
 #include "Redirect.hpp"
 #include "Clock.hpp"
 
@@ -50,7 +57,7 @@ int main(int argc, const char * argv[])
 	Command::Value< std::string >  output('o', "out", "Prefix for generated output files");
 	Command::Value< size_t >       thread('t', "treads", "Number of threads for parallel execution (default: 1)");
 	Command::Value< size_t >       buffer('b', "buffer", "Memory buffer, upper limit in megabytes (default: no limit)");
-	Command::Value< size_t >       seed("seed", "Set seed for random operations (may not be reproducible if t>1)");
+	Command::Value< size_t >       seed("seed", "Set seed for random operations");
 	
 	// input arguments
 	Command::Value< std::string >    input_bin_file('i', "input", "Pre-processed binary input file");
@@ -60,17 +67,49 @@ int main(int argc, const char * argv[])
 	Command::Value< size_t >         input_lines("maxLines", "Number of lines to be buffered while processing input file (default: 500000)");
 	Command::Bool                    local_tmp_files("localTmpFiles", "Temporary files are stored in local directory when parsing input file");
 	Command::Array< std::string, 2 > input_hmm_file("hmm", "Hidden Markov Model, 2 input files: (1) empirical initial state and (2) emission probabilties");
+	Command::Value< std::string >    input_col_file("convert", "Binary columnar results file (*.col) to be converted to text output");
+	Command::Vector< std::string >   input_merge_files("merge", "Results files of several runs (*.txt, *.txt.gz, *.col) to be merged into text output, ordered by MarkerID");
+	Command::Vector< std::string >   input_store_files("reestimate", "Segment store files of previous runs (*.segments.col); ages are re-estimated without segment detection");
+	
+	// synthetic input arguments
+	Command::Array< size_t, 2 > sim_size("simulate", "Generate synthetic haplotype panel of given number of individuals and variants, instead of reading VCF file");
+	Command::Value< double >    sim_missing("simMissing", "Proportion of missing genotypes in synthetic panel (default: 0)");
+	Command::Value< size_t >    sim_truth("simTruth", "Number of focal sites for which true pairwise segments are written (default: 0)");
+	Command::Value< size_t >    sim_pairs("simPairs", "Max. number of concordant and of discordant pairs per focal site in truth file (default: 100)");
 	
 	// genomic position arguments
 	Command::Value< size_t >      share_position("position", "Target position");
 	Command::Value< std::string > share_batch("positions", "Batch file containing target positions (any white-space separation)");
+	Command::Bool                 share_sweep("allVariants", "Target all variants, sweeping focal sites in position order");
+	Command::Value< std::string > share_shard("shard", "Process only given part i/N of target sites (1 <= i <= N), balanced by expected number of pairs");
+	
+	// resident mode arguments
+	Command::Bool                 serve_stdin("serve", "Keep data loaded and read batches of target positions from stdin, one batch per line");
+	Command::Value< std::string > serve_socket("socket", "Keep data loaded and read batches of target positions from local socket, one batch per line");
 	
 	// age estimation parameters
 	Command::Value< size_t > effective_size("Ne", "Effective population size (default: 10000)");
 	Command::Value< double > mutation_rate("mut", "Mutation rate, per site per generation (default: 1e-08)");
 	Command::Value< size_t > age_limit_sharers("maxConcordant", "Maximim number of concordant pairs to be selected (default: 100)");
 	Command::Value< size_t > age_outgroup_size("maxDiscordant", "Maximum number of discordant pairs to be selected (default: 100)");
-	Command::Value< double > max_missing("maxMissing", "Maximum missing proportion of sites in HMM (default: 5%)");
+	Command::Value< double > max_missing("maxMissing", "Skip pairs with more sites near focal site missing in either individual than this proportion (default: 10%)");
+	Command::Bool            age_composite("composite", "Estimate age from composite posterior of filtered pairs (as in estimate.R); Filtered=2 in sites file");
+	Command::Bool            age_adaptive("adaptiveGrid", "Evaluate likelihood on coarse time grid, refined around its mode only");
+	Command::Vector< size_t > sweep_effective_size("sweepNe", "Effective population sizes of parameter sweep, each combined with each --sweepMut value in a single pass; replaces --Ne");
+	Command::Vector< double > sweep_mutation_rate("sweepMut", "Mutation rates of parameter sweep, each combined with each --sweepNe value in a single pass; replaces --mut");
+	Command::Value< size_t > memory_limit("memoryLimit", "Limit of tracked memory in megabytes, fewer pairs are scheduled while exceeded (default: no limit)");
+	
+	// output arguments
+	Command::Bool            output_columnar("columnar", "Write pairs and sites as binary columnar files (*.pairs.col, *.sites.col)");
+	Command::Bool            output_gzip("gzip", "Write pairs and sites as BGZF compressed text files (*.txt.gz), compressed on all threads");
+	Command::Value< size_t > output_checkpoint("checkpoint", "Record completed sites every given number of seconds, to resume interrupted run");
+	Command::Bool            output_resume("resume", "Continue interrupted run from checkpoint, appending to output files");
+	Command::Bool            output_metrics("metrics", "Write per-stage timing and counters to NAME.metrics.json");
+	Command::Bool            output_segments("segments", "Write detected segments of all pairs to NAME.segments.col, to re-estimate ages later");
+	
+	
+	size_t shard_index = 0; // part of target sites
+	size_t shard_count = 1;
 	
 	
 	// parse command line
@@ -82,15 +121,39 @@ int main(int argc, const char * argv[])
 		line.get(thread, false, size_t(1));
 		line.get(buffer, false, std::numeric_limits<size_t>::max()); // default: all individuals
 		line.get(seed, false);
+		line.get(output_metrics, false, false);
 		
 		
-		if (!line.get(input_bin_file, false)) // BIN
+		if (line.get(input_col_file, false)) // columnar results
+		{
+			// conversion to text, requires output prefix only
+		}
+		else if (line.get(input_merge_files, false)) // results of several runs
 		{
+			// merge to text, requires output prefix only
+		}
+		else if (!line.get(input_bin_file, false)) // BIN
+		{
+			// synthetic panel
+			const bool do_simulate = line.get(sim_size, false);
+			
+			if (do_simulate)
+			{
+				line.get(effective_size, false, size_t(10000)); // default: 10000
+				line.get(mutation_rate, false, double(1e-08)); // default: 1e-08
+				line.get(sim_missing, false, double(0.0)); // default: none
+				line.get(sim_truth, false, size_t(0)); // default: none
+				line.get(sim_pairs, false, size_t(100)); // default: 100
+			}
+			
 			// VCF file
-			line.get(input_vcf_file, false);
+			const bool do_vcf = line.get(input_vcf_file, false);
 			
 			// genetic map
-			line.get(input_map_file, false);
+			const bool do_map = line.get(input_map_file, false);
+			
+			if (do_simulate && (do_vcf || do_map))
+				throw std::invalid_argument("Conflicting panel input, synthetic panel replaces VCF and map files");
 			
 			// optionally constant recombination rate
 			line.get(input_rec_rate, false, double(1e-08)); // default: 1e-08
@@ -109,20 +172,86 @@ int main(int argc, const char * argv[])
 			// batch file of positions
 			const bool do_batch = line.get(share_batch, false);
 			
-			if (do_position && do_batch)
+			// all variants
+			const bool do_sweep = line.get(share_sweep, false, false);
+			
+			// resident mode, positions given per request
+			const bool do_stdin  = line.get(serve_stdin, false, false);
+			const bool do_socket = line.get(serve_socket, false);
+			const bool do_serve  = do_stdin || do_socket;
+			
+			// sites of segment store, re-estimation only
+			const bool do_store = line.get(input_store_files, false);
+			
+			if (do_stdin && do_socket)
+				throw std::invalid_argument("Conflicting resident mode input");
+			
+			if ((do_position && do_batch) || (do_sweep && (do_position || do_batch)) || (do_serve && (do_position || do_batch || do_sweep)) || (do_store && (do_position || do_batch || do_sweep || do_serve)))
 				throw std::invalid_argument("Conflicting target position input");
 			
-			if (!do_position && !do_batch)
+			if (!do_position && !do_batch && !do_sweep && !do_serve && !do_store)
 				throw std::invalid_argument("Missing target position input");
 			
 			
-			line.get(input_hmm_file, true);
+			line.get(input_hmm_file, !do_store); // segments detected before
 			
 			line.get(effective_size, false, size_t(10000)); // default: 10000
 			line.get(mutation_rate, false, double(1e-08)); // default: 1e-08
-			line.get(max_missing, false, double(0.05)); // defaul: 5%
+			line.get(max_missing, false, double(0.10)); // defaul: 10%
 			line.get(age_limit_sharers, false, size_t(100)); // default: 100
 			line.get(age_outgroup_size, false, size_t(100)); // default: 100
+			line.get(age_composite, false, false);
+			line.get(age_adaptive, false, false);
+			line.get(memory_limit, false);
+			
+			// several effective sizes and/or mutation rates, first combination as --Ne and --mut
+			const bool do_sweep_Ne  = line.get(sweep_effective_size, false);
+			const bool do_sweep_mut = line.get(sweep_mutation_rate, false);
+			
+			if (do_sweep_Ne)
+				effective_size.value = sweep_effective_size.value.front();
+			
+			if (do_sweep_mut)
+				mutation_rate.value = sweep_mutation_rate.value.front();
+			
+			if (line.get(share_shard, false))
+			{
+				std::istringstream iss(share_shard.value);
+				
+				char sep = 0;
+				
+				if (!(iss >> shard_index >> sep >> shard_count) || sep != '/' || shard_index < 1 || shard_index > shard_count)
+					throw std::invalid_argument("Invalid shard, expected i/N with 1 <= i <= N");
+				
+				if (do_serve)
+					throw std::invalid_argument("Shards require target position input");
+				
+				shard_index -= 1;
+			}
+			
+			line.get(output_columnar, false, false);
+			line.get(output_gzip, false, false);
+			
+			if (output_columnar && output_gzip)
+				throw std::invalid_argument("Conflicting output format");
+			
+			const bool do_checkpoint = line.get(output_checkpoint, false);
+			const bool do_resume     = line.get(output_resume, false, false);
+			
+			if ((do_checkpoint || do_resume) && (output_columnar || do_serve))
+				throw std::invalid_argument("Checkpoints require text output files");
+			
+			if (line.get(output_segments, false, false))
+			{
+				if (do_store || do_serve)
+					throw std::invalid_argument("Segment store requires segment detection at target positions");
+				
+				if (do_checkpoint || do_resume)
+					throw std::invalid_argument("Checkpoints cannot be combined with segment store");
+			}
+			
+			if ((do_sweep_Ne || do_sweep_mut) && (do_store || do_serve || output_columnar || do_checkpoint || do_resume || output_segments))
+				throw std::invalid_argument("Parameter sweep requires text output of target positions");
 		}
 
 		line.finish();
@@ -146,9 +275,16 @@ int main(int argc, const char * argv[])
 	
 	
 	// redirect log/err output
+	std::streambuf * console = std::cerr.rdbuf();
+	
 	Redirect redirect_log(std::clog, output.value + ".log");
 	Redirect redirect_err(std::cerr, output.value + ".err");
 	
+	// when serving on stdin, stdout carries responses only; console output is moved to stderr
+	std::ostream serve_output(std::cout.rdbuf());
+	
+	Redirect redirect_out(std::cout, (serve_stdin) ? console: std::cout.rdbuf());
+	
 	
 	
 	std::cout << std::endl;
@@ -164,6 +300,13 @@ int main(int argc, const char * argv[])
 	// begin timer
 	Clock runtime;
 	
+	Metrics::enable(output_metrics);
+	
+	if (memory_limit.good())
+	{
+		Memory::limit(memory_limit.value * 1024 * 1024);
+	}
+	
 	
 	// main algorithm
 	try
@@ -172,7 +315,36 @@ int main(int argc, const char * argv[])
 		
 		Gen::Grid::Data grid;
 		
-		if (!input_bin_file.good())
+		if (input_col_file.good())
+		{
+			convert_columns(input_col_file, output);
+		}
+		else if (input_merge_files.good())
+		{
+			merge_results(input_merge_files.value, output);
+		}
+		else if (!input_bin_file.good() && sim_size.good())
+		{
+			Gen::Simulate::Param sim_param(sim_size[0], sim_size[1]);
+			
+			sim_param.Ne          = effective_size;
+			sim_param.mut         = mutation_rate;
+			sim_param.rec         = input_rec_rate;
+			sim_param.missing     = sim_missing;
+			sim_param.truth_sites = sim_truth;
+			sim_param.truth_pairs = sim_pairs;
+			
+			// buffer of ~1 GB unless given
+			const size_t sim_lines = (input_lines.good()) ? input_lines.value: std::max(size_t(1), std::min(input_lines.value, size_t(1 << 30) / sim_param.samples));
+			
+			input_bin_file = simulate_bin(sim_param, output, sim_lines, false, local_tmp_files);
+			
+			grid = load_bin(input_bin_file);
+			
+			grid->print_sample(output.value + ".sample.txt");
+			grid->print_marker(output.value + ".marker.txt");
+		}
+		else if (!input_bin_file.good())
 		{
 			// switch between map rec rate or fixed rec rate
 			Gen::Map gmap = (input_map_file.good()) ? load_map(input_map_file): load_map(input_rec_rate);
@@ -202,7 +374,12 @@ int main(int argc, const char * argv[])
 			
 			IBD::DetectMethod method = IBD::DETECT_HMM;
 			IBD::HMM::Model::Data hmm_model;
-			hmm_model = load_hmm(grid, input_hmm_file[0], input_hmm_file[1], effective_size, output);
+			Age::SegmentStore::Data store;
+			
+			if (input_store_files.good())
+				store = std::make_shared< Age::SegmentStore >(input_store_files.value, grid); // detected before
+			else
+				hmm_model = load_hmm(grid, input_hmm_file[0], input_hmm_file[1], effective_size, output);
 			
 			
 			// execute age estimation
@@ -215,9 +392,46 @@ int main(int argc, const char * argv[])
 			if (age_outgroup_size.good())
 				param->outgroup_size = age_outgroup_size.value;
 			
+			param->run_composite = age_composite;
+			param->all_variants  = share_sweep;
+			param->adaptive_grid = age_adaptive;
+			
 			param->threads = thread;
 			
-			infer_age(param, method, max_missing, output, false, false, share, grid, runtime, hmm_model, nullptr, thread);
+			param->shard_index = shard_index;
+			param->shard_count = shard_count;
+			
+			if (sweep_effective_size.good() || sweep_mutation_rate.good())
+			{
+				const std::vector< size_t > Ne  = (sweep_effective_size.good()) ? sweep_effective_size.value: std::vector< size_t >(1, effective_size.value);
+				const std::vector< double > mut = (sweep_mutation_rate.good()) ? sweep_mutation_rate.value: std::vector< double >(1, mutation_rate.value);
+				
+				sweep_age(std::make_shared< Age::Sweep >(grid, param, hmm_model, Ne, mut), method, max_missing, output, share, grid, thread, 1000, output_gzip);
+			}
+			else if (serve_stdin || serve_socket.good())
+			{
+				serve_age(param, method, max_missing, grid, hmm_model, serve_socket.good() ? serve_socket.value: std::string(), serve_output, thread);
+			}
+			else
+			{
+				InferOptions run;
+				
+				run.threads    = thread;
+				run.columnar   = output_columnar;
+				run.compress   = output_gzip;
+				run.checkpoint = (output_checkpoint.good()) ? output_checkpoint.value: ((output_resume) ? 600: 0);
+				run.resume     = output_resume;
+				run.segments   = output_segments;
+				
+				infer_age(param, method, max_missing, output, share, grid, runtime, run, hmm_model, nullptr, store);
+			}
+			
+			Memory::print(std::clog);
+		}
+		
+		if (output_metrics)
+		{
+			Metrics::print(output.value + ".metrics.json", runtime.elapsed.s());
 		}
 	}
 	catch(const std::exception & error)
@@ -88,6 +88,7 @@ CCF::CCF()
 , q25(decimal_nil)
 , q50(decimal_nil)
 , q75(decimal_nil)
+, closed(false)
 , good(false)
 , pass(true)
 {}
@@ -96,9 +97,10 @@ CCF::CCF(const CCF & other)
 : shape(other.shape)
 , rate(other.rate)
 , q25(other.q25)
-, q50(other.q25)
-, q75(other.q25)
+, q50(other.q50)
+, q75(other.q75)
 , d(other.d)
+, closed(other.closed)
 , good(other.good)
 , pass(other.pass)
 {}
@@ -107,9 +109,10 @@ CCF::CCF(CCF && other)
 : shape(other.shape)
 , rate(other.rate)
 , q25(other.q25)
-, q50(other.q25)
-, q75(other.q25)
+, q50(other.q50)
+, q75(other.q75)
 , d(std::move(other.d))
+, closed(other.closed)
 , good(other.good)
 , pass(other.pass)
 {}
@@ -125,6 +128,7 @@ CCF & CCF::operator = (const CCF & other)
 	this->q50   = other.q50;
 	this->q75   = other.q75;
 	this->d     = other.d;
+	this->closed = other.closed;
 	this->good  = other.good;
 	this->pass  = other.pass;
 	return *this;
@@ -138,6 +142,7 @@ CCF & CCF::operator = (CCF && other)
 	this->q50   = other.q50;
 	this->q75   = other.q75;
 	this->d     = std::move(other.d);
+	this->closed = other.closed;
 	this->good  = other.good;
 	this->pass  = other.pass;
 	return *this;
@@ -165,12 +170,12 @@ Param::Param(const Gen::Grid::Data grid, const size_t ne, const decimal_t  mr, c
 , theta(static_cast<decimal_t>(4 * ne) * mr) // default theta
 , theta_est(false)
 , theta_man(false)
+, columns(grid->columns())
+, position(columns->position())
+, distance(columns->distance((4.0 * this->Ne) / decimal_100)) // scaled by effective size
 , prior(n_times, decimal_nil)
 , log_prior(n_times, decimal_nil)
 {
-	const decimal_t FourNe100 = (4.0 * this->Ne) / decimal_100;
-	
-	
 	// settings
 	
 	this->include_prior = true;
@@ -183,6 +188,13 @@ Param::Param(const Gen::Grid::Data grid, const size_t ne, const decimal_t  mr, c
 	this->run_rec_clock = true;
 	this->run_cmb_clock = true;
 	
+	this->run_composite = false;
+	this->all_variants  = false;
+	
+	this->adaptive_grid   = false;
+	this->adaptive_stride = 16;
+	this->adaptive_refine = 4;
+	
 	//this->apply_filter_fixed   = false;
 	//this->apply_filter_detect  = true;
 	this->apply_nearest_neighb = true;
@@ -201,44 +213,15 @@ Param::Param(const Gen::Grid::Data grid, const size_t ne, const decimal_t  mr, c
 	
 	this->threads = 1;
 	
+	this->shard_index = 0;
+	this->shard_count = 1;
 	
-	// variables
 	
-	const size_t n_sites = grid->marker_size();
+	// variables
 	
 	this->boundary[LHS] = grid->marker().front().index;
 	this->boundary[RHS] = grid->marker().back().index;
 	
-	this->position.resize(n_sites, decimal_nil);
-	this->distance.resize(n_sites, decimal_nil);
-	this->frequency.resize(n_sites, decimal_nil);
-	this->log_het.resize(n_sites, decimal_nil);
-	this->log_hom.resize(n_sites, decimal_nil);
-	this->cum_log_hom.resize(n_sites, decimal_nil);
-	
-	
-	for (size_t i = 0; i < n_sites; ++i)
-	{
-		Marker const & marker = grid->marker(i);
-		
-		this->position[i] = static_cast<decimal_t>(marker.position);
-		
-		this->distance[i] = marker.gen_dist * FourNe100;
-		
-		this->frequency[i] = static_cast<decimal_t>(marker.hap_count[H1]) / static_cast<decimal_t>(this->Nh);
-		
-		this->log_het[i] = std::log(decimal_two * this->frequency[i] * (decimal_one - this->frequency[i]));
-		
-		this->log_hom[i] = std::log(std::pow(this->frequency[i], decimal_two) + std::pow(decimal_one - this->frequency[i], decimal_two));
-	}
-	
-	this->cum_log_hom[0] = this->log_hom[0];
-	
-	for (size_t i = 1; i < n_sites; ++i)
-	{
-		this->cum_log_hom[i] = this->cum_log_hom[ i - 1 ] + this->log_hom[i];
-	}
-	
 	
 	// write coalescent times prior
 	
@@ -273,6 +256,66 @@ Param::Param(const Gen::Grid::Data grid, const size_t ne, const decimal_t  mr, c
 }
 
 
+// construct with same settings, other effective size and mutation rate
+
+Param::Param(const Param & other, const Gen::Grid::Data grid, const size_t ne, const decimal_t mr)
+: nt(other.nt)
+, Ng(other.Ng)
+, Nh(other.Nh)
+, Nm(other.Nm)
+, Ne(static_cast<decimal_t>(ne))
+, Mr(mr)
+, theta((other.theta_est || other.theta_man) ? other.theta: static_cast<decimal_t>(4 * ne) * mr)
+, theta_est(other.theta_est)
+, theta_man(other.theta_man)
+, boundary(other.boundary)
+, columns(other.columns)
+, position(other.position)
+, distance(columns->distance((4.0 * this->Ne) / decimal_100)) // scaled by other effective size
+, prior(other.prior)
+, log_prior(other.log_prior)
+{
+	// settings
+	
+	this->include_prior = other.include_prior;
+	this->use_post_prob = other.use_post_prob;
+	this->use_hard_brks = other.use_hard_brks;
+	
+	this->run_mut_clock = other.run_mut_clock;
+	this->run_rec_clock = other.run_rec_clock;
+	this->run_cmb_clock = other.run_cmb_clock;
+	
+	this->run_composite = other.run_composite;
+	this->all_variants  = other.all_variants;
+	
+	this->adaptive_grid   = other.adaptive_grid;
+	this->adaptive_stride = other.adaptive_stride;
+	this->adaptive_refine = other.adaptive_refine;
+	
+	this->apply_nearest_neighb = other.apply_nearest_neighb;
+	this->relax_nearest_neighb = other.relax_nearest_neighb;
+	this->use_tree_consistency = other.use_tree_consistency;
+	
+	this->limit_sharers = other.limit_sharers;
+	this->outgroup_size = other.outgroup_size;
+	
+	this->limit_sharers_max = other.limit_sharers_max;
+	this->outgroup_size_max = other.outgroup_size_max;
+	
+	this->breakpt_range = other.breakpt_range;
+	
+	this->nearest_range = other.nearest_range;
+	
+	this->threads = other.threads;
+	
+	this->shard_index = other.shard_index;
+	this->shard_count = other.shard_count;
+	
+	if (grid->columns() != this->columns)
+		throw std::invalid_argument("Parameters of different input data");
+}
+
+
 // set theta manually
 
 void Param::set_theta(const double th)
@@ -9,10 +9,12 @@
 #include <vector>
 
 #include "Decimal.h"
+#include "Memory.hpp"
 
 #include "Gen.hpp"
 #include "GenMarker.hpp"
 #include "GenGrid.hpp"
+#include "GenColumns.hpp"
 
 #include "IBD.hpp"
 
@@ -83,8 +85,9 @@ namespace Age
 		decimal_t q50;
 		decimal_t q75;
 		
-		decimal_vector_t d;
+		decimal_vector_t d; // dense density, empty if closed
 		
+		bool closed; // Erlang CDF fully described by shape and rate
 		bool good;
 		bool pass;
 	};
@@ -122,6 +125,7 @@ namespace Age
 		
 		// construct
 		Param(const Gen::Grid::Data, const size_t = 10000, const decimal_t = 1e-08, const size_t = 1024, const decimal_t = 40.0, const bool = true);
+		Param(const Param &, const Gen::Grid::Data, const size_t, const decimal_t); // same settings, other effective size and mutation rate
 		
 		// set theta manually
 		void set_theta(const double);
@@ -154,6 +158,13 @@ namespace Age
 		bool run_rec_clock;
 		bool run_cmb_clock;
 		
+		bool run_composite; // composite posterior estimate (as in estimate.R)
+		bool all_variants;  // sweep over all variants in position order
+		
+		bool   adaptive_grid;   // coarse bracket and local refinement of time grid (closed-form CCFs only)
+		size_t adaptive_stride; // coarse grid, every n-th time point
+		size_t adaptive_refine; // local grid, subdivisions per time point, up to size of time prior
+		
 		//bool apply_filter_fixed;
 		//bool apply_filter_detect;
 		bool apply_nearest_neighb;
@@ -172,16 +183,18 @@ namespace Age
 		
 		size_t threads;
 		
+		size_t shard_index; // partition of target sites processed, in [0, shard_count)
+		size_t shard_count; // number of partitions, balanced by expected pairs
+		
 		
 		// variables
 		
-		IBD::Segment     boundary;
-		decimal_vector_t position;
-		decimal_vector_t distance;
-		decimal_vector_t frequency;
-		decimal_vector_t log_het;
-		decimal_vector_t log_hom;
-		decimal_vector_t cum_log_hom;
+		IBD::Segment boundary;
+		
+		Gen::Columns::Data columns; // marker attributes, shared with grid
+		
+		Gen::Columns::View< uint32_t >  position; // physical position
+		Gen::Columns::View< decimal_t > distance; // genetic distance, scaled by 4Ne/100
 		
 		decimal_vector_t prior; // defined time grid
 		decimal_vector_t log_prior; // log scale
@@ -0,0 +1,252 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgeCheckpoint.hpp"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "Hash.h"
+#include "Random.h"
+
+
+using namespace Age;
+
+
+namespace
+{
+	static const std::string title = "GEVA checkpoint";
+}
+
+
+
+// Periodic record of completed sites, consistent with flushed output files
+
+// read state from checkpoint file, returns false if file not found
+
+bool Checkpoint::load(const std::string & filename, State & state)
+{
+	std::ifstream stream(filename);
+
+	if (!stream)
+		return false;
+
+	std::string line;
+
+	if (!std::getline(stream, line) || line != title)
+		throw std::runtime_error("Not a checkpoint file: " + filename);
+
+
+	bool header = false;
+	size_t files = 0;
+
+	std::vector< size_t > pending; // completed sites of current record
+
+	uint64_t offset = line.size() + 1;
+
+	state.fingerprint = 0;
+	state.length = 0;
+	state.sizes.clear();
+	state.done.clear();
+
+	while (std::getline(stream, line))
+	{
+		if (stream.eof())
+			break; // incomplete line
+
+		offset += line.size() + 1;
+
+		std::istringstream fields(line);
+		std::string key;
+
+		fields >> key;
+
+		if (key == "seed")
+		{
+			fields >> state.seed;
+		}
+		else if (key == "fingerprint")
+		{
+			fields >> std::hex >> state.fingerprint;
+		}
+		else if (key == "files")
+		{
+			header = static_cast<bool>(fields >> files);
+		}
+		else if (key == "done")
+		{
+			size_t id;
+
+			while (fields >> id)
+				pending.push_back(id);
+		}
+		else if (key == "sync")
+		{
+			std::vector< uint64_t > sizes;
+			uint64_t size;
+
+			while (fields >> size)
+				sizes.push_back(size);
+
+			if (!header || sizes.size() != files)
+				throw std::runtime_error("Invalid checkpoint record in file: " + filename);
+
+			state.length = offset;
+			state.sizes.swap(sizes);
+			state.done.insert(pending.cbegin(), pending.cend());
+
+			pending.clear();
+		}
+		else
+		{
+			throw std::runtime_error("Invalid checkpoint record in file: " + filename);
+		}
+	}
+
+	if (state.sizes.empty())
+		throw std::runtime_error("No valid checkpoint record in file: " + filename);
+
+	return true;
+}
+
+
+// fingerprint of target sites, estimation parameters, detection method and model
+
+uint64_t Checkpoint::fingerprint(const Queue & queue, const Param::Data param, const IBD::DetectMethod method, const uint64_t model)
+{
+	Hash hash;
+
+	hash.add(queue.fingerprint());
+	hash.add(model);
+	hash.add(method);
+
+	// estimation
+	hash.add(param->nt);
+	hash.add(param->Ne);
+	hash.add(param->Mr);
+	hash.add(param->theta);
+	hash.add(param->include_prior);
+	hash.add(param->use_post_prob);
+	hash.add(param->use_hard_brks);
+	hash.add(param->run_mut_clock);
+	hash.add(param->run_rec_clock);
+	hash.add(param->run_cmb_clock);
+	hash.add(param->run_composite);
+	hash.add(param->adaptive_grid);
+	hash.add(param->adaptive_stride);
+	hash.add(param->adaptive_refine);
+	hash.add(param->breakpt_range);
+
+	hash.add(uint64_t(get_random_seed())); // random streams are keyed by seed
+
+	return hash.value;
+}
+
+
+// construct, continues previous state if given; previous state must match fingerprint
+
+Checkpoint::Checkpoint(Sink & _sink, const std::string & filename, const std::vector< Output * > & _outputs, const size_t seconds, const uint64_t fingerprint, const State * state)
+: sink(_sink)
+, name(filename)
+, outputs(_outputs)
+, interval(seconds)
+, file(fopen(filename.c_str(), (state) ? "ab": "wb"), fclose)
+, last(clock_t::now())
+{
+	if (!this->file)
+		throw std::runtime_error("Unable to open checkpoint file: " + filename);
+
+	if (state)
+	{
+		if (state->fingerprint != fingerprint)
+			throw std::runtime_error("Checkpoint does not match target sites or parameters of this run: " + filename);
+
+		if (state->sizes.size() != this->outputs.size())
+			throw std::runtime_error("Checkpoint does not match output files: " + filename);
+
+		// discard incomplete record of interrupted run
+		if (ftruncate(fileno(this->file.get()), static_cast<off_t>(state->length)) != 0)
+			throw std::runtime_error("Unable to truncate checkpoint file: " + filename);
+	}
+	else
+	{
+		std::ostringstream header;
+
+		header << title << std::endl;
+		header << "seed " << get_random_seed() << std::endl;
+		header << "fingerprint " << std::hex << std::setw(16) << std::setfill('0') << fingerprint << std::endl;
+		header << "files " << this->outputs.size() << std::endl;
+
+		fputs(header.str().c_str(), this->file.get());
+
+		this->save(); // output headers
+	}
+}
+
+
+// write site and its pairs
+
+void Checkpoint::write(const Site::Data site)
+{
+	this->sink.write(site);
+
+	if (!site->done)
+		return;
+
+	this->recent.push_back(site->focus.value);
+
+	if (clock_t::now() - this->last >= this->interval)
+		this->save();
+}
+
+
+// report warning during estimation
+
+void Checkpoint::warn(const std::string & warning)
+{
+	this->sink.warn(warning);
+}
+
+
+// flush output files and record completed sites
+
+void Checkpoint::save()
+{
+	std::ostringstream record;
+
+	record << "done";
+
+	for (size_t i = 0; i < this->recent.size(); ++i)
+		record << ' ' << this->recent[i];
+
+	record << std::endl << "sync";
+
+	for (size_t i = 0; i < this->outputs.size(); ++i)
+		record << ' ' << this->outputs[i]->flush(); // output is written before it is recorded
+
+	record << std::endl;
+
+	const std::string str = record.str();
+
+	if (fwrite(str.data(), 1, str.size(), this->file.get()) != str.size() || fflush(this->file.get()) != 0 || fsync(fileno(this->file.get())) != 0)
+		throw std::runtime_error("Error while writing checkpoint file: " + this->name);
+
+	this->recent.clear();
+
+	this->last = clock_t::now();
+}
+
+
+// remove checkpoint file after completion
+
+void Checkpoint::remove()
+{
+	this->file.reset();
+
+	std::remove(this->name.c_str());
+}
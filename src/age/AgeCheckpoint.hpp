@@ -0,0 +1,94 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgeCheckpoint_hpp
+#define AgeCheckpoint_hpp
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Output.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+
+namespace Age
+{
+	// Periodic record of completed sites, consistent with flushed output files
+	//
+	// The checkpoint file is appended to; each record lists the sites completed since the previous record,
+	// followed by the size of each output file after flushing. A record is valid only once its last line is complete.
+	// The header carries a fingerprint of target sites and parameters; a run is resumed only if it matches.
+	class Checkpoint : public Sink
+	{
+	public:
+
+		// State of interrupted run, as of last valid record
+		struct State
+		{
+			uint64_t seed;        // random seed; random streams are keyed by seed and site
+			uint64_t fingerprint; // target sites and parameters
+			uint64_t length;      // size of checkpoint file up to last valid record
+
+			std::vector< uint64_t > sizes; // size of output files
+
+			std::unordered_set< size_t > done; // marker ids of completed sites
+		};
+
+
+		// read state from checkpoint file, returns false if file not found
+		static bool load(const std::string &, State &);
+
+		// fingerprint of target sites, estimation parameters, detection method and model (see SegmentStore)
+		static uint64_t fingerprint(const Queue &, const Param::Data, const IBD::DetectMethod, const uint64_t);
+
+
+		// construct, continues previous state if given; previous state must match fingerprint
+		Checkpoint(Sink &, const std::string &, const std::vector< Output * > &, const size_t, const uint64_t, const State * = nullptr);
+		Checkpoint(const Checkpoint &) = delete; // no copy
+
+		// write site and its pairs
+		void write(const Site::Data);
+
+		// report warning during estimation
+		void warn(const std::string &);
+
+		// flush output files and record completed sites
+		void save();
+
+		// remove checkpoint file after completion
+		void remove();
+
+
+	private:
+
+		using clock_t = std::chrono::steady_clock;
+
+
+		Sink & sink;
+
+		const std::string name;
+
+		const std::vector< Output * > outputs;
+
+		const std::chrono::seconds interval;
+
+		std::unique_ptr<FILE, int (*)(FILE *)> file;
+
+		std::vector< size_t > recent; // completed since last record
+
+		clock_t::time_point last; // time of last record
+	};
+}
+
+
+#endif /* AgeCheckpoint_hpp */
@@ -0,0 +1,303 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgeColumns.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+
+using namespace Gen;
+using namespace IBD;
+using namespace Age;
+
+
+namespace
+{
+	// column indices
+	enum PairColumn { P_MARKER, P_CLOCK, P_SAMPLE0, P_CHR0, P_SAMPLE1, P_CHR1, P_SHARED, P_PASS, P_LHS, P_RHS, P_SHAPE, P_RATE, P_Q25, P_Q50, P_Q75 };
+	enum SiteColumn { S_MARKER, S_CLOCK, S_FILTERED, S_SHARED, S_OTHERS, S_MEAN, S_MODE, S_MEDIAN };
+
+
+	uint64_t clock_label(const int c)
+	{
+		return (c == 0) ? 'M': (c == 1) ? 'R': 'J';
+	}
+
+	uint64_t chr_label(const ChrType chr)
+	{
+		switch (chr)
+		{
+			case MATERNAL: return 0;
+			case PATERNAL: return 1;
+			case UNPHASED: return 5;
+			case CHR_VOID: return 9;
+		}
+		return 9;
+	}
+
+
+	// decimal value as in text output, NA if not given
+	void print_value(std::ostream & stream, const double value)
+	{
+		if (std::isnan(value))
+			stream << "NA";
+		else
+			stream << std::fixed << std::setprecision(8) << value;
+	}
+
+
+	// pairs file layout
+	void print_pairs(Columnar::Reader & reader, std::ostream & stream)
+	{
+		Pair::print_header(stream, nullptr, false);
+
+		std::vector< std::vector< uint64_t > > col(P_RATE);
+		std::vector< double > rate;
+
+		for (size_t g = 0; g < reader.groups(); ++g)
+		{
+			for (size_t i = 0; i < P_RATE; ++i)
+				reader.get(g, i, col[i]);
+
+			reader.get(g, P_RATE, rate);
+
+			for (size_t r = 0; r < reader.rows(g); ++r)
+			{
+				stream << col[P_MARKER][r] << ' ';
+				stream << static_cast<char>(col[P_CLOCK][r]) << ' ';
+				stream << col[P_SAMPLE0][r] << ' ';
+				stream << col[P_CHR0][r] << ' ';
+				stream << col[P_SAMPLE1][r] << ' ';
+				stream << col[P_CHR1][r] << ' ';
+				stream << col[P_SHARED][r] << ' ';
+				stream << col[P_PASS][r] << ' ';
+				stream << col[P_LHS][r] << ' ';
+				stream << col[P_RHS][r] << ' ';
+				stream << col[P_SHAPE][r] << ' ';
+				stream << std::fixed << std::setprecision(8) << rate[r] << ' ';
+				stream << '\n';
+			}
+		}
+	}
+
+
+	// sites file layout
+	void print_sites(Columnar::Reader & reader, std::ostream & stream)
+	{
+		Site::print_header(stream, nullptr, false);
+
+		std::vector< std::vector< uint64_t > > col(S_MEAN);
+		std::vector< std::vector< double > > est(3);
+
+		for (size_t g = 0; g < reader.groups(); ++g)
+		{
+			for (size_t i = 0; i < S_MEAN; ++i)
+				reader.get(g, i, col[i]);
+
+			for (size_t i = 0; i < 3; ++i)
+				reader.get(g, S_MEAN + i, est[i]);
+
+			for (size_t r = 0; r < reader.rows(g); ++r)
+			{
+				stream << col[S_MARKER][r] << ' ';
+				stream << static_cast<char>(col[S_CLOCK][r]) << ' ';
+				stream << col[S_FILTERED][r] << ' ';
+				stream << col[S_SHARED][r] << ' ';
+				stream << col[S_OTHERS][r] << ' ';
+				print_value(stream, est[0][r]);
+				stream << ' ';
+				print_value(stream, est[1][r]);
+				stream << ' ';
+				print_value(stream, est[2][r]);
+				stream << '\n';
+			}
+		}
+	}
+}
+
+
+
+// Binary columnar output of sites and pairs
+
+// table names
+
+const std::string ColumnSink::pairs_table = "pairs";
+const std::string ColumnSink::sites_table = "sites";
+
+
+// column layout
+
+Columnar::Schema ColumnSink::pairs_schema()
+{
+	return {
+		{ "MarkerID",   Columnar::UINT32 },
+		{ "Clock",      Columnar::UINT8 },
+		{ "SampleID0",  Columnar::UINT32 },
+		{ "Chr0",       Columnar::UINT8 },
+		{ "SampleID1",  Columnar::UINT32 },
+		{ "Chr1",       Columnar::UINT8 },
+		{ "Shared",     Columnar::UINT8 },
+		{ "Pass",       Columnar::UINT8 },
+		{ "SegmentLHS", Columnar::UINT32 },
+		{ "SegmentRHS", Columnar::UINT32 },
+		{ "Shape",      Columnar::UINT32 },
+		{ "Rate",       Columnar::FLOAT64 },
+		{ "q25",        Columnar::FLOAT64 },
+		{ "q50",        Columnar::FLOAT64 },
+		{ "q75",        Columnar::FLOAT64 }
+	};
+}
+
+Columnar::Schema ColumnSink::sites_schema()
+{
+	return {
+		{ "MarkerID",     Columnar::UINT32 },
+		{ "Clock",        Columnar::UINT8 },
+		{ "Filtered",     Columnar::UINT8 },
+		{ "N_Concordant", Columnar::UINT32 },
+		{ "N_Discordant", Columnar::UINT32 },
+		{ "PostMean",     Columnar::FLOAT64 },
+		{ "PostMode",     Columnar::FLOAT64 },
+		{ "PostMedian",   Columnar::FLOAT64 }
+	};
+}
+
+
+// construct
+
+ColumnSink::ColumnSink(const Param::Data _param, const std::string & file_pairs, const std::string & file_sites)
+: param(_param)
+, pairs(file_pairs, pairs_table, pairs_schema())
+, sites(file_sites, sites_table, sites_schema())
+{}
+
+
+// write site and its pairs
+
+void ColumnSink::write(const Site::Data site)
+{
+	if (!site->done)
+		return;
+
+	this->write(*site, site->raw, 0);
+	this->write(*site, site->adj, 1);
+
+	if (this->param->run_composite)
+		this->write(*site, site->com, 2);
+
+
+	// pairs
+
+	Pair::List::const_iterator p, p_end = site->list.cend();
+
+	for (p = site->list.cbegin(); p != p_end; ++p)
+	{
+		this->write(*site, **p);
+	}
+}
+
+
+// write footers
+
+void ColumnSink::close()
+{
+	this->pairs.close();
+	this->sites.close();
+}
+
+
+// site results per clock
+
+void ColumnSink::write(const Site & site, const std::array< CLE, n_clocks > & cle, const int filtered)
+{
+	static constexpr double none = std::numeric_limits<double>::quiet_NaN();
+
+	for (int c = 0; c < n_clocks; ++c)
+	{
+		CLE const & out = cle[c];
+
+		if (!out.good)
+			continue;
+
+		// scaled as in text output
+		const decimal_t mean   = out.mean   * decimal_two * static_cast<decimal_t>(this->param->Ne);
+		const decimal_t mode   = out.mode   * decimal_two * static_cast<decimal_t>(this->param->Ne);
+		const decimal_t median = out.median * decimal_two * static_cast<decimal_t>(this->param->Ne);
+
+		this->sites.put(S_MARKER,   uint64_t(site.focus.value));
+		this->sites.put(S_CLOCK,    clock_label(c));
+		this->sites.put(S_FILTERED, uint64_t(filtered));
+		this->sites.put(S_SHARED,   uint64_t(out.n_shared));
+		this->sites.put(S_OTHERS,   uint64_t(out.n_others));
+		this->sites.put(S_MEAN,     (filtered == 2) ? none: static_cast<double>(mean));
+		this->sites.put(S_MODE,     static_cast<double>(mode));
+		this->sites.put(S_MEDIAN,   (filtered == 2) ? none: static_cast<double>(median));
+		this->sites.next();
+	}
+}
+
+
+// pair results per clock
+
+void ColumnSink::write(const Site & site, const Pair & pair)
+{
+	if (!pair.done)
+		return;
+
+	for (int c = 0; c < n_clocks; ++c)
+	{
+		CCF const & ccf = pair.ccf[c];
+
+		if (!ccf.good)
+			continue;
+
+		this->pairs.put(P_MARKER,  uint64_t(site.focus.value));
+		this->pairs.put(P_CLOCK,   clock_label(c));
+		this->pairs.put(P_SAMPLE0, uint64_t(pair.pair.first.individual.value));
+		this->pairs.put(P_CHR0,    chr_label(pair.pair.first.chromosome));
+		this->pairs.put(P_SAMPLE1, uint64_t(pair.pair.second.individual.value));
+		this->pairs.put(P_CHR1,    chr_label(pair.pair.second.chromosome));
+		this->pairs.put(P_SHARED,  uint64_t(pair.sharing));
+		this->pairs.put(P_PASS,    uint64_t(ccf.pass));
+		this->pairs.put(P_LHS,     uint64_t(pair.segment[LHS].value));
+		this->pairs.put(P_RHS,     uint64_t(pair.segment[RHS].value));
+		this->pairs.put(P_SHAPE,   uint64_t(ccf.shape));
+		this->pairs.put(P_RATE,    static_cast<double>(ccf.rate));
+		this->pairs.put(P_Q25,     static_cast<double>(ccf.q25));
+		this->pairs.put(P_Q50,     static_cast<double>(ccf.q50));
+		this->pairs.put(P_Q75,     static_cast<double>(ccf.q75));
+		this->pairs.next();
+	}
+}
+
+
+
+// Print columnar file in text layout of pairs or sites file, returns table name
+
+std::string Age::print_columns(const std::string & filename, std::ostream & stream)
+{
+	Columnar::Reader reader(filename);
+
+	const Columnar::Schema expect = (reader.table() == ColumnSink::pairs_table) ? ColumnSink::pairs_schema(): ColumnSink::sites_schema();
+
+	bool match = (reader.table() == ColumnSink::pairs_table || reader.table() == ColumnSink::sites_table) && reader.schema().size() == expect.size();
+
+	for (size_t i = 0; match && i < expect.size(); ++i)
+	{
+		match = (reader.schema()[i].name == expect[i].name && reader.schema()[i].type == expect[i].type);
+	}
+
+	if (!match)
+		throw std::runtime_error("Unknown columnar results file: " + filename);
+
+	if (reader.table() == ColumnSink::pairs_table)
+		print_pairs(reader, stream);
+	else
+		print_sites(reader, stream);
+
+	return reader.table();
+}
@@ -0,0 +1,65 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgeColumns_hpp
+#define AgeColumns_hpp
+
+#include <ostream>
+#include <string>
+
+#include "Columnar.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+
+namespace Age
+{
+	// Binary columnar output of sites and pairs
+	class ColumnSink : public Sink
+	{
+	public:
+
+		// table names
+		static const std::string pairs_table;
+		static const std::string sites_table;
+
+		// column layout
+		static Columnar::Schema pairs_schema();
+		static Columnar::Schema sites_schema();
+
+
+		// construct
+		ColumnSink(const Param::Data, const std::string &, const std::string &);
+
+		// write site and its pairs
+		void write(const Site::Data);
+
+		// write footers
+		void close();
+
+
+	private:
+
+		// site results per clock
+		void write(const Site &, const std::array< CLE, n_clocks > &, const int);
+
+		// pair results per clock
+		void write(const Site &, const Pair &);
+
+
+		const Param::Data param;
+
+		Columnar::Writer pairs;
+		Columnar::Writer sites;
+	};
+
+
+	// Print columnar file in text layout of pairs or sites file, returns table name
+	std::string print_columns(const std::string &, std::ostream &);
+}
+
+
+#endif /* AgeColumns_hpp */
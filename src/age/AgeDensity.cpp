@@ -4,6 +4,8 @@
 
 #include "AgeDensity.hpp"
 
+#include "Metrics.hpp"
+
 
 using namespace Gen;
 using namespace IBD;
@@ -21,6 +23,8 @@ Density::Density(const Param::Data para, const bool shared, const Marker::Key &
 , segdiff(0, 0)
 , differences_flag(false)
 , probability_flag(false)
+, incl_mut_clock(false)
+, incl_rec_clock(false)
 {
 	if (this->segment[LHS] > this->focal || this->focal > this->segment[RHS])
 	{
@@ -91,6 +95,8 @@ void Density::probability(decimal_vector_t && lhs, decimal_vector_t && rhs)
 
 CCF Density::estimate(const ClockType clock)
 {
+	Metrics::Scope scope(Metrics::DENSITY_ESTIMATE);
+
 	// exclude zero-size segments when focal allele is shared
 //	if (this->share && this->length[LHS] == 1 && this->length[RHS] == 1)
 //	{
@@ -130,44 +136,152 @@ CCF Density::with_uncertainty(const ClockType clock)
 // assume full certainty about detected breakpoints
 
 // cumulative gamma function (Erlang)
-inline decimal_t gamma_cdf(const size_t a, const decimal_t b, const decimal_t t)
+
+static constexpr decimal_t erlang_near_one = decimal_one - (decimal_err / 2);
+static constexpr decimal_t erlang_near_nil = (decimal_err / 2);
+static constexpr decimal_t erlang_max_tb = static_cast<decimal_t>(600); // exp(-t * b) underflows beyond ~745
+static constexpr size_t    erlang_block    = 64; // time points per vectorised block
+
+// clip Poisson sum (survival) to CDF
+inline decimal_t erlang_clip(const decimal_t sum)
 {
-	static constexpr decimal_t near_one = decimal_one - (decimal_err / 2);
-	static constexpr decimal_t near_nil = (decimal_err / 2);
+	if (sum > erlang_near_one) return erlang_near_nil;
 
-	const decimal_t tb = t * b;
-	const decimal_t lg = std::log(tb);
+	return (sum < erlang_near_nil) ? erlang_near_one: decimal_one - sum;
+}
 
-	decimal_t cum = decimal_nil;
+// Poisson terms in log space, for large t * b
+inline decimal_t erlang_sum_log(const size_t a, const decimal_t x, const decimal_t lx)
+{
+	decimal_t sum = decimal_nil;
 
 	for (size_t i = 0; i < a; ++i)
 	{
-		cum += std::exp(-1 * std::lgamma(i + decimal_one) + (lg * i) - tb);
+		sum += std::exp(-1 * std::lgamma(i + decimal_one) + (lx * i) - x);
 
-		if (cum > near_one) return near_nil;
+		if (sum > erlang_near_one) break;
 	}
 
-	return (cum < near_nil) ? near_one: decimal_one - cum;
+	return sum;
+}
 
-//	const decimal_t ntb  = -1.0 * t * b;
-//	const decimal_t ltb = std::log(t * b);
-//
-//	decimal_t fac = decimal_nil;
-//	decimal_t cum = decimal_nil;
-//
-//	for (size_t i = 0; i < a; ++i)
-//	{
-//		cum += std::exp(ntb + fac - std::lgamma(i + decimal_one));
-//		fac += ltb;
-//	}
-//
-//	return decimal_one - cum;
+// Poisson-term recurrence, x^i exp(-x) / i! from previous term times x / i
+inline decimal_t erlang_sum(const size_t a, const decimal_t x)
+{
+	decimal_t term = std::exp(-x);
+	decimal_t sum  = term;
+
+	for (size_t i = 1; i < a; ++i)
+	{
+		term *= x * (decimal_one / static_cast<decimal_t>(i));
+		sum  += term;
+
+		if (sum > erlang_near_one) break;
+	}
+
+	return sum;
+}
+
+// single time point, given time and log time
+inline decimal_t gamma_cdf(const size_t a, const decimal_t b, const decimal_t t, const decimal_t lt)
+{
+	const decimal_t x = t * b;
+
+	return erlang_clip((x < erlang_max_tb) ? erlang_sum(a, x): erlang_sum_log(a, x, std::log(b) + lt));
+}
+
+// time points in blocks, recurrence vectorised across time
+inline void gamma_cdf(const size_t a, const decimal_t b, const decimal_t * t, const decimal_t * lt, const size_t n, decimal_t * out)
+{
+	decimal_t x[erlang_block];
+	decimal_t term[erlang_block];
+	decimal_t sum[erlang_block];
+
+	const decimal_t lb = std::log(b);
+
+	for (size_t k = 0; k < n; k += erlang_block)
+	{
+		const size_t m = std::min(erlang_block, n - k);
+
+		for (size_t j = 0; j < erlang_block; ++j)
+		{
+			x[j] = (j < m) ? t[k + j] * b: decimal_nil;
+		}
+
+		for (size_t j = 0; j < erlang_block; ++j)
+		{
+			term[j] = std::exp(-x[j]);
+			sum[j]  = term[j];
+		}
+
+		for (size_t i = 1; i < a; ++i)
+		{
+			const decimal_t r = decimal_one / static_cast<decimal_t>(i);
+
+			for (size_t j = 0; j < erlang_block; ++j)
+			{
+				term[j] *= x[j] * r;
+				sum[j]  += term[j];
+			}
+		}
+
+		for (size_t j = 0; j < m; ++j)
+		{
+			out[k + j] = erlang_clip((x[j] < erlang_max_tb) ? sum[j]: erlang_sum_log(a, x[j], lb + lt[k + j]));
+		}
+	}
+}
+
+// first time point in [0, n) with CDF above value (or equal, unless strict)
+inline size_t gamma_cdf_bound(const size_t a, const decimal_t b, const decimal_t * t, const decimal_t * lt, const size_t n, const decimal_t value, const bool strict)
+{
+	size_t lo = 0;
+	size_t hi = n;
+
+	while (lo < hi)
+	{
+		const size_t mid = lo + (hi - lo) / 2;
+		const decimal_t cdf = gamma_cdf(a, b, t[mid], lt[mid]);
+
+		if ((strict) ? (cdf > value): (cdf >= value))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+// time point closest to quantile within [0, n), first of equals
+inline size_t gamma_cdf_quantile(const size_t a, const decimal_t b, const decimal_t * t, const decimal_t * lt, const size_t n, const decimal_t q)
+{
+	if (n == 0)
+		return 0;
+
+	const size_t k = gamma_cdf_bound(a, b, t, lt, n, q, false);
+
+	if (k == 0)
+		return 0;
+
+	const decimal_t lower = gamma_cdf(a, b, t[k - 1], lt[k - 1]);
+
+	if (k < n)
+	{
+		const decimal_t upper = gamma_cdf(a, b, t[k], lt[k]);
+
+		if (upper - q < q - lower)
+			return k;
+	}
+
+	return gamma_cdf_bound(a, b, t, lt, k - 1, lower, false);
 }
 
+// saturation limits of closed-form CCF
+static constexpr decimal_t ccf_near_one = decimal_one - decimal_err;
+static constexpr decimal_t ccf_near_nil = decimal_err;
+
 CCF Density::with_certainty(const ClockType clock)
 {
-	static constexpr decimal_t near_one = decimal_one - decimal_err;
-	static constexpr decimal_t near_nil = decimal_err;
 	static constexpr decimal_t q25 = static_cast<decimal_t>(0.25);
 	static constexpr decimal_t q50 = static_cast<decimal_t>(0.50);
 	static constexpr decimal_t q75 = static_cast<decimal_t>(0.75);
@@ -175,8 +289,8 @@ CCF Density::with_certainty(const ClockType clock)
 
 	const Segment & boundary = this->param->boundary;
 
-	const decimal_vector_t & distance = this->param->distance;
-	const decimal_vector_t & position = this->param->position;
+	const Gen::Columns::View< decimal_t > & distance = this->param->distance;
+	const Gen::Columns::View< uint32_t > & position = this->param->position;
 
 	const decimal_vector_t & times = this->param->prior;
 	const size_t  n_times = this->param->nt;
@@ -243,43 +357,92 @@ CCF Density::with_certainty(const ClockType clock)
 	ccf.shape = shape;
 	ccf.rate  = rate;
 
-	ccf.d = (this->share) ? decimal_vector_t(n_times, near_one): decimal_vector_t(n_times, near_nil);
+	const decimal_t * t  = this->param->prior.data();
+	const decimal_t * lt = this->param->log_prior.data();
 
-	decimal_t m25 = decimal_one;
-	decimal_t m50 = decimal_one;
-	decimal_t m75 = decimal_one;
-	size_t    i25 = 0;
-	size_t    i50 = 0;
-	size_t    i75 = 0;
+	const size_t n_sat = gamma_cdf_bound(shape, rate, t, lt, n_times, ccf_near_one, true); // saturated beyond
 
-	for (size_t i = 0; i < n_times; ++i)
-	{
-		const decimal_t value = gamma_cdf(shape, rate, times[i]);
 
-		if (value > near_one)
-			break;
+	// Quantiles
+
+	const size_t i25 = gamma_cdf_quantile(shape, rate, t, lt, n_sat, q25);
+	const size_t i50 = gamma_cdf_quantile(shape, rate, t, lt, n_sat, q50);
+	const size_t i75 = gamma_cdf_quantile(shape, rate, t, lt, n_sat, q75);
+
+	ccf.q25 = times.at(i25);
+	ccf.q50 = times.at(i50);
+	ccf.q75 = times.at(i75);
+
+	ccf.closed = true;
+	ccf.good   = true;
+
+	return ccf;
+}
+
 
-		ccf.d[i] = (this->share) ? value: decimal_one - value;
+// evaluate closed-form CCF over time grid, returns number of unsaturated time points
 
+size_t Density::evaluate(const CCF & ccf, const bool share, const Param::Data param, decimal_vector_t & out)
+{
+	const decimal_t * t  = param->prior.data();
+	const decimal_t * lt = param->log_prior.data();
+	const size_t n_times = param->nt;
 
-		// Quantiles
+	if (out.size() < n_times)
+		out.resize(n_times);
 
-		const decimal_t p25 = std::abs(value - q25);
-		const decimal_t p50 = std::abs(value - q50);
-		const decimal_t p75 = std::abs(value - q75);
+	const size_t n = gamma_cdf_bound(ccf.shape, ccf.rate, t, lt, n_times, ccf_near_one, true);
 
-		if (m25 > p25) { m25 = p25; i25 = i; }
-		if (m50 > p50) { m50 = p50; i50 = i; }
-		if (m75 > p75) { m75 = p75; i75 = i; }
+	gamma_cdf(ccf.shape, ccf.rate, t, lt, n, out.data());
+
+	if (!share)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = decimal_one - out[i];
+		}
 	}
 
-	ccf.q25 = times.at(i25);
-	ccf.q50 = times.at(i50);
-	ccf.q75 = times.at(i75);
+	return n;
+}
 
-	ccf.good = true;
 
-	return ccf;
+// evaluate closed-form CCF at given times and log times
+
+void Density::evaluate(const CCF & ccf, const bool share, const decimal_t * t, const decimal_t * lt, const size_t n, decimal_t * out)
+{
+	gamma_cdf(ccf.shape, ccf.rate, t, lt, n, out);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (out[i] > ccf_near_one)
+			out[i] = saturated(share);
+		else if (!share)
+			out[i] = decimal_one - out[i];
+	}
+}
+
+
+// value beyond unsaturated time points
+
+decimal_t Density::saturated(const bool share)
+{
+	return (share) ? ccf_near_one: ccf_near_nil;
+}
+
+
+// dense vector of CCF over time grid
+
+decimal_vector_t Density::expand(const CCF & ccf, const bool share, const Param::Data param)
+{
+	if (!ccf.closed)
+		return ccf.d;
+
+	decimal_vector_t d(param->nt, saturated(share));
+
+	evaluate(ccf, share, param, d);
+
+	return d;
 }
 
 
@@ -289,7 +452,7 @@ void Density::physical_distance()
 {
 	const Segment & boundary = this->param->boundary;
 
-	const decimal_vector_t & position = this->param->position;
+	const Gen::Columns::View< uint32_t > & position = this->param->position;
 
 	const decimal_t focal_position = position.at(this->focal.value);
 
@@ -353,7 +516,7 @@ void Density::genetic_distance()
 {
 	const Segment & boundary = this->param->boundary;
 
-	const decimal_vector_t & distance = this->param->distance;
+	const Gen::Columns::View< decimal_t > & distance = this->param->distance;
 
 	const decimal_t focal_distance = distance.at(this->focal.value);
 
@@ -429,15 +592,16 @@ void Density::approx_probability()
 
 	const Segment & boundary = this->param->boundary;
 
-	const decimal_vector_t & cum_log_hom = this->param->cum_log_hom;
-	const decimal_vector_t & log_het     = this->param->log_het;
+	const Gen::Columns::column_t< decimal_t > & cum_log_hom = this->param->columns->cum_log_hom();
+	const Gen::Columns::column_t< decimal_t > & log_het     = this->param->columns->log_het(); // per allele count
+	const Gen::Columns::column_t< uint32_t >  & fk          = this->param->columns->fk();
 
 	this->prob_distr[LHS] = decimal_vector_t(this->length[LHS], decimal_nil);
 	this->prob_distr[RHS] = decimal_vector_t(this->length[RHS], decimal_nil);
 
 
-	const Side< decimal_t > brk_het((boundary[LHS] == this->segment[LHS]) ? decimal_nil: log_het.at(this->segment[LHS] - 1),
-									(boundary[RHS] == this->segment[RHS]) ? decimal_nil: log_het.at(this->segment[RHS] + 1));
+	const Side< decimal_t > brk_het((boundary[LHS] == this->segment[LHS]) ? decimal_nil: log_het.at(fk.at(this->segment[LHS] - 1)),
+									(boundary[RHS] == this->segment[RHS]) ? decimal_nil: log_het.at(fk.at(this->segment[RHS] + 1)));
 
 
 	// LHS
@@ -489,83 +653,118 @@ void Density::approx_probability()
 
 // calculate log likelihood surface
 
-// mutation clock
-inline decimal_t mut_clock(const size_t & S, const decimal_t & L, const decimal_t & t, const decimal_t & theta)
+// precompute per-breakpoint constants, such that
+//   mutation clock: S log(L theta t) - L theta t  = mut_const + S log(t) - mut_slope t
+//   recomb.   clock: log(1 - exp(-D t / 2)) - R t / 2 = log(1 - exp(-rec_delta t)) - rec_slope t
+
+void Density::likelihood_constants(const ClockType clock)
 {
-	const decimal_t Ut = L * t * theta;
+	const decimal_t theta = this->param->theta;
 
-	return (S == 0) ? decimal_nil - Ut: (std::log(Ut) * S) - Ut;
+	this->incl_mut_clock = (clock == MUT_CLOCK || clock == CMB_CLOCK); //this->param->use_mut_clock;
+	this->incl_rec_clock = (clock == REC_CLOCK || clock == CMB_CLOCK); //this->param->use_rec_clock;
 
-	//return (S == 0) ? decimal_nil - (L * t * theta): (lt * S) - (L * t * theta);
-}
+	for (const LR side : { LHS, RHS })
+	{
+		const size_t    n = this->length[side];
+		const decimal_t S = static_cast<decimal_t>(this->segdiff[side]);
 
-// recombination clock
-//inline decimal_t rec_clock(const decimal_t B, const decimal_t & D, const decimal_t & R, const decimal_t & t, const decimal_t & lt)
-inline decimal_t rec_clock(const decimal_t & D, const decimal_t & R, const decimal_t & t)
-{
-	static constexpr decimal_t neg = static_cast<decimal_t>(-1);
+		this->mut_const[side].assign(n, decimal_nil);
+		this->mut_slope[side].assign(n, decimal_nil);
+		this->rec_delta[side].assign(n, decimal_nil);
+		this->rec_slope[side].assign(n, decimal_nil);
 
-	return std::log(decimal_one - std::exp(neg * D * t *0.5)) - (R * t *0.5);
+		if (this->incl_mut_clock)
+		{
+			const decimal_vector_t & L = this->phy_length[side];
 
-	//return (B == 0) ? decimal_nil - (R * t): (std::log(t) * B) - (R * t);
-}
+			for (size_t k = 0; k < n; ++k)
+			{
+				const decimal_t U = L[k] * theta;
 
-// estimate likelihood at time
-decimal_t Density::likelihood_estimate(const ClockType clock, const IBD::LR side, const decimal_t & time) const
-{
-	const decimal_t theta     = this->param->theta;
-	//const Segment & boundary  = this->param->boundary;
+				this->mut_const[side][k] = (S == 0) ? decimal_nil: std::log(U) * S;
+				this->mut_slope[side][k] = U;
+			}
+		}
 
-	const bool incl_mut_clock = (clock == MUT_CLOCK || clock == CMB_CLOCK); //this->param->use_mut_clock;
-	const bool incl_rec_clock = (clock == REC_CLOCK || clock == CMB_CLOCK); //this->param->use_rec_clock;
+		if (this->incl_rec_clock)
+		{
+			const decimal_vector_t & D = this->gen_deltas[side];
+			const decimal_vector_t & R = this->gen_length[side];
 
-	const size_t n = this->length[side];
-	const size_t S = this->segdiff[side];
-	const decimal_vector_t & L = this->phy_length[side];
-	const decimal_vector_t & D = this->gen_deltas[side];
-	const decimal_vector_t & R = this->gen_length[side];
-	const decimal_vector_t & P = this->prob_distr[side];
+			for (size_t k = 0; k < n; ++k)
+			{
+				this->rec_delta[side][k] = D[k] / decimal_two;
+				this->rec_slope[side][k] = R[k] / decimal_two;
+			}
+		}
+	}
 
-	//const decimal_t B = (boundary[side] == this->segment[side]) ? decimal_nil: decimal_one;
+	this->buffer.resize(std::max(this->length[LHS], this->length[RHS]));
+}
 
-	decimal_vector_t d(n, decimal_nil);
-	size_t argmax = n;
-	decimal_t max(decimal_neg);
-	decimal_t sum(decimal_nil);
+// estimate likelihood at time, log-sum-exp over breakpoints
+
+static constexpr decimal_t lse_cutoff = static_cast<decimal_t>(-40); // exp(-40) ~ 4e-18
 
+decimal_t Density::likelihood_estimate(const IBD::LR side, const decimal_t & time, const decimal_t & log_time)
+{
+	const size_t n = this->length[side];
+
+	const decimal_t * P = this->prob_distr[side].data();
+	decimal_t *       d = this->buffer.data();
 
 	for (size_t k = 0; k < n; ++k)
 	{
-		if (P[k] < decimal_neg)
-		{
-			d[k] = P[k];
-			continue;
-		}
+		d[k] = P[k];
+	}
 
-		const decimal_t mut = (incl_mut_clock) ? mut_clock(S, L[k], time, theta): decimal_nil;
-		const decimal_t rec = (incl_rec_clock) ? rec_clock(D[k], R[k], time): decimal_nil;
+	if (this->incl_mut_clock)
+	{
+		const decimal_t * A = this->mut_const[side].data();
+		const decimal_t * U = this->mut_slope[side].data();
+		const decimal_t  St = static_cast<decimal_t>(this->segdiff[side]) * log_time;
 
-		const decimal_t clk = mut + rec + P[k];
+		for (size_t k = 0; k < n; ++k)
+		{
+			d[k] += A[k] + St - (U[k] * time);
+		}
+	}
 
-		//printf("%lu  %.8f  %.8f  %.8f\n", S, mut, rec, P[k]);
+	if (this->incl_rec_clock)
+	{
+		const decimal_t * D = this->rec_delta[side].data();
+		const decimal_t * R = this->rec_slope[side].data();
 
-		if (max < clk)
+		for (size_t k = 0; k < n; ++k)
 		{
-			max = clk;
-			argmax = k;
+			d[k] += std::log(decimal_one - std::exp(-1 * D[k] * time)) - (R[k] * time);
 		}
+	}
+
+
+	// excluded breakpoints are at -inf
+
+	decimal_t max = decimal_neg;
 
-		d[k] = clk;
+	for (size_t k = 0; k < n; ++k)
+	{
+		max = std::max(max, d[k]);
 	}
 
-	if (argmax == n)
+	if (!(max > decimal_neg))
 	{
 		return decimal_nil;
 	}
 
+	decimal_t sum = decimal_nil;
+
 	for (size_t k = 0; k < n; ++k)
 	{
-		sum += std::exp(d[k] - max);
+		const decimal_t x = d[k] - max;
+
+		if (x > lse_cutoff) // skip terms below double precision of sum
+			sum += std::exp(x);
 	}
 
 	return max + std::log(sum);
@@ -623,7 +822,7 @@ inline void cum_density(decimal_vector_t & d, const size_t n)
 decimal_vector_t Density::likelihood_surface(const ClockType clock)
 {
 	const decimal_vector_t & time = this->param->prior;
-	//const decimal_vector_t & logt = this->param->log_prior;
+	const decimal_vector_t & logt = this->param->log_prior;
 	const size_t  n_times = this->param->nt;
 	const bool incl_prior = this->param->include_prior;
 
@@ -636,13 +835,15 @@ decimal_vector_t Density::likelihood_surface(const ClockType clock)
 	this->approx_probability(); // unless provided
 
 
-	decimal_vector_t llk(n_times, decimal_nil);
+	this->likelihood_constants(clock);
 
 
+	decimal_vector_t llk(n_times, decimal_nil);
+
 	for (size_t i = 0; i < n_times; ++i)
 	{
-		llk[i] += this->likelihood_estimate(clock, LHS, time[i]);
-		llk[i] += this->likelihood_estimate(clock, RHS, time[i]);
+		llk[i] += this->likelihood_estimate(LHS, time[i], logt[i]);
+		llk[i] += this->likelihood_estimate(RHS, time[i], logt[i]);
 
 		if (incl_prior)
 		{
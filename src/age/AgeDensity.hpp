@@ -5,6 +5,7 @@
 #ifndef AgeDensity_hpp
 #define AgeDensity_hpp
 
+#include <algorithm>
 #include <cmath>
 #include <mutex>
 #include <stdexcept>
@@ -34,6 +35,18 @@ namespace Age
 		// estimate cumulative coalescent function
 		CCF estimate(const ClockType);
 		
+		// evaluate closed-form CCF over time grid, returns number of unsaturated time points
+		static size_t evaluate(const CCF &, const bool, const Param::Data, decimal_vector_t &);
+		
+		// evaluate closed-form CCF at given times and log times
+		static void evaluate(const CCF &, const bool, const decimal_t *, const decimal_t *, const size_t, decimal_t *);
+		
+		// value beyond unsaturated time points
+		static decimal_t saturated(const bool);
+		
+		// dense vector of CCF over time grid
+		static decimal_vector_t expand(const CCF &, const bool, const Param::Data);
+		
 		
 		const Gen::Marker::Key focal;
 		const bool             share;
@@ -51,7 +64,8 @@ namespace Age
 		void approx_probability();
 		
 		// calculate log likelihood surface
-		decimal_t likelihood_estimate(const ClockType, const IBD::LR, const decimal_t &) const;
+		void likelihood_constants(const ClockType); // per breakpoint
+		decimal_t likelihood_estimate(const IBD::LR, const decimal_t &, const decimal_t &);
 		decimal_vector_t likelihood_surface(const ClockType);
 		
 		
@@ -65,8 +79,18 @@ namespace Age
 		IBD::Distribution phy_length;  // physical length
 		IBD::Distribution prob_distr;  // breakpoint probabilities
 		
+		IBD::Distribution mut_const;   // S log(L theta), mutation clock
+		IBD::Distribution mut_slope;   // L theta, per time
+		IBD::Distribution rec_delta;   // D / 2, per time
+		IBD::Distribution rec_slope;   // R / 2, per time
+		
+		decimal_vector_t buffer; // log likelihood per breakpoint
+		
 		bool differences_flag; // segment differences provided
 		bool probability_flag; // probabilities provided
+		
+		bool incl_mut_clock;
+		bool incl_rec_clock;
 	};
 }
 
@@ -4,6 +4,10 @@
 
 #include "AgeEstimate.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 
 using namespace Age;
 
@@ -14,6 +18,7 @@ using namespace Age;
 Estimate::Estimate(const Param::Data para, const Gen::Marker::Key & site)
 : focal(site)
 , param(para)
+, adapt(para->adaptive_grid && para->use_hard_brks)
 , shared(0)
 , others(0)
 , lower(decimal_nil)
@@ -21,7 +26,11 @@ Estimate::Estimate(const Param::Data para, const Gen::Marker::Key & site)
 //, share_done(false)
 //, share_time(decimal_nil)
 {
-	this->logsum = decimal_vector_t(this->param->nt, decimal_nil);
+	if (!this->adapt)
+	{
+		this->logsum = decimal_vector_t(this->param->nt, decimal_nil);
+		this->buffer = decimal_vector_t(this->param->nt, decimal_nil);
+	}
 }
 
 
@@ -49,9 +58,34 @@ bool Estimate::include(CCF & ccf, const bool share, const Gamete::Pair & pair)
 	
 	// calculate log sums over time vector
 	
-	for (size_t i = 0; i < n_times; ++i)
+	if (this->adapt)
+	{
+		if (!ccf.closed)
+			throw std::runtime_error("Adaptive time grid requires closed-form CCF");
+		
+		this->closed.emplace_back(ccf, share); // evaluated once time grid is known
+	}
+	else if (ccf.closed)
+	{
+		const size_t    n = Density::evaluate(ccf, share, this->param, this->buffer);
+		const decimal_t s = std::log(Density::saturated(share));
+		
+		for (size_t i = 0; i < n; ++i)
+		{
+			this->logsum[i] += std::log(this->buffer[i]);
+		}
+		
+		for (size_t i = n; i < n_times; ++i)
+		{
+			this->logsum[i] += s;
+		}
+	}
+	else
 	{
-		this->logsum[i] += std::log(ccf.d.at(i));
+		for (size_t i = 0; i < n_times; ++i)
+		{
+			this->logsum[i] += std::log(ccf.d.at(i));
+		}
 	}
 	
 	
@@ -76,14 +110,6 @@ bool Estimate::include(CCF & ccf, const bool share, const Gamete::Pair & pair)
 
 CLE Estimate::estimate()
 {
-	static constexpr decimal_t half = static_cast<decimal_t>(0.5);
-	static constexpr decimal_t ci_lower = static_cast<decimal_t>(0.025);
-	static constexpr decimal_t ci_upper = static_cast<decimal_t>(0.975);
-	
-	const decimal_vector_t & prior = this->param->prior;
-	const size_t n_times = this->param->nt;
-	
-	
 	CLE out;
 	
 	if (this->shared == 0 || this->others == 0)
@@ -107,6 +133,160 @@ CLE Estimate::estimate()
 	out.upper = std::exp(out.upper);
 	
 	
+	// summary stats
+	
+	if (this->adapt)
+	{
+		decimal_vector_t times;
+		
+		if (this->adaptive(times, this->logsum))
+		{
+			summarise(times, this->logsum, out);
+			
+			out.grid.clear(); // not aligned with time prior
+		}
+		
+		return out;
+	}
+	
+	summarise(this->param->prior, this->logsum, out);
+	
+	return out;
+}
+
+
+// log sums of included CCFs at given times
+
+void Estimate::evaluate(const decimal_vector_t & times, const decimal_vector_t & log_times, decimal_vector_t & sum)
+{
+	const size_t n = times.size();
+	
+	sum.assign(n, decimal_nil);
+	
+	if (this->buffer.size() < n)
+		this->buffer.resize(n);
+	
+	std::vector< std::pair< CCF, bool > >::const_iterator it, ti = this->closed.cend();
+	
+	for (it = this->closed.cbegin(); it != ti; ++it)
+	{
+		Density::evaluate(it->first, it->second, times.data(), log_times.data(), n, this->buffer.data());
+		
+		for (size_t i = 0; i < n; ++i)
+		{
+			sum[i] += std::log(this->buffer[i]);
+		}
+	}
+}
+
+
+// adaptive time grid, returns false if mode is at boundary
+
+bool Estimate::adaptive(decimal_vector_t & times, decimal_vector_t & sum)
+{
+	static constexpr decimal_t tail = static_cast<decimal_t>(1e-12); // posterior mass excluded at either end
+	
+	const decimal_vector_t & prior     = this->param->prior;
+	const decimal_vector_t & log_prior = this->param->log_prior;
+	const size_t n_times = this->param->nt;
+	const size_t stride  = std::max(size_t(1), this->param->adaptive_stride);
+	const size_t refine  = std::max(size_t(1), this->param->adaptive_refine);
+	
+	
+	// coarse grid, including both ends of time prior
+	
+	std::vector< size_t > index;
+	
+	for (size_t i = 0; i < n_times; i += stride)
+		index.push_back(i);
+	
+	if (index.back() != n_times - 1)
+		index.push_back(n_times - 1);
+	
+	const size_t n_coarse = index.size();
+	
+	decimal_vector_t t(n_coarse), lt(n_coarse);
+	
+	for (size_t k = 0; k < n_coarse; ++k)
+	{
+		t[k]  = prior[ index[k] ];
+		lt[k] = log_prior[ index[k] ];
+	}
+	
+	this->evaluate(t, lt, sum);
+	
+	size_t arg = 0;
+	
+	for (size_t k = 1; k < n_coarse; ++k)
+	{
+		if (sum[arg] < sum[k])
+			arg = k;
+	}
+	
+	if (arg == 0 || arg == n_coarse - 1)
+		return false;
+	
+	
+	// bracket of posterior mass on coarse grid, not assuming a single mode
+	
+	decimal_vector_t mass(n_coarse);
+	
+	decimal_t total = decimal_nil;
+	
+	for (size_t k = 0; k < n_coarse; ++k)
+	{
+		mass[k] = std::exp(sum[k] - sum[arg]);
+		total  += mass[k];
+	}
+	
+	const decimal_t limit = tail * total;
+	
+	size_t lo = 0;
+	size_t hi = n_coarse - 1;
+	
+	decimal_t below = mass[lo];
+	decimal_t above = mass[hi];
+	
+	while (lo + 1 < arg && below + mass[lo + 1] < limit)
+		below += mass[++lo];
+	
+	while (hi - 1 > arg && above + mass[hi - 1] < limit)
+		above += mass[--hi];
+	
+	
+	// local grid, log-spaced at refined resolution of time prior, but not more points than the time prior (e.g. flat likelihood)
+	
+	const decimal_t from = log_prior[ index[lo] ];
+	const decimal_t to   = log_prior[ index[hi] ];
+	const size_t    n    = std::min(((index[hi] - index[lo]) * refine) + 1, n_times);
+	const decimal_t by   = (to - from) / static_cast<decimal_t>(n - 1);
+	
+	times.resize(n);
+	lt.resize(n);
+	
+	for (size_t i = 0; i < n; ++i)
+	{
+		lt[i]    = (i == n - 1) ? to: from + (static_cast<decimal_t>(i) * by);
+		times[i] = std::exp(lt[i]);
+	}
+	
+	this->evaluate(times, lt, sum);
+	
+	return true;
+}
+
+
+// summary statistics of log sums over time grid
+
+void Estimate::summarise(const decimal_vector_t & prior, const decimal_vector_t & logsum, CLE & out)
+{
+	static constexpr decimal_t half = static_cast<decimal_t>(0.5);
+	static constexpr decimal_t ci_lower = static_cast<decimal_t>(0.025);
+	static constexpr decimal_t ci_upper = static_cast<decimal_t>(0.975);
+	
+	const size_t n_times = prior.size();
+	
+	
 	// summary stats
 	
 	decimal_vector_t seq(n_times, decimal_nil);
@@ -117,21 +297,21 @@ CLE Estimate::estimate()
 	
 	for (size_t i = 0; i < n_times; ++i)
 	{
-		if (logmax < this->logsum[i])
+		if (logmax < logsum[i])
 		{
-			logmax = this->logsum[i];
+			logmax = logsum[i];
 			arglogmax = i;
 		}
 	}
 	
 	if (arglogmax == 0 || arglogmax >= n_times - 1)
 	{
-		return out;
+		return;
 	}
 	
 	for (size_t i = 0; i < n_times; ++i)
 	{
-		seq[i] = std::exp(this->logsum[i] - logmax);
+		seq[i] = std::exp(logsum[i] - logmax);
 		seqsum += seq[i];
 	}
 	
@@ -239,7 +419,267 @@ CLE Estimate::estimate()
 	out.grid = std::move(seq);
 	
 	out.good = true;
-	
-	return out;
 }
 
+
+
+
+// Composite posterior estimate
+
+// log(1 - exp(v)), v <= 0
+inline decimal_t log1m_exp(const decimal_t v)
+{
+	static constexpr decimal_t log_half = static_cast<decimal_t>(-0.693147180559945309417);
+
+	return (v > log_half) ? std::log(-std::expm1(v)): std::log1p(-std::exp(v));
+}
+
+// log of lower and upper tail of Erlang distribution, shape a at x = rate * time; given log Gamma(a) and log Gamma(a + 1)
+inline void erlang_log_tails(const size_t a, const decimal_t x, const decimal_t lgamma_a, const decimal_t lgamma_a1, decimal_t & lower, decimal_t & upper)
+{
+	static constexpr decimal_t eps = std::numeric_limits<decimal_t>::epsilon();
+
+	const decimal_t lx = std::log(x);
+
+	decimal_t term = decimal_one;
+	decimal_t sum  = decimal_one;
+
+	if (x < static_cast<decimal_t>(a))
+	{
+		// lower tail, sum of Poisson terms i >= a, relative to first
+		for (size_t i = a + 1; term > sum * eps; ++i)
+		{
+			term *= x / static_cast<decimal_t>(i);
+			sum  += term;
+		}
+
+		lower = (lx * a) - x - lgamma_a1 + std::log(sum);
+		upper = log1m_exp(lower);
+	}
+	else
+	{
+		// upper tail, sum of Poisson terms i < a, relative to last
+		for (size_t i = a - 1; i > 0 && term > sum * eps; --i)
+		{
+			term *= static_cast<decimal_t>(i) / x;
+			sum  += term;
+		}
+
+		upper = (lx * (a - 1)) - x - lgamma_a + std::log(sum);
+		lower = log1m_exp(upper);
+	}
+}
+
+
+// construct
+
+Composite::Composite(const Param::Data para, const Gen::Marker::Key & site)
+: focal(site)
+, param(para)
+, ne(para->Ne * decimal_two)
+{}
+
+
+// include density result, duplicate pairs are ignored
+
+bool Composite::include(const CCF & ccf, const bool share, const Gamete::Pair & pair)
+{
+	if (!ccf.good)
+	{
+		return false;
+	}
+
+	if (!ccf.closed)
+		throw std::runtime_error("Composite posterior requires closed-form CCF");
+
+	if (!this->unique.emplace(pair, share).second)
+	{
+		return false;
+	}
+
+	if (share)
+		this->con.emplace_back(ccf.shape, ccf.rate);
+	else
+		this->dis.emplace_back(ccf.shape, ccf.rate);
+
+	return true;
+}
+
+
+// reject pairs with inconsistent TMRCA
+
+void Composite::qc_tmrca()
+{
+	static constexpr decimal_t step = static_cast<decimal_t>(10);
+
+	const size_t n_con = this->con.size();
+	const size_t n_dis = this->dis.size();
+
+
+	// expected TMRCA in generations, rounded to 10 (half to even)
+
+	decimal_vector_t est_con(n_con), est_dis(n_dis);
+
+	for (size_t i = 0; i < n_con; ++i)
+		est_con[i] = std::nearbyint(((static_cast<decimal_t>(this->con[i].first) / this->con[i].second) * this->ne) / step) * step;
+
+	for (size_t i = 0; i < n_dis; ++i)
+		est_dis[i] = std::nearbyint(((static_cast<decimal_t>(this->dis[i].first) / this->dis[i].second) * this->ne) / step) * step;
+
+	decimal_vector_t sort_con(est_con), sort_dis(est_dis);
+
+	std::sort(sort_con.begin(), sort_con.end());
+	std::sort(sort_dis.begin(), sort_dis.end());
+
+	if (!(sort_con.back() > sort_dis.front()))
+	{
+		return;
+	}
+
+
+	// threshold between unique values, minimising inconsistent pairs
+
+	decimal_vector_t range;
+
+	range.reserve(n_con + n_dis);
+	range.insert(range.end(), sort_con.cbegin(), sort_con.cend());
+	range.insert(range.end(), sort_dis.cbegin(), sort_dis.cend());
+
+	std::sort(range.begin(), range.end());
+	range.erase(std::unique(range.begin(), range.end()), range.end());
+
+	size_t    min = std::numeric_limits<size_t>::max();
+	decimal_t lim = decimal_nil;
+
+	for (size_t j = 0; j + 1 < range.size(); ++j)
+	{
+		const decimal_t y = range[j] + ((range[j + 1] - range[j]) / decimal_two);
+
+		const size_t num = static_cast<size_t>(sort_con.cend() - std::upper_bound(sort_con.cbegin(), sort_con.cend(), y)) +
+		                   static_cast<size_t>(std::lower_bound(sort_dis.cbegin(), sort_dis.cend(), y) - sort_dis.cbegin());
+
+		if (min > num)
+		{
+			min = num;
+			lim = y;
+		}
+	}
+
+
+	// retain consistent pairs, or most consistent pair
+
+	std::vector< Gamma > keep_con, keep_dis;
+
+	for (size_t i = 0; i < n_con; ++i)
+		if (est_con[i] < lim) keep_con.push_back(this->con[i]);
+
+	for (size_t i = 0; i < n_dis; ++i)
+		if (est_dis[i] > lim) keep_dis.push_back(this->dis[i]);
+
+	if (keep_con.empty())
+		keep_con.push_back(this->con[ std::min_element(est_con.cbegin(), est_con.cend()) - est_con.cbegin() ]);
+
+	if (keep_dis.empty())
+		keep_dis.push_back(this->dis[ std::max_element(est_dis.cbegin(), est_dis.cend()) - est_dis.cbegin() ]);
+
+	this->con.swap(keep_con);
+	this->dis.swap(keep_dis);
+}
+
+
+// log composite posterior over time grid
+
+void Composite::posterior(const decimal_vector_t & times, decimal_vector_t & cp) const
+{
+	const size_t n = times.size();
+
+	decimal_t lower, upper;
+
+	std::fill(cp.begin(), cp.end(), decimal_nil);
+
+	for (const Gamma & g : this->con)
+	{
+		const decimal_t lga  = std::lgamma(static_cast<decimal_t>(g.first)); // per pair, not per time point
+		const decimal_t lga1 = std::lgamma(g.first + decimal_one);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			erlang_log_tails(g.first, times[i] * g.second, lga, lga1, lower, upper);
+			cp[i] += lower;
+		}
+	}
+
+	for (const Gamma & g : this->dis)
+	{
+		const decimal_t lga  = std::lgamma(static_cast<decimal_t>(g.first));
+		const decimal_t lga1 = std::lgamma(g.first + decimal_one);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			erlang_log_tails(g.first, times[i] * g.second, lga, lga1, lower, upper);
+			cp[i] += upper;
+		}
+	}
+}
+
+
+// return mode of composite posterior
+
+CLE Composite::estimate()
+{
+	static constexpr size_t n = 101; // grid points per refinement
+
+	CLE out;
+
+	if (this->con.empty() || this->dis.empty())
+	{
+		return out;
+	}
+
+	this->qc_tmrca();
+
+
+	// bracket and refine on log time axis, until bracket is narrower than one generation
+
+	const decimal_t limit = decimal_one / this->ne;
+
+	decimal_t lower = static_cast<decimal_t>(0.01) / this->ne;
+	decimal_t upper = static_cast<decimal_t>(1e8)  / this->ne;
+	decimal_t mode  = decimal_nil;
+
+	decimal_vector_t times(n), cp(n);
+
+	while (!(upper - lower < limit))
+	{
+		const decimal_t from = std::log(lower);
+		const decimal_t to   = std::log(upper);
+		const decimal_t by   = (to - from) / static_cast<decimal_t>(n - 1);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			times[i] = std::exp((i == 0) ? from: ((i == n - 1) ? to: from + (static_cast<decimal_t>(i) * by)));
+		}
+
+		this->posterior(times, cp);
+
+		size_t arg = 0;
+
+		for (size_t i = 1; i < n; ++i)
+		{
+			if (cp[arg] < cp[i])
+				arg = i;
+		}
+
+		lower = times[ (arg < 2) ? 0: arg - 2 ];
+		upper = times[ std::min(n - 1, arg + 2) ];
+		mode  = times[ arg ];
+	}
+
+	out.n_shared = this->con.size();
+	out.n_others = this->dis.size();
+
+	out.mode = mode;
+	out.good = true;
+
+	return out;
+}
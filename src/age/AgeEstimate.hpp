@@ -5,6 +5,10 @@
 #ifndef AgeEstimate_hpp
 #define AgeEstimate_hpp
 
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "Approx.h"
 #include "Decimal.h"
 
@@ -34,10 +38,24 @@ namespace Age
 		
 	private:
 		
+		// log sums of included CCFs at given times
+		void evaluate(const decimal_vector_t &, const decimal_vector_t &, decimal_vector_t &);
+		
+		// adaptive time grid, returns false if mode is at boundary
+		bool adaptive(decimal_vector_t &, decimal_vector_t &);
+		
+		// summary statistics of log sums over time grid
+		static void summarise(const decimal_vector_t &, const decimal_vector_t &, CLE &);
+		
+		
 		const Gen::Marker::Key focal;
 		const Param::Data      param;
+		const bool             adapt; // closed-form CCFs retained for adaptive time grid
 		
 		decimal_vector_t logsum;
+		decimal_vector_t buffer; // evaluated closed-form CCF
+		
+		std::vector< std::pair< CCF, bool > > closed; // retained CCFs, sharing
 		
 		size_t shared;
 		size_t others;
@@ -45,6 +63,44 @@ namespace Age
 		decimal_t lower;
 		decimal_t upper;
 	};
+	
+	
+	// Composite posterior estimate from closed-form pairwise CCFs (as in estimate.R)
+	class Composite
+	{
+	public:
+		
+		// construct
+		Composite(const Param::Data, const Gen::Marker::Key &);
+		
+		// include density result, duplicate pairs are ignored
+		bool include(const CCF &, const bool, const Gamete::Pair &);
+		
+		// return mode of composite posterior
+		CLE estimate();
+		
+		
+	private:
+		
+		using Gamma = std::pair< size_t, decimal_t >; // shape, rate
+		
+		// reject pairs with inconsistent TMRCA
+		void qc_tmrca();
+		
+		// log composite posterior over time grid
+		void posterior(const decimal_vector_t &, decimal_vector_t &) const;
+		
+		
+		const Gen::Marker::Key focal;
+		const Param::Data      param;
+		
+		const decimal_t ne; // time scale, 2Ne generations
+		
+		std::set< std::pair< Gamete::Pair, bool > > unique;
+		
+		std::vector< Gamma > con; // concordant pairs
+		std::vector< Gamma > dis; // discordant pairs
+	};
 }
 
 
@@ -3,6 +3,11 @@
 //
 
 #include "AgeInfer.hpp"
+#include "AgeSegments.hpp"
+#include "AgeSweep.hpp"
+
+#include "Hash.h"
+#include "Metrics.hpp"
 
 
 using namespace Gen;
@@ -21,7 +26,11 @@ Pair::Pair(const Gamete::Pair _pair, const bool _sharing)
 , segment(0, 0)
 , segdiff(-1, -1)
 , done(false)
-{}
+, detected(false)
+, held(Memory::CCF)
+{
+	this->held.set(sizeof(Pair));
+}
 
 
 // print to file
@@ -45,7 +54,7 @@ void Pair::print_header(std::ostream & stream, const Param::Data param, const bo
 		stream << " SampleID0 Chr0 SampleID1 Chr1 Shared Pass SegmentLHS SegmentRHS Shape Rate";
 	}
 
-	stream << std::endl;
+	stream << '\n';
 }
 
 void Pair::print(std::ostream & stream, const Param::Data param, const bool full) const
@@ -75,9 +84,11 @@ void Pair::print(std::ostream & stream, const Param::Data param, const bool full
 
 		if (full)
 		{
-			decimal_vector_t::const_iterator est, end = this->ccf[c].d.cend();
+			const decimal_vector_t d = Density::expand(this->ccf[c], this->sharing, param);
+
+			decimal_vector_t::const_iterator est, end = d.cend();
 
-			for (est = this->ccf[c].d.cbegin(); est != end; ++est)
+			for (est = d.cbegin(); est != end; ++est)
 			{
 				stream << ' ' << std::fixed << std::setprecision(8) << *est;
 			}
@@ -128,7 +139,7 @@ void Pair::print(std::ostream & stream, const Param::Data param, const bool full
 //			stream << std::fixed << std::setprecision(8) << this->ccf[c].q75 << ' ';
 		}
 
-		stream << std::endl;
+		stream << '\n';
 	}
 }
 
@@ -142,10 +153,10 @@ void Pair::print(std::ostream & stream, const Param::Data param, const bool full
 
 // construct
 
-Near::Rank::Rank(const Gamete::Pair & pair_, const size_t dist_)
+Near::Rank::Rank(const Gamete::Pair & pair_, const size_t dist_, const size_t rand_)
 : pair(pair_)
 , dist(dist_)
-, rand(random_number())
+, rand(rand_)
 {}
 
 Near::Rank::Rank(const Near::Rank & other)
@@ -207,6 +218,11 @@ Near::Chunk::Chunk(const Marker::Key & focus, const Gamete & chromo, const hap_v
 }
 
 
+Near::Chunk::Chunk(const Gamete & chromo)
+: chr(chromo)
+{}
+
+
 // get Hamming distance
 
 size_t Near::Chunk::dist(const Near::Chunk & other) const ////////////////////////////////
@@ -241,8 +257,13 @@ size_t Near::Chunk::dist(const Near::Chunk & other) const //////////////////////
 // construct
 
 Near::Near(const size_t & fk, const Marker::Key & focus, const Grid::Data grid, const Param::Data param)
-: pool(param->threads, &Hold::run)
+: held(Memory::NEAR_RANK)
+, window(nullptr)
+, random(focus.value)
+, pool(param->threads, &Hold::run)
 {
+	Metrics::Scope scope(Metrics::NEAR);
+
 	this->ins.reserve(fk);
 	this->out.reserve(param->Nh - fk);
 
@@ -287,6 +308,47 @@ Near::Near(const size_t & fk, const Marker::Key & focus, const Grid::Data grid,
 	this->pool.open();
 	this->pool.exec();
 	this->pool.wait();
+
+
+	// restore sample order, independent of thread scheduling
+
+	auto by_chr = [](const Chunk & a, const Chunk & b) { return a.chr < b.chr; };
+
+	std::sort(this->ins.begin(), this->ins.end(), by_chr);
+	std::sort(this->out.begin(), this->out.end(), by_chr);
+
+	this->account();
+}
+
+Near::Near(const size_t & fk, const Marker::Key & focus, const Window & source, const Param::Data param)
+: held(Memory::NEAR_RANK)
+, window(&source)
+, random(focus.value)
+, pool(param->threads, &Hold::run)
+{
+	Metrics::Scope scope(Metrics::NEAR);
+
+	this->ins.reserve(fk);
+	this->out.reserve(param->Nh - fk);
+
+	for (size_t i = 0; i < param->Ng; ++i) // in sample order
+	{
+		Gamete chr_mat(i, MATERNAL);
+		Gamete chr_pat(i, PATERNAL);
+
+		const hap_t hap_mat = source.focal(chr_mat);
+		const hap_t hap_pat = source.focal(chr_pat);
+
+		if      (is_haplotype<H1>(hap_mat))
+			this->ins.push_back( Chunk(chr_mat) );
+		else if (is_haplotype<H0>(hap_mat))
+			this->out.push_back( Chunk(chr_mat) );
+
+		if      (is_haplotype<H1>(hap_pat))
+			this->ins.push_back( Chunk(chr_pat) );
+		else if (is_haplotype<H0>(hap_pat))
+			this->out.push_back( Chunk(chr_pat) );
+	}
 }
 
 
@@ -335,6 +397,8 @@ void Near::Hold::run()
 
 bool Near::pairwise(const Param::Data param)
 {
+	Metrics::Scope scope(Metrics::NEAR);
+
 	size_t n_ins = this->ins.size();
 	size_t n_out = this->out.size();
 
@@ -351,7 +415,7 @@ bool Near::pairwise(const Param::Data param)
 	{
 		for (c1 = std::next(c0); c1 != c1_end; ++c1)
 		{
-			this->concord.push_back(Rank(std::make_pair(c0->chr, c1->chr), 0)); // to have random sorting
+			this->concord.push_back(Rank(std::make_pair(c0->chr, c1->chr), 0, this->random())); // to have random sorting
 			//this->concord.push_back(Rank(std::make_pair(c0->chr, c1->chr), c0->dist(*c1)));
 		}
 	}
@@ -366,11 +430,16 @@ bool Near::pairwise(const Param::Data param)
 	{
 		for (d1 = this->out.cbegin(); d1 != d1_end; ++d1)
 		{
-			this->discord.push_back(Rank(std::make_pair(d0->chr, d1->chr), d0->dist(*d1)));
+			const size_t dist = (this->window) ? this->window->dist(d0->chr, d1->chr): d0->dist(*d1);
+
+			this->discord.push_back(Rank(std::make_pair(d0->chr, d1->chr), dist, this->random()));
 		}
 	}
 
 
+	this->account(); // largest before diversification
+
+
 	// initial sorting
 
 	this->concord.sort(); // randomly sorted
@@ -460,10 +529,30 @@ bool Near::pairwise(const Param::Data param)
 //		this->concord.swap(con);
 	}
 
+	this->account();
+
 	return true;
 }
 
 
+// update tracked size of chunks and rank lists
+
+void Near::account()
+{
+	size_t bytes = (this->ins.capacity() + this->out.capacity()) * sizeof(Chunk);
+
+	for (const Chunk & chunk : this->ins)
+		bytes += (chunk.lhs.capacity() + chunk.rhs.capacity()) * sizeof(hap_t);
+
+	for (const Chunk & chunk : this->out)
+		bytes += (chunk.lhs.capacity() + chunk.rhs.capacity()) * sizeof(hap_t);
+
+	bytes += (this->concord.size() + this->discord.size()) * (sizeof(Rank) + 2 * sizeof(void *)); // list nodes
+
+	this->held.set(bytes);
+}
+
+
 // apply filter to pairs
 
 // bool Near::filter(const Param::Data param)
@@ -558,9 +647,9 @@ bool Near::pairwise(const Param::Data param)
 
 // construct
 
-SortNode::SortNode(const decimal_t & _node, const Pair::List::iterator & _pair)
+SortNode::SortNode(const decimal_t & _node, const Pair::List::iterator & _pair, const size_t _rand)
 : node(_node)
-, rand(random_number())
+, rand(_rand)
 , pair(_pair)
 {}
 
@@ -582,28 +671,30 @@ bool SortNode::operator > (const SortNode & other) const
 
 // construct
 
-Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Vector & _share, const Grid::Data grid, const Param::Data param)
+Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Vector & _share, const Grid::Data grid, const Param::Data param, const Window * window)
 : fk(_fk)
 , focus(_focus)
 , share(_share)
 , freq(nullptr)
 , done(false)
+, completed(0)
+, settled(0)
 {
 	if (param->apply_nearest_neighb)
 	{
 		try
 		{
-			Near select(this->fk, this->focus, grid, param);
+			std::unique_ptr< Near > select((window) ? new Near(this->fk, this->focus, *window, param): new Near(this->fk, this->focus, grid, param));
 
-			if (select.pairwise(param))
+			if (select->pairwise(param))
 			{
 				size_t c_lim = 0;
 				size_t d_lim = 0;
 
-				Near::Rank::List::const_iterator c, c_end = select.concord.cend();
-				Near::Rank::List::const_iterator d, d_end = select.discord.cend();
+				Near::Rank::List::const_iterator c, c_end = select->concord.cend();
+				Near::Rank::List::const_iterator d, d_end = select->discord.cend();
 
-				for (c = select.concord.cbegin(); c != c_end; ++c)
+				for (c = select->concord.cbegin(); c != c_end; ++c)
 				{
 					this->list.push_back(std::make_shared< Pair >(c->pair, true));
 
@@ -611,7 +702,7 @@ Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Ve
 						break;
 				}
 
-				for (d = select.discord.cbegin(); d != d_end; ++d)
+				for (d = select->discord.cbegin(); d != d_end; ++d)
 				{
 					this->list.push_back(std::make_shared< Pair >(d->pair, false));
 
@@ -636,6 +727,8 @@ Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Ve
 		const size_t n_outgrp = std::min(param->outgroup_size, n_others * n_shared);
 		const std::unordered_set< size_t > sharer_set(this->share.cbegin(), this->share.cend());
 
+		random_stream random(this->focus.value); // keyed by focal site
+
 		size_t n_paired = 0;
 
 
@@ -666,7 +759,7 @@ Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Ve
 		{
 			Pair::List sub_list;
 
-			random_vector_t sub_select = random_vector(param->limit_sharers, n_paired, true, true);
+			random_vector_t sub_select = random_vector(random, param->limit_sharers, n_paired, true, true);
 
 			random_vector_t::const_iterator it, ti = sub_select.cend();
 
@@ -688,13 +781,13 @@ Site::Site(const size_t & _fk, const Marker::Key & _focus, const Sample::Key::Ve
 
 		while (unique.size() < n_outgrp)
 		{
-			const size_t sharer = this->share.at(random_number(n_shared)).value;
+			const size_t sharer = this->share.at(random_number(random, n_shared)).value;
 
-			size_t other = random_number(n_sample);
+			size_t other = random_number(random, n_sample);
 
 			while (sharer_set.count(other) != 0)
 			{
-				other = random_number(n_sample);
+				other = random_number(random, n_sample);
 			}
 
 			unique.emplace(sharer, other);
@@ -726,6 +819,8 @@ Site::Site(const Gen::Marker::Key & site, const IBD::SIM::Result::Data simres)
 , share(0)
 , freq(nullptr)
 , done(false)
+, completed(0)
+, settled(0)
 {
 	IBD::SIM::Truth::Vector const & index = simres->get(site.value);
 	IBD::SIM::Truth::Vector::const_iterator it, ti = index.cend();
@@ -749,6 +844,20 @@ Site::Site(const Gen::Marker::Key & site, const IBD::SIM::Result::Data simres)
 }
 
 
+// construct from given pairs, restored from segment store or copied for parameter sweep
+
+Site::Site(const size_t & _fk, const Gen::Marker::Key & _focus, Pair::List && pairs)
+: fk(_fk)
+, focus(_focus)
+, share(0)
+, freq(nullptr)
+, list(std::move(pairs))
+, done(false)
+, completed(0)
+, settled(0)
+{}
+
+
 // calculate allele frequencies
 
 void Site::frequency(const Grid::Data grid)
@@ -762,6 +871,16 @@ void Site::frequency(const Grid::Data grid)
 }
 
 
+// mark pair as completed, returns true for last pair
+
+bool Site::release()
+{
+	std::lock_guard<std::mutex> lock(this->guard);
+	
+	return (++this->completed == this->list.size());
+}
+
+
 // estimate age
 
 void Site::estimate(const Param::Data param)
@@ -785,13 +904,26 @@ void Site::estimate(const Param::Data param)
 
 	this->done = true;
 
-
-	// raw estimate
-
 	for (int c = 0; c < n_clocks; ++c)
 	{
-		const ClockType clock = static_cast<ClockType>(c);
+		this->estimate(static_cast<ClockType>(c), param);
+	}
+
+	this->settled = n_clocks;
+}
+
+
+// estimate age for single clock, all pairs completed
+
+void Site::estimate(const ClockType clock, const Param::Data param)
+{
+	Metrics::Scope scope(Metrics::SITE_ESTIMATE);
+
+	Pair::List::const_iterator it, ti = this->list.cend();
 
+
+	// raw estimate
+	{
 		Estimate age(param, this->focus);
 
 		size_t count = 0;
@@ -812,11 +944,7 @@ void Site::estimate(const Param::Data param)
 
 
 	// adjusted estimate
-
-	for (int c = 0; c < n_clocks; ++c)
 	{
-		const ClockType clock = static_cast<ClockType>(c);
-
 		//
 		this->filter(clock, param); // filter pairs
 		//
@@ -838,6 +966,35 @@ void Site::estimate(const Param::Data param)
 			this->adj[clock] = age.estimate();
 		}
 	}
+
+
+	// composite posterior estimate
+	if (param->run_composite)
+	{
+		Composite age(param, this->focus);
+
+		for (it = this->list.cbegin(); it != ti; ++it)
+		{
+			age.include((*it)->ccf[clock], (*it)->sharing, (*it)->pair);
+		}
+
+		this->com[clock] = age.estimate();
+	}
+}
+
+
+// mark clock as estimated, returns true for last clock
+
+bool Site::settle()
+{
+	std::lock_guard<std::mutex> lock(this->guard);
+
+	if (++this->settled == n_clocks)
+	{
+		this->done = true;
+	}
+
+	return this->done;
 }
 
 
@@ -856,47 +1013,48 @@ void Site::filter(const ClockType clock, const Param::Data param)
 	Pair::List::iterator it, ti = this->list.end();
 
 
-	// count pairs
+	// collect medians of CCF
+
+	decimal_vector_t qcon, qdis;
 
 	for (it = this->list.begin(); it != ti; ++it)
 	{
 		if ((*it)->ccf[clock].good)
 		{
 			if ((*it)->sharing)
-				++ncon;
+				qcon.push_back((*it)->ccf[clock].q50);
 			else
-				++ndis;
+				qdis.push_back((*it)->ccf[clock].q50);
 		}
 	}
 
+	ncon = qcon.size();
+	ndis = qdis.size();
+
+	std::sort(qcon.begin(), qcon.end());
+	std::sort(qdis.begin(), qdis.end());
+
 
-	// fill exclusion list
+	// fill exclusion list, single sweep over ascending time grid
+
+	size_t icon = 0; // concordant medians <= time
+	size_t idis = 0; // discordant medians <  time
 
 	for (size_t i = 0; i < n_times; ++i)
 	{
 		MinExclude & x = minx[i];
 
 		x.time = param->prior.at(i);
-		x.ncon = 0;
-		x.ndis = 0;
 		x.wsum = decimal_nil;
 
-		for (it = this->list.begin(); it != ti; ++it)
-		{
-			if (!(*it)->ccf[clock].good)
-				continue;
+		while (icon < ncon && !(qcon[icon] > x.time))
+			++icon;
 
-			if ((*it)->sharing)
-			{
-				if ((*it)->ccf[clock].q50 > x.time) // median of CCF
-					++x.ncon;
-			}
-			else
-			{
-				if ((*it)->ccf[clock].q50 < x.time) // median of CCF
-					++x.ndis;
-			}
-		}
+		while (idis < ndis && qdis[idis] < x.time)
+			++idis;
+
+		x.ncon = ncon - icon;
+		x.ndis = idis;
 
 		x.wsum += static_cast<decimal_t>(x.ncon) / static_cast<decimal_t>(ncon);
 		x.wsum += static_cast<decimal_t>(x.ndis) / static_cast<decimal_t>(ndis);
@@ -925,6 +1083,8 @@ void Site::filter(const ClockType clock, const Param::Data param)
 
 	const decimal_t cutoff = minx[arg].time;
 
+	random_stream random(this->focus.value, clock); // keyed by focal site and clock
+
 	SortNode::List tcon, tdis;
 
 	for (it = this->list.begin(); it != ti; ++it)
@@ -935,12 +1095,12 @@ void Site::filter(const ClockType clock, const Param::Data param)
 		if ((*it)->sharing)
 		{
 			if ((*it)->ccf[clock].q50 > cutoff) // median of CCF
-				tcon.push_back( SortNode((*it)->ccf[clock].q50, it) );
+				tcon.push_back( SortNode((*it)->ccf[clock].q50, it, random()) );
 		}
 		else
 		{
 			if ((*it)->ccf[clock].q50 < cutoff) // median of CCF
-				tdis.push_back( SortNode((*it)->ccf[clock].q50, it) );
+				tdis.push_back( SortNode((*it)->ccf[clock].q50, it, random()) );
 		}
 	}
 
@@ -1118,7 +1278,7 @@ void Site::print_header(std::ostream & stream, const Param::Data param, const bo
 		stream << " N_Concordant N_Discordant PostMean PostMode PostMedian";
 	}
 
-	stream << std::endl;
+	stream << '\n';
 }
 
 void Site::print(std::ostream & stream, const size_t & ne, const bool density, const bool print_adj) const
@@ -1171,7 +1331,39 @@ void Site::print(std::ostream & stream, const size_t & ne, const bool density, c
 //			stream << std::fixed << std::setprecision(8) << out.upper;
 		}
 
-		stream << std::endl;
+		stream << '\n';
+	}
+}
+
+void Site::print_composite(std::ostream & stream, const size_t & ne) const
+{
+	if (!this->done)
+		throw std::runtime_error("Invalid site result");
+
+	for (int c = 0; c < n_clocks; ++c)
+	{
+		CLE const & out = this->com[c];
+
+		if (!out.good)
+			continue;
+
+		stream << this->focus.value << ' '; // marker id
+
+		// clock
+		if (c == 0) stream << "M ";
+		if (c == 1) stream << "R ";
+		if (c == 2) stream << "J ";
+
+		stream << "2 "; // composite posterior
+
+		stream << out.n_shared << ' ';
+		stream << out.n_others << ' ';
+
+		stream << "NA ";
+		stream << std::fixed << std::setprecision(8) << out.mode * decimal_two * static_cast<decimal_t>(ne) << ' ';
+		stream << "NA";
+
+		stream << '\n';
 	}
 }
 
@@ -1198,10 +1390,9 @@ Queue::Hold::Hold(const Gen::Marker::Key & _site)
 
 // construct
 
-Queue::Queue(const Share::Data share, const size_t _limit, const Grid::Data _source, const Param::Data _param, const IBD::SIM::Result::Data simres, const bool random_order)
+Queue::Queue(const Share::Data share, const Grid::Data _source, const Param::Data _param, const IBD::SIM::Result::Data simres, const bool random_order)
 : source(_source)
 , param(_param)
-, limit(_limit)
 , total(0)
 {
 	// construct for simulated results
@@ -1221,6 +1412,24 @@ Queue::Queue(const Share::Data share, const size_t _limit, const Grid::Data _sou
 	}
 
 
+	// sweep over all variants in position order
+	if (this->param->all_variants)
+	{
+		Marker::Key::Vector target;
+
+		target.reserve(this->source->marker_size());
+
+		for (size_t i = 0; i < this->source->marker_size(); ++i)
+		{
+			target.push_back(i);
+		}
+
+		this->sweep(target);
+
+		return;
+	}
+
+
 	Share::Index::Map::const_iterator map, map_end = share->get().cend();
 
 	for (map = share->get().cbegin(); map != map_end; ++map)
@@ -1239,122 +1448,256 @@ Queue::Queue(const Share::Data share, const size_t _limit, const Grid::Data _sou
 				//this->total += std::min(this->param->outgroup_size, n_others);
 				//const size_t n_sharer = std::min((n * (n - 1)) / 2, this->param->limit_sharers);
 
-				this->total += std::min((n * (n - 1)) / 2, this->param->limit_sharers);
-				this->total += std::min(param->outgroup_size, (this->param->Ng - n) * n);
-
 				// hold in queue
 				this->queue.emplace_back(fk, idx->first, idx->second);
 			}
 		}
 	}
 
+	this->shard();
+
 	if (random_order)
 	{
-		std::shuffle(this->queue.begin(), this->queue.end(), random_generator);
+		std::shuffle(this->queue.begin(), this->queue.end(), random_generator());
 	}
 }
 
 
-// next batch
+Queue::Queue(const Grid::Data _source, const Param::Data _param, const Marker::Key::Vector & target)
+: source(_source)
+, param(_param)
+, total(0)
+{
+	this->sweep(target);
+}
 
-size_t Queue::next(const IBD::SIM::Result::Data simres)
+Queue::Queue(const SegmentStore::Data _store, const Grid::Data _source, const Param::Data _param)
+: source(_source)
+, param(_param)
+, total(0)
+, store(_store)
 {
-	size_t pair_count = 0;
+	if (this->param->use_post_prob)
+		throw std::invalid_argument("Posterior probabilities are not kept in segment store");
+
+	SegmentStore::Index::const_iterator it, ti = this->store->index().cend();
 
+	for (it = this->store->index().cbegin(); it != ti; ++it)
+	{
+		// hold in queue
+		this->queue.emplace_back(it->fk, it->site, Sample::Key::Vector());
+	}
+
+	this->shard();
+}
 
-	// clean current batch
 
-	if (!this->pairs.empty())
+// hold target sites in position order, sharers determined on the fly
+
+void Queue::sweep(const Marker::Key::Vector & target)
+{
+	Marker::Key::Vector sorted(target);
+
+	std::sort(sorted.begin(), sorted.end());
+
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+	Marker::Key::Vector::const_iterator it, ti = sorted.cend();
+
+	for (it = sorted.cbegin(); it != ti; ++it)
 	{
-		Pair::List::iterator pair = this->pairs.begin();
-		Pair::List::iterator pair_end = this->pairs.end();
+		const size_t n = this->source->marker(*it).hap_count[H1];
 
-		while (pair != pair_end)
+		if (n >= Share::minimum)
 		{
-			if ((*pair)->done)
-			{
-				pair = this->pairs.erase(pair);
-				pair_end = this->pairs.end();
-				continue;
-			}
-
-			++pair;
-			++pair_count;
+			// hold in queue
+			this->queue.emplace_back(n, *it, Sample::Key::Vector());
 		}
 	}
 
-	if (!this->sites.empty())
+	this->window = std::make_shared< Window >(this->source, this->param);
+
+	this->shard();
+}
+
+
+// keep target sites of this shard, assigned by expected number of pairs
+
+void Queue::shard()
+{
+	const size_t n_shards = std::max(this->param->shard_count, size_t(1));
+
+	std::vector< size_t > weight(this->queue.size());
+	std::vector< size_t > order(this->queue.size());
+
+	for (size_t i = 0; i < this->queue.size(); ++i)
+	{
+		weight[i] = this->expect(this->queue[i]);
+		order[i]  = i;
+	}
+
+
+	// largest sites first, each to the shard of least expected pairs; independent of order of target sites
+
+	std::sort(order.begin(), order.end(), [this, &weight](const size_t a, const size_t b)
+	{
+		if (weight[a] != weight[b])
+			return (weight[a] > weight[b]);
+
+		return (this->queue[a].site.value < this->queue[b].site.value);
+	});
+
+	std::vector< size_t > load(n_shards, 0);
+	std::vector< bool >   keep(this->queue.size(), false);
+
+	for (const size_t i : order)
 	{
-		Site::List::iterator site = this->sites.begin();
-		Site::List::iterator site_end = this->sites.end();
+		const size_t s = std::distance(load.begin(), std::min_element(load.begin(), load.end()));
+
+		load[s] += weight[i];
+		keep[i]  = (s == this->param->shard_index);
+	}
+
 
-		while (site != site_end)
+	// retain order of queue
+
+	Hold::List held;
+
+	this->total = 0;
+
+	for (size_t i = 0; i < this->queue.size(); ++i)
+	{
+		if (keep[i])
 		{
-			if ((*site)->done)
-			{
-				site = this->sites.erase(site);
-				site_end = this->sites.end();
-				continue;
-			}
+			this->total += weight[i];
 
-			++site;
+			held.push_back(std::move(this->queue[i]));
 		}
 	}
 
+	this->queue.swap(held);
+}
+
 
-	// append to batch
+// expected number of pairs of target site, as counted on construction
+
+size_t Queue::expect(const Hold & q) const
+{
+	if (this->store)
+		return this->store->count(q.site);
 
+	const size_t n  = (this->window) ? q.fk: q.share.size();
+	const size_t nn = (this->window) ? this->param->Nh: this->param->Ng;
+
+	return std::min((n * (n - 1)) / 2, this->param->limit_sharers) + std::min(this->param->outgroup_size, (nn - n) * n);
+}
+
+
+// next site
+
+Site::Data Queue::next(const IBD::SIM::Result::Data simres)
+{
 	while (!this->queue.empty())
 	{
 		Hold & q = this->queue.front();
-
+		
 		Site::Data site;
-
+		
 		if (simres)
 		{
 			site = std::make_shared< Site >(q.site, simres); // fetch site
 		}
+		else if (this->store)
+		{
+			site = this->store->load(q.site); // restore site
+		}
+		else if (this->window)
+		{
+			this->window->move(q.site); // advance sliding window
+			
+			site = std::make_shared< Site >(q.fk, q.site, this->window->share(), this->source, this->param, this->window.get()); // make site
+		}
 		else
 		{
 			site = std::make_shared< Site >(q.fk, q.site, q.share, this->source, this->param); // make site
 		}
-
+		
+		this->queue.pop_front(); // remove in queue
+		
 		if (!site->done)
 		{
-			// copy site pairs into batch
-
 			Pair::List::const_iterator pair, pair_end = site->list.cend();
-
+			
 			for (pair = site->list.cbegin(); pair != pair_end; ++pair)
 			{
 				(*pair)->site = site; // activate site pointer !!!
+			}
+			
+			return site;
+		}
+	}
+	
+	return nullptr;
+}
 
-				this->pairs.push_back(*pair);
 
-				++pair_count;
-			}
+// total number of pairs
 
-			this->sites.push_back(site); // copy site into batch
-		}
+size_t Queue::size() const
+{
+	return this->total;
+}
 
-		this->queue.pop_front(); // remove in queue
 
-		if (pair_count > this->limit)
+// remove target sites completed before, returns number of sites removed
+
+size_t Queue::skip(const std::unordered_set< size_t > & done)
+{
+	if (done.empty())
+		return 0;
+
+	Hold::List keep;
+
+	size_t removed = 0;
+
+	Hold::List::iterator q, q_end = this->queue.end();
+
+	for (q = this->queue.begin(); q != q_end; ++q)
+	{
+		if (done.count(q->site.value) == 0)
 		{
-			break;
+			keep.push_back(std::move(*q));
+			continue;
 		}
+
+		this->total -= std::min(this->total, this->expect(*q));
+
+		++removed;
 	}
 
+	this->queue.swap(keep);
 
-	return pair_count;
+	return removed;
 }
 
 
-// total number of pairs
+// fingerprint of target sites in queue
 
-size_t Queue::size() const
+uint64_t Queue::fingerprint() const
 {
-	return this->total;
+	Hash hash;
+
+	hash.add(uint64_t(this->queue.size()));
+
+	Hold::List::const_iterator q, q_end = this->queue.cend();
+
+	for (q = this->queue.cbegin(); q != q_end; ++q)
+	{
+		hash.add(uint64_t(q->fk));
+		hash.add(uint64_t(q->site.value));
+	}
+
+	return hash.value;
 }
 
 
@@ -1363,15 +1706,16 @@ size_t Queue::size() const
 
 // construct
 
-Infer::Infer(const Param::Data para, const DetectMethod detectmethod, const decimal_t max_miss, const Pair::Data target_pair, const Grid::Data grid, const HMM::Model::Data hmm_model)
+Infer::Infer(const Param::Data para, const DetectMethod detectmethod, const decimal_t max_miss, const Pair::Data target_pair, const Grid::Data grid, const HMM::Model::Data hmm_model, const Sweep::Data parameter_sweep)
 : param(para)
 , method(detectmethod)
 , target(target_pair)
 , source(grid)
 , model(hmm_model)
 , max_missing_rate(max_miss)
+, sweep(parameter_sweep)
 {
-	if (this->method == DETECT_HMM && !this->model)
+	if (this->method == DETECT_HMM && !this->model && !this->target->done) // restored pairs are completed
 	{
 		throw std::invalid_argument("HMM requires a model");
 	}
@@ -1391,6 +1735,19 @@ void Infer::run()
 	
 	Site::Data site_ptr = this->target->site.lock();
 	
+	Metrics::count(Metrics::PAIRS);
+	
+	
+	// restored from segment store, estimation only
+	
+	if (this->target->done)
+	{
+		if (this->target->detected)
+			this->estimate(site_ptr);
+		
+		return;
+	}
+	
 	
 	// get data
 	
@@ -1399,6 +1756,13 @@ void Infer::run()
 	
 	this->target->done = true;
 	
+	Pair::List::iterator other, other_end = this->target->sweep.end();
+	
+	for (other = this->target->sweep.begin(); other != other_end; ++other)
+	{
+		(*other)->done = true;
+	}
+	
 	
 	// check genotypes
 	
@@ -1407,6 +1771,19 @@ void Infer::run()
 		return;
 	}
 	
+	
+	// check missing rate near focal site
+	
+	const size_t range_begin = (site_ptr->focus.value > this->param->nearest_range) ? site_ptr->focus.value - this->param->nearest_range: 0;
+	const size_t range_end   = std::min(site_ptr->focus.value + this->param->nearest_range + 1, a->size());
+	
+	this->target->missing = missing_rate(*a, *b, range_begin, range_end);
+	
+	if (this->target->missing > this->max_missing_rate)
+	{
+		return;
+	}
+	
 	//	if (this->target->sharing)
 	//	{
 	//		if (!is_genotype<G1>(b->gen(site_ptr->focus)))
@@ -1423,11 +1800,13 @@ void Infer::run()
 	
 	//	if (this->param->use_mut_clock || this->method == IBD::DETECT_FGT)
 	//	{
-	this->target->pair.first.chromosome = this->chr_share(a->at(site_ptr->focus));
+	random_stream random(site_ptr->focus.value, this->target->pair.first.individual.value, this->target->pair.second.individual.value, this->target->sharing); // keyed by site and pair
+	
+	this->target->pair.first.chromosome = this->chr_share(a->at(site_ptr->focus), random);
 	
 	this->target->pair.second.chromosome = (this->target->sharing) ?
-	this->chr_share(b->at(site_ptr->focus)):
-	this->chr_other(b->at(site_ptr->focus));
+	this->chr_share(b->at(site_ptr->focus), random):
+	this->chr_other(b->at(site_ptr->focus), random);
 	
 	if (this->target->pair.first.chromosome  == CHR_VOID ||
 		this->target->pair.second.chromosome == CHR_VOID)
@@ -1464,15 +1843,13 @@ void Infer::run()
 	}
 	
 	
-	// calculate missing rate
-	
-	this->target->missing = missing_rate(a->gen(), b->gen(), a->size());
-	
-	
 	// detect segment
 	
 	this->hmm(site_ptr, ha, hb);
 	
+	if (this->sweep)
+		this->siblings(site_ptr, ha, hb);
+	
 	//	if (this->target->missing < this->max_missing_rate)
 	//	{
 	//		switch (this->method)
@@ -1489,7 +1866,7 @@ void Infer::run()
 
 // determine chromosomes
 
-ChrType Infer::chr_share(Variant && var)
+ChrType Infer::chr_share(Variant && var, random_stream & random)
 {
 	if (var.is_phased())
 	{
@@ -1508,7 +1885,7 @@ ChrType Infer::chr_share(Variant && var)
 
 		if (is_haplotype<H1>(pat) && is_haplotype<H1>(mat))
 		{
-			return (random_coin()) ? MATERNAL: PATERNAL;
+			return (random_coin(random)) ? MATERNAL: PATERNAL;
 		}
 
 		return CHR_VOID;
@@ -1517,7 +1894,7 @@ ChrType Infer::chr_share(Variant && var)
 	return UNPHASED;
 }
 
-ChrType Infer::chr_other(Variant && var)
+ChrType Infer::chr_other(Variant && var, random_stream & random)
 {
 	if (var.is_phased())
 	{
@@ -1561,7 +1938,7 @@ ChrType Infer::chr_other(Variant && var)
 		}
 
 		// choose at random
-		return (random_coin()) ? MATERNAL: PATERNAL;
+		return (random_coin(random)) ? MATERNAL: PATERNAL;
 	}
 
 	return UNPHASED;
@@ -1864,29 +2241,93 @@ void Infer::hmm(const Site::Data site, const hap_vector_t a, const hap_vector_t
 	//	else
 	this->target->segment = algorithm.detect(site->fk, site->focus);
 
+	this->target->detected = true;
 
-	// age estimation
 
-	Density age(this->param, this->target->sharing, site->focus, this->target->segment);
+	// segment differences
 
-	
 	if (this->param->use_tree_consistency && this->target->sharing)
 		this->approx_segdiff(site, a, b);
 	else
 		this->detect_segdiff(site, a, b);
 
-	
+
+	// age estimation
+
+	this->estimate(site, &algorithm);
+}
+
+
+// estimate CCFs from detected segment, optionally including posterior probabilities
+
+void Infer::estimate(const Site::Data site, HMM::Algorithm * algorithm)
+{
+	Density age(this->param, this->target->sharing, site->focus, this->target->segment);
+
 	age.differences(this->target->segdiff);
-	
 
-	if (this->param->use_post_prob)
+	if (this->param->use_post_prob && algorithm)
 	{
-		age.probability(algorithm.posterior(LHS, HMM::NON_STATE, true), algorithm.posterior(RHS, HMM::NON_STATE, true));
+		age.probability(algorithm->posterior(LHS, HMM::NON_STATE, true), algorithm->posterior(RHS, HMM::NON_STATE, true));
 	}
 
 	if (this->param->run_mut_clock) this->target->ccf[MUT_CLOCK] = age.estimate(MUT_CLOCK);
 	if (this->param->run_rec_clock) this->target->ccf[REC_CLOCK] = age.estimate(REC_CLOCK);
 	if (this->param->run_cmb_clock) this->target->ccf[CMB_CLOCK] = age.estimate(CMB_CLOCK);
+
+	size_t bytes = sizeof(Pair);
+
+	for (int c = 0; c < n_clocks; ++c)
+	{
+		bytes += this->target->ccf[c].d.capacity() * sizeof(decimal_t);
+	}
+
+	this->target->held.set(bytes);
+}
+
+// same pair under further combinations of parameter sweep, detection shared by equal effective size
+
+void Infer::siblings(const Site::Data site, const hap_vector_t a, const hap_vector_t b)
+{
+	std::vector< std::pair< HMM::Model::Data, Pair::Data > > detected(1, std::make_pair(this->model, this->target));
+
+	for (size_t k = 0; k < this->target->sweep.size(); ++k)
+	{
+		Sweep::Setting const & setting = this->sweep->at(k + 1);
+
+		const Pair::Data other = this->target->sweep[k];
+
+		other->pair    = this->target->pair;
+		other->missing = this->target->missing;
+
+		Infer infer(setting.param, this->method, this->max_missing_rate, other, this->source, setting.model);
+
+
+		// segment and differences of same model, unless posterior probabilities are included
+
+		Pair::Data same = nullptr;
+
+		for (size_t i = 0; i < detected.size() && !this->param->use_post_prob; ++i)
+		{
+			if (detected[i].first == setting.model)
+				same = detected[i].second;
+		}
+
+		if (same)
+		{
+			other->segment  = same->segment;
+			other->segdiff  = same->segdiff;
+			other->detected = true;
+
+			infer.estimate(site);
+		}
+		else
+		{
+			infer.hmm(site, a, b);
+
+			detected.emplace_back(setting.model, other);
+		}
+	}
 }
 
 //void Infer::sim(const Site::Data site, const Variant::Vector::Data a, const Variant::Vector::Data b)
@@ -16,6 +16,7 @@
 #include "Random.h"
 #include "Threadpool.h"
 #include "Clock.hpp"
+#include "Memory.hpp"
 
 #include "Gen.hpp"
 #include "GenSample.hpp"
@@ -32,6 +33,7 @@
 #include "Age.hpp"
 #include "AgeDensity.hpp"
 #include "AgeEstimate.hpp"
+#include "AgeWindow.hpp"
 
 
 namespace Age
@@ -39,6 +41,9 @@ namespace Age
 	struct Pair;
 	struct Site;
 	
+	class SegmentStore;
+	class Sweep;
+	
 	
 	// Pair of individuals/chromosomes
 	struct Pair
@@ -66,6 +71,11 @@ namespace Age
 		std::array<CCF, n_clocks> ccf; // cumulative coalescent function
 		
 		bool done;
+		bool detected; // segment detected, or restored from segment store
+		
+		List sweep; // same pair under further combinations of parameter sweep
+		
+		Memory::Account held; // tracked size, including dense CCFs
 	};
 	
 	
@@ -78,7 +88,7 @@ namespace Age
 		struct Rank
 		{
 			// construct
-			Rank(const Gamete::Pair &, const size_t);
+			Rank(const Gamete::Pair &, const size_t, const size_t);
 			Rank(const Rank &);
 			Rank(Rank &&);
 			
@@ -97,6 +107,7 @@ namespace Age
 		
 		// construct
 		Near(const size_t &, const Gen::Marker::Key &, const Gen::Grid::Data, const Param::Data);
+		Near(const size_t &, const Gen::Marker::Key &, const Window &, const Param::Data); // from sliding window
 		
 		// perform all pairwise comparisons
 		bool pairwise(const Param::Data);
@@ -114,8 +125,9 @@ namespace Age
 		{
 			// construct
 			Chunk(const Gen::Marker::Key &, const Gamete &, const Gen::hap_vector_t &, const Param::Data); // ranked
+			Chunk(const Gamete &); // held in sliding window
 			
-			const Gamete      chr;
+			Gamete            chr;
 			Gen::hap_vector_t lhs;
 			Gen::hap_vector_t rhs;
 			
@@ -138,9 +150,18 @@ namespace Age
 			const Param::Data      par;
 		};
 		
+		// update tracked size of chunks and rank lists
+		void account();
+		
 		Chunk::List ins; // Haplotypes carrying the focal allele
 		Chunk::List out; // All other haplotypes
 		
+		Memory::Account held; // tracked size
+
+		const Window * window; // optional source of Hamming distances
+		
+		random_stream random; // keyed by focal site
+		
 		Threadpool< Hold > pool;
 		std::mutex         lock;
 	};
@@ -154,17 +175,27 @@ namespace Age
 		using List = std::deque< Data >;
 		
 		// construct
-		Site(const size_t &, const Gen::Marker::Key &, const Gen::Sample::Key::Vector &, const Gen::Grid::Data, const Param::Data);
+		Site(const size_t &, const Gen::Marker::Key &, const Gen::Sample::Key::Vector &, const Gen::Grid::Data, const Param::Data, const Window * = nullptr);
 		
 		// construct for simulated results
 		Site(const Gen::Marker::Key &, const IBD::SIM::Result::Data);
 		
+		// construct from given pairs, restored from segment store or copied for parameter sweep
+		Site(const size_t &, const Gen::Marker::Key &, Pair::List &&);
+		
 		
 		// calculate allele frequencies
 		void frequency(const Gen::Grid::Data);
 		
+		// mark pair as completed, returns true for last pair
+		bool release();
+		
 		// estimate age
 		void estimate(const Param::Data);
+		void estimate(const ClockType, const Param::Data); // single clock, all pairs completed
+		
+		// mark clock as estimated, returns true for last clock
+		bool settle();
 		
 		// filter pairs based on CCF summary metric
 		void filter(const ClockType, const Param::Data); // apply minimum pair exclusion threshold
@@ -172,6 +203,7 @@ namespace Age
 		// print to file
 		static void print_header(std::ostream &, const Param::Data, const bool);
 		void print(std::ostream &, const size_t &, const bool, const bool) const;
+		void print_composite(std::ostream &, const size_t &) const;
 		
 		
 		const size_t fk; // target fk
@@ -185,9 +217,15 @@ namespace Age
 		// composite likelihood estimates
 		std::array<CLE, n_clocks> raw;
 		std::array<CLE, n_clocks> adj;
+		std::array<CLE, n_clocks> com; // composite posterior mode
 		
 		bool done;
 		
+		List sweep; // same site under further combinations of parameter sweep
+		
+		size_t completed; // number of completed pairs
+		int    settled;   // number of estimated clocks
+		
 		std::mutex guard;
 	};
 	
@@ -210,7 +248,7 @@ namespace Age
 		const Pair::List::iterator pair;
 		
 		// construct
-		SortNode(const decimal_t &, const Pair::List::iterator &);
+		SortNode(const decimal_t &, const Pair::List::iterator &, const size_t);
 		
 		// sort
 		bool operator <  (const SortNode &) const;
@@ -242,27 +280,44 @@ namespace Age
 		
 		
 		// construct
-		Queue(const Gen::Share::Data, const size_t, const Gen::Grid::Data, const Param::Data, const IBD::SIM::Result::Data = nullptr, const bool = false);
+		Queue(const Gen::Share::Data, const Gen::Grid::Data, const Param::Data, const IBD::SIM::Result::Data = nullptr, const bool = false);
+		Queue(const Gen::Grid::Data, const Param::Data, const Gen::Marker::Key::Vector &); // sweep over target sites
+		Queue(const std::shared_ptr< SegmentStore >, const Gen::Grid::Data, const Param::Data); // sites of segment store
 		
-		// next batch
-		size_t next(const IBD::SIM::Result::Data = nullptr);
+		// next site, empty when queue is exhausted
+		Site::Data next(const IBD::SIM::Result::Data = nullptr);
 		
 		// total number of pairs
 		size_t size() const;
 		
+		// remove target sites completed before, returns number of sites removed
+		size_t skip(const std::unordered_set< size_t > &);
 		
-		Pair::List pairs;
-		Site::List sites;
+		// fingerprint of target sites in queue
+		uint64_t fingerprint() const;
 		
 		
 	private:
 		
+		// hold target sites in position order, sharers determined on the fly
+		void sweep(const Gen::Marker::Key::Vector &);
+		
+		// keep target sites of this shard, assigned by expected number of pairs
+		void shard();
+		
+		// expected number of pairs of target site
+		size_t expect(const Hold &) const;
+		
+		
 		const Gen::Grid::Data  source;
 		const Param::Data      param;
-		const size_t           limit;
 		
 		size_t     total;
 		Hold::List queue;
+		
+		Window::Data window; // sweep over all variants
+		
+		std::shared_ptr< SegmentStore > store; // re-estimation of stored segments
 	};
 	
 	
@@ -272,7 +327,7 @@ namespace Age
 	public:
 		
 		// constructs
-		Infer(const Param::Data, const IBD::DetectMethod, const decimal_t, const Pair::Data, const Gen::Grid::Data, const IBD::HMM::Model::Data = nullptr);
+		Infer(const Param::Data, const IBD::DetectMethod, const decimal_t, const Pair::Data, const Gen::Grid::Data, const IBD::HMM::Model::Data = nullptr, const std::shared_ptr< Sweep > = nullptr);
 		
 		// execute detection
 		void run();
@@ -281,8 +336,8 @@ namespace Age
 	private:
 		
 		// determine chromosomes
-		static Gen::ChrType chr_share(Gen::Variant &&);
-		static Gen::ChrType chr_other(Gen::Variant &&);
+		static Gen::ChrType chr_share(Gen::Variant &&, random_stream &);
+		static Gen::ChrType chr_other(Gen::Variant &&, random_stream &);
 		
 		// determine segment differences
 		void detect_segdiff(const Site::Data, const Gen::hap_vector_t, const Gen::hap_vector_t);
@@ -296,6 +351,12 @@ namespace Age
 		void hmm(const Site::Data, const Gen::hap_vector_t, const Gen::hap_vector_t);
 //		void sim(const Site::Data, const Gen::Variant::Vector::Data, const Gen::Variant::Vector::Data);
 		
+		// estimate CCFs from detected segment, optionally including posterior probabilities
+		void estimate(const Site::Data, IBD::HMM::Algorithm * = nullptr);
+		
+		// same pair under further combinations of parameter sweep, detection shared by equal effective size
+		void siblings(const Site::Data, const Gen::hap_vector_t, const Gen::hap_vector_t);
+		
 		
 		const Param::Data param; // age estimation parameters
 		const IBD::DetectMethod method; // chosen method
@@ -303,6 +364,8 @@ namespace Age
 		const Gen::Grid::Data   source; // grid data source
 		const IBD::HMM::Model::Data model; // HMM model
 		const decimal_t max_missing_rate;
+		
+		const std::shared_ptr< Sweep > sweep; // optional parameter sweep
 	};
 }
 
@@ -0,0 +1,592 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgePipeline.hpp"
+#include "AgeSweep.hpp"
+
+#include "Memory.hpp"
+#include "Metrics.hpp"
+
+
+using namespace Gen;
+using namespace IBD;
+using namespace Age;
+
+
+
+// Receiver of completed sites
+
+// report warning during estimation
+
+void Sink::warn(const std::string & warning)
+{
+	std::cerr << "Warning: " << warning << std::endl;
+}
+
+
+
+// Text output of sites and pairs
+
+// construct
+
+TextSink::TextSink(const Param::Data _param, std::ostream & _pairs, std::ostream & _sites)
+: param(_param)
+, pairs(_pairs)
+, sites(_sites)
+, pairs_distr(nullptr)
+, sites_distr(nullptr)
+{}
+
+
+// optional full distributions
+
+void TextSink::distr(std::ostream * _pairs, std::ostream * _sites)
+{
+	this->pairs_distr = _pairs;
+	this->sites_distr = _sites;
+}
+
+
+// write site and its pairs
+
+void TextSink::write(const Site::Data site)
+{
+	if (!site->done)
+		return;
+
+	site->print(this->sites, this->param->Ne, false, false); // raw
+	site->print(this->sites, this->param->Ne, false, true);  // adj
+
+	if (this->param->run_composite)
+		site->print_composite(this->sites, this->param->Ne);
+
+	if (this->sites_distr)
+	{
+		site->print(*this->sites_distr, this->param->Ne, true, false); // raw
+		site->print(*this->sites_distr, this->param->Ne, true, true);  // adj
+	}
+
+
+	// print pairs
+
+	Pair::List::const_iterator p, p_end = site->list.cend();
+
+	for (p = site->list.cbegin(); p != p_end; ++p)
+	{
+		(*p)->print(this->pairs, this->param, false);
+
+		if (this->pairs_distr)
+			(*p)->print(*this->pairs_distr, this->param, true);
+	}
+}
+
+
+
+// Streaming execution of site construction, inference, estimation and output
+
+// construct
+
+Pipeline::Pipeline(Queue & _queue, const Param::Data _param, const DetectMethod _method, const decimal_t _max_miss, const Grid::Data _grid, const HMM::Model::Data _model, const SIM::Result::Data _simres, const size_t _threads, const size_t _limit, const size_t _budget, const Sweep::Data _sweep)
+: queue(_queue)
+, param(_param)
+, method(_method)
+, max_miss(_max_miss)
+, grid(_grid)
+, model(_model)
+, simres(_simres)
+, sweep(_sweep)
+, threads(_threads)
+, limit(_limit)
+, pairs(pair_size(_param))
+, budget(_budget)
+, working(0)
+, held(0)
+, running(0)
+, warn(0)
+, overrun(false)
+, output(nullptr)
+, tasks(_limit)
+, order(_limit)
+, error(nullptr)
+{
+	if (this->param->run_composite && !this->param->use_hard_brks)
+		throw std::invalid_argument("Composite posterior requires hard breakpoints (closed-form CCF)");
+
+	// budget of sites in flight, a quarter of tracked memory limit less fixed footprint if given
+	if (this->budget == 0)
+	{
+		this->budget = (Memory::limit() > 0 && !Memory::overrun()) ? (Memory::limit() - Memory::fixed()) / 4: default_budget;
+	}
+}
+
+
+// estimated bytes held per pair until written
+
+size_t Pipeline::pair_size(const Param::Data param)
+{
+	size_t bytes = sizeof(Pair) + 2 * sizeof(Pair::Data); // pair, control block and list entry
+
+	if (!param->use_hard_brks)
+		bytes += n_clocks * param->nt * sizeof(decimal_t); // dense CCF per clock
+
+	return bytes;
+}
+
+
+// execute until queue is exhausted, returns number of warnings
+
+size_t Pipeline::run(Sink & sink, Progress * prog, Clock * time, Executor * executor)
+{
+	this->output = &sink;
+
+	if (this->threads <= 1)
+	{
+		this->serial(sink, prog, time);
+
+		return this->warn;
+	}
+
+
+	// stages on caller's executor
+
+	if (executor)
+	{
+		try
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->guard);
+				++this->running;
+			}
+
+			executor->submit([this] { this->build(); this->leave(); });
+
+			for (size_t i = 0; i < this->threads; ++i)
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->guard);
+					++this->running;
+				}
+
+				executor->submit([this, prog, time] { this->work(prog, time); this->leave(); });
+			}
+		}
+		catch (...)
+		{
+			this->fail(std::current_exception());
+			this->leave(); // last submission failed
+		}
+
+		try
+		{
+			this->write(sink); // execute on this thread
+		}
+		catch (...)
+		{
+			this->fail(std::current_exception());
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(this->guard);
+
+			this->idle.wait(lock, [this] { return (this->running == 0); });
+		}
+
+		if (this->error)
+		{
+			std::rethrow_exception(this->error);
+		}
+
+		return this->warn;
+	}
+
+
+	std::thread builder(&Pipeline::build, this);
+
+	std::vector< std::thread > workers;
+
+	for (size_t i = 0; i < this->threads; ++i)
+	{
+		workers.emplace_back(&Pipeline::work, this, prog, time);
+	}
+
+	try
+	{
+		this->write(sink); // execute on this thread
+	}
+	catch (...)
+	{
+		this->fail(std::current_exception());
+	}
+
+	builder.join();
+
+	for (size_t i = 0; i < this->threads; ++i)
+	{
+		workers[i].join();
+	}
+
+	if (this->error)
+	{
+		std::rethrow_exception(this->error);
+	}
+
+	return this->warn;
+}
+
+
+// execute sequentially on calling thread
+
+void Pipeline::serial(Sink & sink, Progress * prog, Clock * time)
+{
+	Clock local;
+
+	while (true)
+	{
+		const Site::Data site = this->next();
+
+		if (!site)
+			break;
+
+		Pair::List::const_iterator pair, pair_end = site->list.cend();
+
+		for (pair = site->list.cbegin(); pair != pair_end; ++pair)
+		{
+			if (prog)
+				prog->update();
+
+			Infer infer(this->param, this->method, this->max_miss, *pair, this->grid, this->model, this->sweep);
+
+			try
+			{
+				infer.run();
+			}
+			catch (const std::string & message)
+			{
+				throw std::runtime_error(message);
+			}
+		}
+
+		this->estimate(site);
+
+		{
+			Metrics::Scope scope(Metrics::PRINT);
+			sink.write(site);
+		}
+	}
+
+	if (time)
+		*time << local;
+}
+
+
+// construct sites ahead
+
+void Pipeline::build()
+{
+	try
+	{
+		while (true)
+		{
+			const Site::Data site = this->next();
+
+			if (!site)
+				break;
+
+			const size_t bytes = this->cost(site);
+
+
+			// wait until site fits into budget and tracked memory is below its limit, but admit any site when idle
+			{
+				std::unique_lock<std::mutex> lock(this->guard);
+
+				if (!this->overrun && Memory::overrun())
+				{
+					this->overrun = true;
+
+					this->output->warn("Memory limit is below memory held by sample cache, HMM and marker columns; limit is not applied to scheduling");
+					++this->warn;
+				}
+
+				this->release.wait(lock, [this, bytes] { return (this->error || this->held == 0 || (this->held + bytes <= this->budget && !Memory::exceeded())); });
+
+				if (this->error)
+					break;
+
+				this->held += bytes;
+			}
+
+			if (site->list.empty())
+			{
+				this->estimate(site); // nothing to wait for
+				this->complete(site);
+			}
+
+			if (!this->order.push(site))
+				break;
+
+
+			// hand pairs to workers in batches, large sites are split over several batches
+
+			bool open = true;
+
+			Pair::List::const_iterator pair, pair_end = site->list.cend();
+
+			for (pair = site->list.cbegin(); open && pair != pair_end; ++pair)
+			{
+				{
+					std::unique_lock<std::mutex> lock(this->guard);
+
+					this->release.wait(lock, [this] { return (this->error || this->working < this->limit); });
+
+					if (this->error)
+					{
+						open = false;
+						break;
+					}
+
+					++this->working;
+				}
+
+				open = this->tasks.push(Task{ *pair, nullptr, MUT_CLOCK });
+			}
+
+			if (!open)
+				break;
+		}
+	}
+	catch (...)
+	{
+		this->fail(std::current_exception());
+	}
+
+	this->order.close(); // tasks remain open for estimation of pending sites
+}
+
+
+// pairwise inference, site estimation per clock
+
+void Pipeline::work(Progress * prog, Clock * time)
+{
+	Clock local;
+
+	try
+	{
+		Task task;
+
+		while (this->tasks.pop(task))
+		{
+			if (task.site) // estimate clock, once all pairs are completed
+			{
+				this->estimate(task.site, task.clock);
+
+				if (task.site->settle()) // last clock of site
+				{
+					this->complete(task.site);
+				}
+
+				continue;
+			}
+
+			if (prog)
+				prog->update();
+
+			Infer infer(this->param, this->method, this->max_miss, task.pair, this->grid, this->model, this->sweep);
+
+			infer.run();
+
+			{
+				std::lock_guard<std::mutex> lock(this->guard);
+
+				--this->working;
+			}
+
+			this->release.notify_all();
+
+			const Site::Data site = task.pair->site.lock();
+
+			if (!site)
+				throw std::runtime_error("Unexpected site pointer deletion");
+
+			if (site->release()) // last pair of site, queue clocks ahead of pairs
+			{
+				for (int c = 0; c < n_clocks; ++c)
+				{
+					this->tasks.prepend(Task{ nullptr, site, static_cast<ClockType>(c) });
+				}
+			}
+		}
+	}
+	catch (const std::string & message)
+	{
+		this->fail(std::make_exception_ptr(std::runtime_error(message)));
+	}
+	catch (...)
+	{
+		this->fail(std::current_exception());
+	}
+
+	if (time)
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		*time << local;
+	}
+}
+
+
+// ordered output
+
+void Pipeline::write(Sink & sink)
+{
+	Site::Data site;
+
+	while (this->order.pop(site))
+	{
+		{
+			std::unique_lock<std::mutex> lock(this->guard);
+
+			this->finish.wait(lock, [this, &site] { return (this->error || this->ready.count(site.get()) > 0); });
+
+			if (this->error)
+				return;
+
+			this->ready.erase(site.get());
+		}
+
+		{
+			Metrics::Scope scope(Metrics::PRINT);
+			sink.write(site);
+		}
+
+		const size_t bytes = this->cost(site);
+
+		site.reset(); // release pairs before admitting more
+
+		{
+			std::lock_guard<std::mutex> lock(this->guard);
+
+			this->held -= bytes;
+		}
+
+		this->release.notify_all();
+	}
+
+	this->tasks.close(); // all sites are completed
+}
+
+
+// construct next site, including copies for parameter sweep
+
+Site::Data Pipeline::next()
+{
+	const Site::Data site = this->queue.next(this->simres);
+
+	if (site && this->sweep)
+		this->sweep->expand(site);
+
+	return site;
+}
+
+
+// estimate site after last pair, including copies for parameter sweep
+
+void Pipeline::estimate(const Site::Data site)
+{
+	for (size_t k = 0; k <= site->sweep.size(); ++k)
+	{
+		try
+		{
+			if (k == 0)
+				site->estimate(this->param);
+			else
+				site->sweep[k - 1]->estimate(this->sweep->at(k).param);
+		}
+		catch (const std::string & warning)
+		{
+			std::lock_guard<std::mutex> lock(this->guard);
+
+			this->output->warn(warning);
+			++this->warn;
+		}
+	}
+}
+
+void Pipeline::estimate(const Site::Data site, const ClockType clock)
+{
+	for (size_t k = 0; k <= site->sweep.size(); ++k)
+	{
+		try
+		{
+			if (k == 0)
+				site->estimate(clock, this->param);
+			else
+				site->sweep[k - 1]->estimate(clock, this->sweep->at(k).param);
+		}
+		catch (const std::string & warning)
+		{
+			std::lock_guard<std::mutex> lock(this->guard);
+
+			this->output->warn(warning);
+			++this->warn;
+		}
+
+		if (k > 0)
+			site->sweep[k - 1]->settle(); // copies are settled with their site
+	}
+}
+
+
+// release site to writer
+
+void Pipeline::complete(const Site::Data site)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		this->ready.insert(site.get());
+	}
+
+	this->finish.notify_all();
+}
+
+
+// estimated bytes held by site until written
+
+size_t Pipeline::cost(const Site::Data site) const
+{
+	return (sizeof(Site) + site->list.size() * this->pairs) * (site->sweep.size() + 1);
+}
+
+
+// stop all stages after error
+
+void Pipeline::fail(std::exception_ptr ex)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		if (!this->error)
+			this->error = ex;
+	}
+
+	this->tasks.abort();
+	this->order.abort();
+
+	this->release.notify_all();
+	this->finish.notify_all();
+}
+
+
+// stage submitted to executor has returned
+
+void Pipeline::leave()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		--this->running;
+	}
+
+	this->idle.notify_all();
+}
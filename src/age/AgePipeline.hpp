@@ -0,0 +1,192 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgePipeline_hpp
+#define AgePipeline_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Channel.h"
+#include "Clock.hpp"
+#include "Progress.hpp"
+
+#include "GenGrid.hpp"
+
+#include "IBD.hpp"
+#include "IBD_HMM.hpp"
+#include "IBD_SIM.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+
+
+namespace Age
+{
+	class Sweep;
+
+
+	// Receiver of completed sites
+	class Sink
+	{
+	public:
+
+		virtual ~Sink() {}
+
+		// write site and its pairs
+		virtual void write(const Site::Data) = 0;
+
+		// report warning during estimation
+		virtual void warn(const std::string &);
+	};
+
+
+	// Execution of pipeline stages, e.g. on threads of a caller's pool
+	class Executor
+	{
+	public:
+
+		virtual ~Executor() {}
+
+		// run function asynchronously, all submitted functions must run concurrently
+		virtual void submit(std::function< void() >) = 0;
+	};
+
+
+	// Text output of sites and pairs
+	class TextSink : public Sink
+	{
+	public:
+
+		// construct
+		TextSink(const Param::Data, std::ostream &, std::ostream &);
+
+		// optional full distributions
+		void distr(std::ostream *, std::ostream *);
+
+		// write site and its pairs
+		void write(const Site::Data);
+
+
+	private:
+
+		const Param::Data param;
+
+		std::ostream & pairs;
+		std::ostream & sites;
+
+		std::ostream * pairs_distr;
+		std::ostream * sites_distr;
+	};
+
+
+	// Streaming execution of site construction, inference, estimation and output
+	//
+	// Pairs are handed to workers in batches of limited size, released as each pair is completed,
+	// such that sites with many pairs are split over several batches. Sites are admitted while the
+	// estimated size of all sites in flight (pairs and their CCFs, held until written) fits into the budget.
+	class Pipeline
+	{
+	public:
+
+		static constexpr size_t default_budget = 64 * 1024 * 1024; // bytes
+
+		// construct
+		Pipeline(Queue &, const Param::Data, const IBD::DetectMethod, const decimal_t, const Gen::Grid::Data, const IBD::HMM::Model::Data = nullptr, const IBD::SIM::Result::Data = nullptr, const size_t = 1, const size_t = 1000, const size_t = 0, const std::shared_ptr< Sweep > = nullptr);
+
+		// estimated bytes held per pair until written
+		static size_t pair_size(const Param::Data);
+
+		// execute until queue is exhausted, returns number of warnings; adds time of each thread to clock
+		size_t run(Sink &, Progress * = nullptr, Clock * = nullptr, Executor * = nullptr);
+
+
+	private:
+
+		// Unit of work, pairwise inference or site estimation per clock
+		struct Task
+		{
+			Pair::Data pair;
+			Site::Data site;
+			ClockType  clock;
+		};
+
+
+		// execute sequentially on calling thread
+		void serial(Sink &, Progress *, Clock *);
+
+		// stages
+		void build(); // construct sites ahead
+		void work(Progress *, Clock *); // pairwise inference, site estimation per clock
+		void write(Sink &); // ordered output
+
+		// construct next site, including copies for parameter sweep
+		Site::Data next();
+
+		// estimate site after last pair, including copies for parameter sweep
+		void estimate(const Site::Data);
+		void estimate(const Site::Data, const ClockType);
+
+		// release site to writer
+		void complete(const Site::Data);
+
+		// estimated bytes held by site until written
+		size_t cost(const Site::Data) const;
+
+		// stop all stages after error
+		void fail(std::exception_ptr);
+
+		// stage submitted to executor has returned
+		void leave();
+
+
+		Queue &                     queue;
+		const Param::Data           param;
+		const IBD::DetectMethod     method;
+		const decimal_t             max_miss;
+		const Gen::Grid::Data       grid;
+		const IBD::HMM::Model::Data model;
+		const IBD::SIM::Result::Data simres;
+		const std::shared_ptr< Sweep > sweep; // optional further combinations of parameters
+
+		const size_t threads; // number of worker threads
+		const size_t limit;   // max. number of pairs queued for workers
+		const size_t pairs;   // estimated bytes per pair
+
+		size_t budget;  // max. estimated bytes of sites in flight
+		size_t working; // current number of pairs queued for workers
+		size_t held;    // current estimated bytes of sites in flight
+		size_t running; // number of stages submitted to executor
+
+		std::atomic<size_t> warn;
+
+		bool overrun; // memory limit below fixed footprint, reported once
+
+		Sink * output;
+
+		Channel< Task >       tasks; // pairs and site clocks to be processed
+		Channel< Site::Data > order; // sites in construction order
+
+		std::unordered_set< Site * > ready; // estimated sites
+
+		std::exception_ptr error;
+
+		std::mutex              guard;
+		std::condition_variable release; // pairs completed by workers, sites released by writer
+		std::condition_variable finish; // sites completed by workers
+		std::condition_variable idle;   // stages returned to executor
+	};
+}
+
+
+#endif /* AgePipeline_hpp */
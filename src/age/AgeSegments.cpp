@@ -0,0 +1,361 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgeSegments.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "Hash.h"
+#include "Random.h"
+
+
+using namespace Gen;
+using namespace IBD;
+using namespace Age;
+
+
+namespace
+{
+	// column indices, integer columns first
+	enum SegmentColumn { G_MARKER, G_FK, G_SAMPLE0, G_CHR0, G_SAMPLE1, G_CHR1, G_SHARED, G_DETECTED, G_LHS, G_RHS, G_DIFF_LHS, G_DIFF_RHS, G_MISSING };
+
+
+	// fixed width hexadecimal
+	std::string hex(const uint64_t value)
+	{
+		std::ostringstream oss;
+		oss << std::hex << std::setw(16) << std::setfill('0') << value;
+		return oss.str();
+	}
+}
+
+
+
+// Store of detected segments per pair
+
+// table name
+
+const std::string SegmentStore::table = "segments";
+
+
+// column layout
+
+Columnar::Schema SegmentStore::schema()
+{
+	return {
+		{ "MarkerID",   Columnar::UINT32 },
+		{ "Fk",         Columnar::UINT32 },
+		{ "SampleID0",  Columnar::UINT32 },
+		{ "Chr0",       Columnar::UINT8 },
+		{ "SampleID1",  Columnar::UINT32 },
+		{ "Chr1",       Columnar::UINT8 },
+		{ "Shared",     Columnar::UINT8 },
+		{ "Detected",   Columnar::UINT8 },
+		{ "SegmentLHS", Columnar::UINT32 },
+		{ "SegmentRHS", Columnar::UINT32 },
+		{ "S_LHS",      Columnar::UINT32 }, // differences, plus one (zero if not counted)
+		{ "S_RHS",      Columnar::UINT32 },
+		{ "Missing",    Columnar::FLOAT64 }
+	};
+}
+
+
+// table name including fingerprints of data and model
+
+std::string SegmentStore::title(const uint64_t data, const uint64_t model)
+{
+	return table + ' ' + hex(data) + ' ' + hex(model);
+}
+
+
+// fingerprint of input data
+
+uint64_t SegmentStore::fingerprint(const Grid::Data grid)
+{
+	Hash hash;
+
+	hash.add(uint64_t(grid->sample_size()));
+	hash.add(uint64_t(grid->marker_size()));
+
+	Marker::Vector::const_iterator it, ti = grid->marker().cend();
+
+	for (it = grid->marker().cbegin(); it != ti; ++it)
+	{
+		hash.add(it->chromosome);
+		hash.add(uint64_t(it->position));
+		hash.add(it->gen_dist);
+		hash.add(it->hap_count);
+	}
+
+	return hash.value;
+}
+
+
+// fingerprint of detection model, including input data
+
+uint64_t SegmentStore::fingerprint(const Grid::Data grid, const Param::Data param, const HMM::Model::Data model, const decimal_t max_miss)
+{
+	Hash hash;
+
+	hash.add(fingerprint(grid));
+
+	if (model)
+	{
+		hash.add(uint64_t(model->Ne));
+		hash.add(uint64_t(model->Nh));
+		hash.add(model->initial_con_fk());
+		hash.add(model->initial_dis_fk());
+		hash.add(model->emission_fk());
+	}
+
+	// selection of pairs and counting of differences
+	hash.add(uint64_t(param->limit_sharers));
+	hash.add(uint64_t(param->outgroup_size));
+	hash.add(uint64_t(param->nearest_range));
+	hash.add(param->apply_nearest_neighb);
+	hash.add(param->relax_nearest_neighb);
+	hash.add(param->use_tree_consistency);
+	hash.add(param->all_variants);
+	hash.add(max_miss);
+
+	hash.add(uint64_t(get_random_seed())); // random streams are keyed by seed
+
+	return hash.value;
+}
+
+
+// construct, indexes sites of store files
+
+SegmentStore::SegmentStore(const std::vector< std::string > & filenames, const Grid::Data grid)
+: fingerprint_model(0)
+, cache_file(std::numeric_limits<size_t>::max())
+, cache_group(std::numeric_limits<size_t>::max())
+, column(G_MISSING)
+{
+	const Columnar::Schema expect = schema();
+
+	const uint64_t fingerprint_data = fingerprint(grid);
+
+	for (size_t f = 0; f < filenames.size(); ++f)
+	{
+		this->files.emplace_back(new Columnar::Reader(filenames[f]));
+
+		Columnar::Reader & reader = *this->files.back();
+
+
+		// check layout and fingerprints
+
+		bool match = reader.schema().size() == expect.size();
+
+		for (size_t i = 0; match && i < expect.size(); ++i)
+		{
+			match = (reader.schema()[i].name == expect[i].name && reader.schema()[i].type == expect[i].type);
+		}
+
+		std::istringstream iss(reader.table());
+
+		std::string name, data, model;
+
+		if (!match || !(iss >> name >> data >> model) || name != table)
+			throw std::runtime_error("Unknown segment store file: " + filenames[f]);
+
+		if (data != hex(fingerprint_data))
+			throw std::runtime_error("Segment store does not match input data: " + filenames[f]);
+
+		const uint64_t fp = std::stoull(model, nullptr, 16);
+
+		if (f > 0 && fp != this->fingerprint_model)
+			throw std::runtime_error("Segment store of different detection model: " + filenames[f]);
+
+		this->fingerprint_model = fp;
+
+
+		// index consecutive rows of each site
+
+		std::vector< uint64_t > marker, fk;
+
+		for (size_t g = 0; g < reader.groups(); ++g)
+		{
+			reader.get(g, G_MARKER, marker);
+			reader.get(g, G_FK, fk);
+
+			for (size_t r = 0; r < reader.rows(g); ++r)
+			{
+				if (!this->entries.empty() && this->entries.back().file == f && this->entries.back().site.value == marker[r])
+				{
+					++this->entries.back().pairs;
+					continue;
+				}
+
+				if (marker[r] >= grid->marker_size())
+					throw std::runtime_error("Unexpected site in segment store: " + filenames[f]);
+
+				if (!this->lookup.emplace(marker[r], this->entries.size()).second)
+					throw std::runtime_error("Site " + std::to_string(marker[r]) + " found more than once in segment store: " + filenames[f]);
+
+				this->entries.push_back(Entry{ fk[r], marker[r], f, g, r, 1 });
+			}
+		}
+	}
+}
+
+
+// indexed sites
+
+SegmentStore::Index const & SegmentStore::index() const
+{
+	return this->entries;
+}
+
+
+// number of stored pairs of site
+
+size_t SegmentStore::count(const Marker::Key & site) const
+{
+	std::unordered_map< size_t, size_t >::const_iterator it = this->lookup.find(site.value);
+
+	return (it != this->lookup.cend()) ? this->entries[it->second].pairs: 0;
+}
+
+
+// fingerprint of detection model
+
+uint64_t SegmentStore::model() const
+{
+	return this->fingerprint_model;
+}
+
+
+// restore site and its pairs, completed up to age estimation
+
+Site::Data SegmentStore::load(const Marker::Key & site)
+{
+	std::unordered_map< size_t, size_t >::const_iterator it = this->lookup.find(site.value);
+
+	if (it == this->lookup.cend())
+		throw std::runtime_error("Site not found in segment store: " + std::to_string(site.value));
+
+	const Entry & entry = this->entries[it->second];
+
+	Columnar::Reader & reader = *this->files[entry.file];
+
+	Pair::List list;
+
+	size_t g = entry.group;
+	size_t r = entry.row;
+
+	for (size_t i = 0; i < entry.pairs; ++i, ++r)
+	{
+		if (r == reader.rows(g)) // continued in next row group
+		{
+			++g;
+			r = 0;
+		}
+
+		this->fetch(entry.file, g);
+
+		Gamete::Pair pair;
+
+		pair.first.individual = this->column[G_SAMPLE0][r];
+		pair.first.chromosome = static_cast<ChrType>(this->column[G_CHR0][r]);
+
+		pair.second.individual = this->column[G_SAMPLE1][r];
+		pair.second.chromosome = static_cast<ChrType>(this->column[G_CHR1][r]);
+
+		Pair::Data result = std::make_shared< Pair >(pair, this->column[G_SHARED][r] != 0);
+
+		result->missing  = static_cast<decimal_t>(this->missing[r]);
+		result->segment  = Segment(this->column[G_LHS][r], this->column[G_RHS][r]);
+		result->segdiff  = SegDiff(static_cast<int>(this->column[G_DIFF_LHS][r]) - 1, static_cast<int>(this->column[G_DIFF_RHS][r]) - 1);
+		result->detected = (this->column[G_DETECTED][r] != 0);
+		result->done     = true; // estimation only
+
+		list.push_back(std::move(result));
+	}
+
+	return std::make_shared< Site >(entry.fk, entry.site, std::move(list));
+}
+
+
+// decompress row group, if not cached
+
+void SegmentStore::fetch(const size_t file, const size_t group)
+{
+	if (file == this->cache_file && group == this->cache_group)
+		return;
+
+	Columnar::Reader & reader = *this->files[file];
+
+	for (size_t i = 0; i < G_MISSING; ++i)
+		reader.get(group, i, this->column[i]);
+
+	reader.get(group, G_MISSING, this->missing);
+
+	this->cache_file  = file;
+	this->cache_group = group;
+}
+
+
+
+// Segment store output
+
+// construct
+
+SegmentSink::SegmentSink(Sink & _sink, const std::string & filename, const uint64_t data, const uint64_t model)
+: sink(_sink)
+, store(filename, SegmentStore::title(data, model), SegmentStore::schema())
+{}
+
+
+// write site and its pairs
+
+void SegmentSink::write(const Site::Data site)
+{
+	if (site->done)
+	{
+		Pair::List::const_iterator p, p_end = site->list.cend();
+
+		for (p = site->list.cbegin(); p != p_end; ++p)
+		{
+			const Pair & pair = **p;
+
+			this->store.put(G_MARKER,   uint64_t(site->focus.value));
+			this->store.put(G_FK,       uint64_t(site->fk));
+			this->store.put(G_SAMPLE0,  uint64_t(pair.pair.first.individual.value));
+			this->store.put(G_CHR0,     uint64_t(pair.pair.first.chromosome));
+			this->store.put(G_SAMPLE1,  uint64_t(pair.pair.second.individual.value));
+			this->store.put(G_CHR1,     uint64_t(pair.pair.second.chromosome));
+			this->store.put(G_SHARED,   uint64_t(pair.sharing));
+			this->store.put(G_DETECTED, uint64_t(pair.detected));
+			this->store.put(G_LHS,      uint64_t(pair.segment[LHS].value));
+			this->store.put(G_RHS,      uint64_t(pair.segment[RHS].value));
+			this->store.put(G_DIFF_LHS, uint64_t(pair.segdiff[LHS] + 1));
+			this->store.put(G_DIFF_RHS, uint64_t(pair.segdiff[RHS] + 1));
+			this->store.put(G_MISSING,  static_cast<double>(pair.missing));
+			this->store.next();
+		}
+	}
+
+	this->sink.write(site);
+}
+
+
+// report warning during estimation
+
+void SegmentSink::warn(const std::string & warning)
+{
+	this->sink.warn(warning);
+}
+
+
+// write footer
+
+void SegmentSink::close()
+{
+	this->store.close();
+}
@@ -0,0 +1,138 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgeSegments_hpp
+#define AgeSegments_hpp
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Columnar.hpp"
+
+#include "GenGrid.hpp"
+
+#include "IBD.hpp"
+#include "IBD_HMM.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+
+namespace Age
+{
+	// Store of detected segments per pair, to re-estimate ages without segment detection
+	//
+	// Columnar table of all pairs of written sites, pairs of each site in consecutive rows. The table name
+	// carries a fingerprint of the input data (samples, markers) and of the detection model (HMM, pair
+	// selection, random seed); sites are indexed on construction and restored in order of the index.
+	class SegmentStore
+	{
+	public:
+
+		using Data = std::shared_ptr< SegmentStore >;
+
+
+		// Indexed site, rows from given row group onwards
+		struct Entry
+		{
+			size_t           fk;
+			Gen::Marker::Key site;
+			size_t           file;
+			size_t           group;
+			size_t           row;
+			size_t           pairs;
+		};
+
+		using Index = std::vector< Entry >;
+
+
+		// table name
+		static const std::string table;
+
+		// column layout
+		static Columnar::Schema schema();
+
+		// table name including fingerprints of data and model
+		static std::string title(const uint64_t, const uint64_t);
+
+		// fingerprint of input data
+		static uint64_t fingerprint(const Gen::Grid::Data);
+
+		// fingerprint of detection model, including input data
+		static uint64_t fingerprint(const Gen::Grid::Data, const Param::Data, const IBD::HMM::Model::Data, const decimal_t);
+
+
+		// construct, indexes sites of store files; files must match input data and share detection model
+		SegmentStore(const std::vector< std::string > &, const Gen::Grid::Data);
+		SegmentStore(const SegmentStore &) = delete; // no copy
+
+		// indexed sites
+		Index const & index() const;
+
+		// number of stored pairs of site
+		size_t count(const Gen::Marker::Key &) const;
+
+		// fingerprint of detection model
+		uint64_t model() const;
+
+		// restore site and its pairs, completed up to age estimation
+		Site::Data load(const Gen::Marker::Key &);
+
+
+	private:
+
+		// decompress row group, if not cached
+		void fetch(const size_t, const size_t);
+
+
+		std::vector< std::unique_ptr< Columnar::Reader > > files;
+
+		Index entries;
+
+		std::unordered_map< size_t, size_t > lookup; // marker id to entry
+
+		uint64_t fingerprint_model;
+
+		// cached row group, as read in order of index
+		size_t cache_file;
+		size_t cache_group;
+
+		std::vector< std::vector< uint64_t > > column;
+		std::vector< double >                  missing;
+	};
+
+
+	// Segment store output, appended by site and forwarded to results output
+	class SegmentSink : public Sink
+	{
+	public:
+
+		// construct
+		SegmentSink(Sink &, const std::string &, const uint64_t, const uint64_t);
+
+		// write site and its pairs
+		void write(const Site::Data);
+
+		// report warning during estimation
+		void warn(const std::string &);
+
+		// write footer
+		void close();
+
+
+	private:
+
+		Sink & sink;
+
+		Columnar::Writer store;
+	};
+}
+
+
+#endif /* AgeSegments_hpp */
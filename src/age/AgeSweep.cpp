@@ -0,0 +1,126 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgeSweep.hpp"
+
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+
+using namespace Gen;
+using namespace IBD;
+using namespace Age;
+
+
+
+// Combinations of effective sizes and mutation rates
+
+// construct
+
+Sweep::Sweep(const Grid::Data grid, const Param::Data param, const HMM::Model::Data model, const std::vector< size_t > & Ne, const std::vector< double > & mut)
+{
+	if (Ne.empty() || mut.empty())
+		throw std::invalid_argument("Parameter sweep requires at least one effective size and mutation rate");
+
+	if (std::set< size_t >(Ne.cbegin(), Ne.cend()).size() != Ne.size() || std::set< double >(mut.cbegin(), mut.cend()).size() != mut.size())
+		throw std::invalid_argument("Duplicate values in parameter sweep");
+
+	if (static_cast<size_t>(param->Ne) != Ne.front() || param->Mr != static_cast<decimal_t>(mut.front()))
+		throw std::invalid_argument("Parameter sweep does not begin with given parameters");
+
+	if (model && model->Ne != Ne.front())
+		throw std::invalid_argument("Parameter sweep does not begin with given HMM");
+
+
+	std::vector< HMM::Model::Data > models; // per effective size
+
+	for (size_t i = 0; i < Ne.size(); ++i)
+	{
+		models.push_back((i == 0 || !model) ? model: std::make_shared< HMM::Model >(*model, Ne[i]));
+
+		for (size_t j = 0; j < mut.size(); ++j)
+		{
+			std::ostringstream label;
+			label << "Ne" << Ne[i] << ".mut" << mut[j];
+
+			const Param::Data other = (i == 0 && j == 0) ? param: std::make_shared< Param >(*param, grid, Ne[i], static_cast<decimal_t>(mut[j]));
+
+			this->settings.push_back(Setting{ other, models[i], label.str() });
+		}
+	}
+}
+
+
+// number of combinations
+
+size_t Sweep::size() const
+{
+	return this->settings.size();
+}
+
+
+// parameters of combination
+
+Sweep::Setting const & Sweep::at(const size_t k) const
+{
+	return this->settings.at(k);
+}
+
+
+// add copies of site and its pairs for further combinations
+
+void Sweep::expand(const Site::Data site) const
+{
+	for (size_t k = 1; k < this->settings.size(); ++k)
+	{
+		Pair::List list;
+
+		Pair::List::const_iterator pair, pair_end = site->list.cend();
+
+		for (pair = site->list.cbegin(); pair != pair_end; ++pair)
+		{
+			const Pair::Data other = std::make_shared< Pair >((*pair)->pair, (*pair)->sharing);
+
+			(*pair)->sweep.push_back(other);
+
+			list.push_back(other);
+		}
+
+		const Site::Data other = std::make_shared< Site >(site->fk, site->focus, std::move(list));
+
+		for (pair = other->list.cbegin(); pair != other->list.cend(); ++pair)
+		{
+			(*pair)->site = other; // activate site pointer
+		}
+
+		site->sweep.push_back(other);
+	}
+}
+
+
+
+// Output of each combination to its own receiver
+
+// construct
+
+SweepSink::SweepSink(const std::vector< Sink * > & _sinks)
+: sinks(_sinks)
+{}
+
+
+// write site and its pairs
+
+void SweepSink::write(const Site::Data site)
+{
+	if (this->sinks.size() != site->sweep.size() + 1)
+		throw std::runtime_error("Unexpected number of parameter combinations");
+
+	this->sinks[0]->write(site);
+
+	for (size_t k = 0; k < site->sweep.size(); ++k)
+	{
+		this->sinks[k + 1]->write(site->sweep[k]);
+	}
+}
@@ -0,0 +1,83 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgeSweep_hpp
+#define AgeSweep_hpp
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GenGrid.hpp"
+
+#include "IBD.hpp"
+#include "IBD_HMM.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+
+namespace Age
+{
+	// Combinations of effective sizes and mutation rates, estimated in a single pass
+	//
+	// Sites and pairs are selected once, under the first combination; each further combination holds
+	// a copy of the site and its pairs. Segments are detected once per effective size (HMM transitions
+	// depend on Ne only), and CCFs and site estimates are evaluated per combination.
+	class Sweep
+	{
+	public:
+
+		using Data = std::shared_ptr< Sweep >;
+
+
+		// Parameters of one combination
+		struct Setting
+		{
+			Param::Data           param;
+			IBD::HMM::Model::Data model;
+			std::string           label; // e.g. Ne10000.mut1e-08
+		};
+
+
+		// construct, combinations of given effective sizes and mutation rates; first combination as given
+		Sweep(const Gen::Grid::Data, const Param::Data, const IBD::HMM::Model::Data, const std::vector< size_t > &, const std::vector< double > &);
+
+		// number of combinations
+		size_t size() const;
+
+		// parameters of combination
+		Setting const & at(const size_t) const;
+
+		// add copies of site and its pairs for further combinations
+		void expand(const Site::Data) const;
+
+
+	private:
+
+		std::vector< Setting > settings;
+	};
+
+
+	// Output of each combination to its own receiver
+	class SweepSink : public Sink
+	{
+	public:
+
+		// construct, one receiver per combination
+		SweepSink(const std::vector< Sink * > &);
+
+		// write site and its pairs
+		void write(const Site::Data);
+
+
+	private:
+
+		const std::vector< Sink * > sinks;
+	};
+}
+
+
+#endif /* AgeSweep_hpp */
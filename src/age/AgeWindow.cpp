@@ -0,0 +1,231 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "AgeWindow.hpp"
+
+#include <algorithm>
+
+
+using namespace Gen;
+using namespace Age;
+
+
+// Sliding window of haplotypes around focal site
+
+// construct
+
+Window::Window(const Grid::Data grid, const Param::Data _param)
+: source(grid)
+, param(_param)
+, width((2 * _param->nearest_range) + 1)
+, words((width + 63) / 64)
+, n_hap(_param->Nh)
+, ahead(width)
+, lanes((_param->Nh + 63) / 64)
+, cursor(_param->Ng)
+, column(width)
+, ahead_from(0)
+, ahead_to(0)
+, lower(0)
+, upper(0)
+, focus(0)
+, held(Memory::NEAR_RANK)
+{
+	this->is_h0.assign(this->n_hap * this->words, 0);
+	this->is_h1.assign(this->n_hap * this->words, 0);
+
+	this->ahead_h0.assign(this->ahead * this->lanes, 0);
+	this->ahead_h1.assign(this->ahead * this->lanes, 0);
+
+	this->held.set((this->is_h0.size() + this->is_h1.size() + this->ahead_h0.size() + this->ahead_h1.size()) * sizeof(word_t) + this->cursor.size() * sizeof(Grid::Cursor) + this->column.size());
+}
+
+
+// move window to next focal site
+
+void Window::move(const Marker::Key & site)
+{
+	if (site.value < this->focus.value)
+		throw std::invalid_argument("Focal sites must be visited in position order");
+
+	const size_t range = this->param->nearest_range;
+
+	const size_t from = site.value - std::min(range, site.value);
+	const size_t to   = site.value + std::min(range, this->param->Nm - site.value - 1) + 1;
+
+
+	// drop markers behind window, restart if not overlapping
+
+	const size_t keep = std::min(from, this->upper);
+
+	for (size_t i = this->lower; i < keep; ++i)
+		this->remove(i);
+
+	if (from >= this->upper)
+		this->upper = from;
+
+	this->lower = from;
+
+
+	// append markers ahead of window
+
+	for (size_t i = this->upper; i < to; ++i)
+		this->insert(i);
+
+	this->upper = to;
+
+	this->focus = site;
+}
+
+
+// individuals sharing focal site, once per allele copy
+
+Sample::Key::Vector Window::share() const
+{
+	Sample::Key::Vector out;
+
+	for (size_t i = 0; i < this->param->Ng; ++i)
+	{
+		if (is_haplotype<H1>(this->at((2 * i) + MATERNAL, this->focus.value)))
+			out.push_back(i);
+
+		if (is_haplotype<H1>(this->at((2 * i) + PATERNAL, this->focus.value)))
+			out.push_back(i);
+	}
+
+	return out;
+}
+
+
+// haplotype at focal site
+
+hap_t Window::focal(const Gamete & chr) const
+{
+	return index_to_haplotype(this->at(this->index(chr), this->focus.value));
+}
+
+
+// number of sites in window where first is H0 and second is H1
+
+size_t Window::dist(const Gamete & a, const Gamete & b) const
+{
+	const word_t * h0 = &this->is_h0[ this->index(a) * this->words ];
+	const word_t * h1 = &this->is_h1[ this->index(b) * this->words ];
+
+	size_t d = 0;
+
+	for (size_t k = 0; k < this->words; ++k)
+	{
+		d += __builtin_popcountll(h0[k] & h1[k]);
+	}
+
+	return d;
+}
+
+
+// read block of markers ahead, from each individual in turn
+
+void Window::fill(const size_t marker)
+{
+	this->ahead_from = marker;
+	this->ahead_to   = std::min(marker + this->ahead, this->param->Nm);
+
+	std::fill(this->ahead_h0.begin(), this->ahead_h0.end(), 0);
+	std::fill(this->ahead_h1.begin(), this->ahead_h1.end(), 0);
+
+	for (size_t i = 0; i < this->param->Ng; ++i)
+	{
+		if (!this->source->sample(i).phase)
+			throw std::invalid_argument("Variant vector is not phased");
+
+		this->source->span(i, this->cursor[i], this->ahead_from, this->ahead_to, this->column);
+
+		for (size_t m = this->ahead_from; m < this->ahead_to; ++m)
+		{
+			const hap_pair_t h = genotype_to_haplotypes(this->column[m - this->ahead_from]);
+
+			for (size_t c = 0; c < ploidy; ++c)
+			{
+				const size_t hap  = (2 * i) + c;
+				const size_t at   = ((m - this->ahead_from) * this->lanes) + (hap / 64);
+				const word_t mask = word_t(1) << (hap % 64);
+
+				if (is_haplotype<H0>(h[c]))
+					this->ahead_h0[at] |= mask;
+
+				if (is_haplotype<H1>(h[c]))
+					this->ahead_h1[at] |= mask;
+			}
+		}
+	}
+}
+
+
+// set column of marker in ring buffer
+
+void Window::insert(const size_t marker)
+{
+	if (marker < this->ahead_from || marker >= this->ahead_to)
+		this->fill(marker);
+
+	const size_t bit  = marker % this->width;
+	const size_t word = bit / 64;
+	const word_t mask = word_t(1) << (bit % 64);
+
+	const word_t * h0 = &this->ahead_h0[ (marker - this->ahead_from) * this->lanes ];
+	const word_t * h1 = &this->ahead_h1[ (marker - this->ahead_from) * this->lanes ];
+
+	for (size_t h = 0; h < this->n_hap; ++h)
+	{
+		const size_t at = (h * this->words) + word;
+
+		if ((h0[h / 64] >> (h % 64)) & 1)
+			this->is_h0[at] |= mask;
+
+		if ((h1[h / 64] >> (h % 64)) & 1)
+			this->is_h1[at] |= mask;
+	}
+}
+
+
+// clear column of marker in ring buffer
+
+void Window::remove(const size_t marker)
+{
+	const size_t bit  = marker % this->width;
+	const size_t word = bit / 64;
+	const word_t mask = ~(word_t(1) << (bit % 64));
+
+	for (size_t h = 0; h < this->n_hap; ++h)
+	{
+		this->is_h0[ (h * this->words) + word ] &= mask;
+		this->is_h1[ (h * this->words) + word ] &= mask;
+	}
+}
+
+
+// haplotype at marker in ring buffer
+
+HapType Window::at(const size_t hap, const size_t marker) const
+{
+	const size_t bit  = marker % this->width;
+	const size_t at   = (hap * this->words) + (bit / 64);
+	const word_t mask = word_t(1) << (bit % 64);
+
+	if (this->is_h1[at] & mask)
+		return H1;
+
+	if (this->is_h0[at] & mask)
+		return H0;
+
+	return H_;
+}
+
+
+// index of haplotype
+
+size_t Window::index(const Gamete & chr) const
+{
+	return (2 * chr.individual.value) + chr.chromosome;
+}
@@ -0,0 +1,104 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef AgeWindow_hpp
+#define AgeWindow_hpp
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Gen.hpp"
+#include "GenSample.hpp"
+#include "GenMarker.hpp"
+#include "GenGrid.hpp"
+#include "GenVariant.hpp"
+
+#include "Memory.hpp"
+
+#include "Age.hpp"
+
+
+namespace Age
+{
+	// Sliding window of haplotypes around focal site, visited in position order
+	//
+	// Holds bit vectors of the window and of a block of markers read ahead only; the block is
+	// filled by reading only its markers from each individual, resuming where the previous block
+	// ended, so memory is bounded by window size and each data vector is decoded once per sweep.
+	class Window
+	{
+	public:
+
+		using Data = std::shared_ptr< Window >;
+
+
+		// construct
+		Window(const Gen::Grid::Data, const Param::Data);
+
+		// move window to next focal site
+		void move(const Gen::Marker::Key &);
+
+		// individuals sharing focal site, once per allele copy
+		Gen::Sample::Key::Vector share() const;
+
+		// haplotype at focal site
+		Gen::hap_t focal(const Gamete &) const;
+
+		// number of sites in window where first is H0 and second is H1
+		size_t dist(const Gamete &, const Gamete &) const;
+
+
+	private:
+
+		using word_t = uint64_t;
+
+
+		// read block of markers ahead, from each individual in turn
+		void fill(const size_t);
+
+		// set or clear column of marker in ring buffer
+		void insert(const size_t);
+		void remove(const size_t);
+
+		// haplotype at marker in ring buffer
+		Gen::HapType at(const size_t, const size_t) const;
+
+		// index of haplotype
+		size_t index(const Gamete &) const;
+
+
+		const Gen::Grid::Data source;
+		const Param::Data     param;
+
+		const size_t width; // ring buffer size, in markers
+		const size_t words; // ring buffer size, in words per haplotype
+		const size_t n_hap; // number of haplotypes
+		const size_t ahead; // markers read ahead
+		const size_t lanes; // words per marker read ahead
+
+		std::vector< Gen::Grid::Cursor > cursor; // position in data vector of each individual
+		Gen::gen_vector_t                 column; // genotypes of individual in block read ahead
+
+		std::vector< word_t > is_h0; // haplotype-major bit vectors, H0 at marker
+		std::vector< word_t > is_h1; // haplotype-major bit vectors, H1 at marker
+
+		std::vector< word_t > ahead_h0; // marker-major bit vectors of block read ahead, H0 at haplotype
+		std::vector< word_t > ahead_h1; // marker-major bit vectors of block read ahead, H1 at haplotype
+
+		size_t ahead_from; // first marker read ahead
+		size_t ahead_to;   // last marker read ahead, exclusive
+
+		size_t lower; // first marker in window
+		size_t upper; // last marker in window, exclusive
+
+		Gen::Marker::Key focus;
+
+		Memory::Account held; // tracked size of bit vectors
+	};
+}
+
+
+#endif /* AgeWindow_hpp */
@@ -0,0 +1,64 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef convert_columns_h
+#define convert_columns_h
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "AgeColumns.hpp"
+
+
+// Convert binary columnar results file to text layout of pairs or sites file
+
+inline void convert_columns(const std::string & input, const std::string & output)
+{
+	std::cout << "Converting columnar results file" << std::endl;
+	std::clog << "Converting columnar results file" << std::endl;
+
+	std::cout << "<< " << input << std::endl;
+	std::clog << "<< " << input << std::endl;
+
+	try
+	{
+		const std::string file_tmp = output + ".convert.tmp";
+
+		std::string table;
+
+		{
+			std::ofstream stream(file_tmp);
+
+			table = Age::print_columns(input, stream);
+
+			if (!stream)
+				throw std::runtime_error("Error while writing file: " + file_tmp);
+		}
+
+		const std::string file_text = output + '.' + table + ".txt";
+
+		if (std::rename(file_tmp.c_str(), file_text.c_str()) != 0)
+			throw std::runtime_error("Unable to create file: " + file_text);
+
+		std::cout << ">> " << file_text << std::endl;
+		std::clog << ">> " << file_text << std::endl;
+
+		std::cout << std::endl;
+		std::clog << std::endl;
+	}
+	catch (const std::exception & error)
+	{
+		std::cout << std::endl << "Error: " << error.what() << std::endl;
+		std::cerr << error.what() << std::endl << std::endl;
+
+		throw std::runtime_error("[Terminated]");
+	}
+}
+
+
+#endif /* convert_columns_h */
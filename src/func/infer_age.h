@@ -15,28 +15,44 @@
 
 #include "Progress.hpp"
 #include "Clock.hpp"
+#include "Output.hpp"
 
 #include "GenGrid.hpp"
 #include "GenShare.hpp"
 
 #include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+#include "AgeColumns.hpp"
+#include "AgeCheckpoint.hpp"
+#include "AgeSegments.hpp"
 
-#include "Threadpool.h"
+
+// Run and output options of age inference
+struct InferOptions
+{
+	bool   print_cle_full = false; // write posterior distribution of each site
+	bool   print_ccf_full = false; // write cumulative coalescent function of each pair
+	size_t threads        = 1;     // number of worker threads, also compressing output
+	size_t batch_limit    = 1000;  // max. number of pairs queued for workers
+	bool   columnar       = false; // binary columnar output
+	bool   compress       = false; // BGZF compressed text output
+	size_t checkpoint     = 0;     // checkpoint interval in seconds, none if 0
+	bool   resume         = false; // continue from checkpoint
+	bool   segments       = false; // write segment store
+};
 
 
 inline void infer_age(const Age::Param::Data param,
 					  const IBD::DetectMethod method,
 					  const decimal_t max_miss,
 					  const std::string & output,
-					  const bool print_cle_full,
-					  const bool print_ccf_full,
 					  const Gen::Share::Data share,
 					  const Gen::Grid::Data grid,
 					  Clock & time,
+					  const InferOptions & run,
 					  const IBD::HMM::Model::Data hmm_model = nullptr,
 					  const IBD::SIM::Result::Data simres = nullptr,
-					  const size_t threads = 1,
-					  const size_t batch_limit = 1000)
+					  const Age::SegmentStore::Data store = nullptr) // re-estimate from segment store
 {
 	std::cout << "Age estimation, using ";
 	std::clog << "Age estimation, using ";
@@ -70,8 +86,10 @@ inline void infer_age(const Age::Param::Data param,
 
 	// print results to files
 
-	const std::string file_pairs = output + ".pairs.txt";
-	const std::string file_sites = output + ".sites.txt";
+	const std::string file_gzip = (run.compress) ? ".gz": "";
+	
+	const std::string file_pairs = output + ((run.columnar) ? ".pairs.col": ".pairs.txt" + file_gzip);
+	const std::string file_sites = output + ((run.columnar) ? ".sites.col": ".sites.txt" + file_gzip);
 	
 	
 	// detection method
@@ -128,17 +146,25 @@ inline void infer_age(const Age::Param::Data param,
 	}
 	*/
 	
-	const std::string file_pairs_distr = output + ".pairs.distr.txt";
-	const std::string file_sites_distr = output + ".sites.distr.txt";
+	const std::string file_pairs_distr = output + ".pairs.distr.txt" + file_gzip;
+	const std::string file_sites_distr = output + ".sites.distr.txt" + file_gzip;
+	
+	const std::string file_segments = output + ".segments.col";
 	
 	//file_pairs += ".txt";
 	//file_sites += ".txt";
 
-	std::cout << ">> " << file_pairs << ((print_ccf_full) ? " + " + file_pairs_distr: "") << std::endl;
-	std::cout << ">> " << file_sites << ((print_cle_full) ? " + " + file_sites_distr: "") << std::endl;
+	std::cout << ">> " << file_pairs << ((run.print_ccf_full) ? " + " + file_pairs_distr: "") << std::endl;
+	std::cout << ">> " << file_sites << ((run.print_cle_full) ? " + " + file_sites_distr: "") << std::endl;
 	
-	std::clog << ">> " << file_pairs << ((print_ccf_full) ? " + " + file_pairs_distr: "") << std::endl;
-	std::clog << ">> " << file_sites << ((print_cle_full) ? " + " + file_sites_distr: "") << std::endl;
+	std::clog << ">> " << file_pairs << ((run.print_ccf_full) ? " + " + file_pairs_distr: "") << std::endl;
+	std::clog << ">> " << file_sites << ((run.print_cle_full) ? " + " + file_sites_distr: "") << std::endl;
+	
+	if (run.segments)
+	{
+		std::cout << ">> " << file_segments << std::endl;
+		std::clog << ">> " << file_segments << std::endl;
+	}
 
 	std::cout << std::endl;
 	std::clog << std::endl;
@@ -174,168 +200,188 @@ inline void infer_age(const Age::Param::Data param,
 	//std::cout << " Max. pairwise missing rate: " << std::fixed << std::setprecision(4) << max_miss << std::endl;
 	//std::clog << " Max. pairwise missing rate: " << std::fixed << std::setprecision(4) << max_miss << std::endl;
 	
-	if (threads > 1)
+	if (run.threads > 1)
+	{
+		std::cout << " # threads = " << run.threads << std::endl;
+		std::clog << " # threads = " << run.threads << std::endl;
+	}
+	
+	if (param->shard_count > 1)
 	{
-		std::cout << " # threads = " << threads << std::endl;
-		std::clog << " # threads = " << threads << std::endl;
+		std::cout << " # shard = " << (param->shard_index + 1) << "/" << param->shard_count << std::endl;
+		std::clog << " # shard = " << (param->shard_index + 1) << "/" << param->shard_count << std::endl;
 	}
 
 
 	try
 	{
-		// queue for detection and inference
-
-		Age::Queue queue(share, batch_limit, grid, param, simres);
+		// state of interrupted run
 		
-		std::cout << " # pairwise analyses = " << queue.size() << std::endl;
-		std::clog << " # pairwise analyses = " << queue.size() << std::endl;
+		const std::string file_checkpoint = output + ".checkpoint";
 		
-		std::cout << std::endl;
-		std::clog << std::endl;
+		Age::Checkpoint::State state;
 		
+		const bool resumed = run.resume && Age::Checkpoint::load(file_checkpoint, state);
 		
-		// write results to streams
+		if (run.resume && !resumed)
+		{
+			std::cout << " No checkpoint found, starting from first site" << std::endl;
+			std::clog << " No checkpoint found, starting from first site" << std::endl;
+		}
 		
-		std::ofstream stream_pairs(file_pairs);
-		std::ofstream stream_sites(file_sites);
+		if (resumed)
+		{
+			set_random_seed(state.seed); // random streams as in interrupted run
+		}
 		
-		Age::Pair::print_header(stream_pairs, param, false);
-		Age::Site::print_header(stream_sites, param, false);
 		
+		// queue for detection and inference, or estimation only from stored segments
+
+		std::unique_ptr< Age::Queue > source((store) ? new Age::Queue(store, grid, param): new Age::Queue(share, grid, param, simres));
 		
-		std::ofstream stream_pairs_distr;
-		std::ofstream stream_sites_distr;
+		Age::Queue & queue = *source;
 		
-		if (print_cle_full)
+		if (store)
 		{
-			stream_sites_distr.open(file_sites_distr);
-			Age::Site::print_header(stream_sites_distr, param, true);
+			std::cout << " Re-estimation from segment store, model " << std::hex << std::setw(16) << std::setfill('0') << store->model() << std::dec << std::setfill(' ') << std::endl;
+			std::clog << " Re-estimation from segment store, model " << std::hex << std::setw(16) << std::setfill('0') << store->model() << std::dec << std::setfill(' ') << std::endl;
 		}
 		
-		if (print_ccf_full)
+		const uint64_t fingerprint = Age::Checkpoint::fingerprint(queue, param, method, (store) ? store->model(): Age::SegmentStore::fingerprint(grid, param, hmm_model, max_miss)); // before completed sites are removed
+		
+		if (resumed && state.fingerprint != fingerprint)
+			throw std::runtime_error("Checkpoint does not match target sites or parameters of this run: " + file_checkpoint);
+		
+		if (resumed)
 		{
-			stream_pairs_distr.open(file_pairs_distr);
-			Age::Pair::print_header(stream_pairs_distr, param, true);
+			const size_t skipped = queue.skip(state.done);
+			
+			std::cout << " # sites completed before checkpoint = " << skipped << std::endl;
+			std::clog << " # sites completed before checkpoint = " << skipped << std::endl;
 		}
 		
+		std::cout << " # pairwise analyses = " << queue.size() << std::endl;
+		std::clog << " # pairwise analyses = " << queue.size() << std::endl;
 		
-		// walkabout queue in batches
+		std::cout << std::endl;
+		std::clog << std::endl;
 		
-		//size_t n_pairs_done = 0;
-		//size_t n_pairs_good = 0;
 		
-		//size_t n_sites_done = 0;
-		//size_t n_sites_good = 0;
+		// stream sites through construction, inference, estimation and output
 		
 		Progress prog(queue.size());
 		
+		Age::Pipeline pipeline(queue, param, method, max_miss, grid, hmm_model, simres, run.threads, run.batch_limit);
+		
 		size_t warn = 0;
 		
-		while (true)
+		
+		// optionally keep detected segments of all pairs, then write results
+		
+		auto execute = [&](Age::Sink & sink) -> size_t
+		{
+			if (!run.segments)
+				return pipeline.run(sink, &prog, &time);
+			
+			Age::SegmentSink keep(sink, file_segments, Age::SegmentStore::fingerprint(grid), Age::SegmentStore::fingerprint(grid, param, hmm_model, max_miss));
+			
+			const size_t n = pipeline.run(keep, &prog, &time);
+			
+			keep.close();
+			
+			return n;
+		};
+		
+		if (run.columnar)
+		{
+			// write results to columnar files
+			
+			Age::ColumnSink sink(param, file_pairs, file_sites);
+			
+			warn = execute(sink);
+			
+			sink.close();
+		}
+		else
 		{
-			// get batch from queue
+			// write results to streams, on writer threads
 			
-			const size_t n_queue = queue.next(simres);
+			const size_t n_files = 2 + ((run.print_cle_full) ? 1: 0) + ((run.print_ccf_full) ? 1: 0);
 			
-			if (n_queue == 0)
-				break;
+			if (resumed && state.sizes.size() != n_files)
+				throw std::runtime_error("Checkpoint does not match output files: " + file_checkpoint);
 			
+			const std::vector< uint64_t > keep = (resumed) ? state.sizes: std::vector< uint64_t >(n_files, 0); // size of output files at checkpoint
 			
-			// detect
+			Output buffer_pairs(file_pairs, run.compress, run.threads, keep[0]);
+			Output buffer_sites(file_sites, run.compress, run.threads, keep[1]);
 			
-			Age::Pair::List::iterator pair, pair_end = queue.pairs.end();
+			std::ostream stream_pairs(&buffer_pairs);
+			std::ostream stream_sites(&buffer_sites);
 			
-			if (threads > 1)
+			if (!resumed)
 			{
-				Threadpool< Age::Infer > pool(threads, &Age::Infer::run);
-				
-				size_t count = 0;
-				
-				for (pair = queue.pairs.begin(); pair != pair_end; ++pair)
-				{
-					pool.task(Age::Infer(param, method, max_miss, *pair, grid, hmm_model));
-					
-					if (++count == batch_limit)
-						break;
-				}
-				
-				pool.open(&prog, &time); // start other threads
-				pool.exec(&prog); // execute on this thread
-				pool.wait(); // wait for completion of all threads
+				Age::Pair::print_header(stream_pairs, param, false);
+				Age::Site::print_header(stream_sites, param, false);
 			}
-			else
+			
+			
+			std::unique_ptr< Output > buffer_pairs_distr;
+			std::unique_ptr< Output > buffer_sites_distr;
+			
+			std::ostream stream_pairs_distr(nullptr);
+			std::ostream stream_sites_distr(nullptr);
+			
+			std::vector< Output * > files = { &buffer_pairs, &buffer_sites };
+			
+			if (run.print_cle_full)
 			{
-				size_t count = 0;
+				buffer_sites_distr.reset(new Output(file_sites_distr, run.compress, run.threads, keep[files.size()]));
+				stream_sites_distr.rdbuf(buffer_sites_distr.get());
+				files.push_back(buffer_sites_distr.get());
 				
-				size_t x_con = 0;
-				size_t x_dis = 0;
+				if (!resumed)
+					Age::Site::print_header(stream_sites_distr, param, true);
+			}
+			
+			if (run.print_ccf_full)
+			{
+				buffer_pairs_distr.reset(new Output(file_pairs_distr, run.compress, run.threads, keep[files.size()]));
+				stream_pairs_distr.rdbuf(buffer_pairs_distr.get());
+				files.push_back(buffer_pairs_distr.get());
 				
-				for (pair = queue.pairs.begin(); pair != pair_end; ++pair)
-				{
-					if ((*pair)->sharing)
-						++x_con;
-					else
-						++x_dis;
-					
-					Age::Infer infer(param, method, max_miss, *pair, grid, hmm_model);
-					
-					prog.update();
-					
-					infer.run();
-					
-					if (++count == batch_limit)
-						break;
-				}				
+				if (!resumed)
+					Age::Pair::print_header(stream_pairs_distr, param, true);
 			}
 			
+			Age::TextSink sink(param, stream_pairs, stream_sites);
 			
-			// infer
+			sink.distr((run.print_ccf_full) ? &stream_pairs_distr: nullptr, (run.print_cle_full) ? &stream_sites_distr: nullptr);
 			
-			Age::Site::List::iterator site, site_end = queue.sites.end();
 			
-			for (site = queue.sites.begin(); site != site_end; ++site)
-			{
-				try
-				{
-					(*site)->estimate(param);
-				}
-				catch (const std::string & warning)
-				{
-					std::cerr << "Warning: " << warning << std::endl;
-					++warn;
-				}
-			}
+			// record completed sites periodically
 			
+			std::unique_ptr< Age::Checkpoint > record;
 			
-			// print sites
+			if (run.checkpoint > 0 || run.resume)
+				record.reset(new Age::Checkpoint(sink, file_checkpoint, files, run.checkpoint, fingerprint, (resumed) ? &state: nullptr));
 			
-			for (site = queue.sites.begin(); site != site_end; ++site)
-			{
-				if ((*site)->done)
-				{
-					(*site)->print(stream_sites, param->Ne, false, false); // raw
-					(*site)->print(stream_sites, param->Ne, false, true);  // adj
-					
-					if (print_cle_full)
-					{
-						(*site)->print(stream_sites_distr, param->Ne, true, false); // raw
-						(*site)->print(stream_sites_distr, param->Ne, true, true);  // adj
-					}
-					
-					
-					// print pairs
-					
-					Age::Pair::List::iterator p, p_end = (*site)->list.end();
-					
-					for (p = (*site)->list.begin(); p != p_end; ++p)
-					{
-						(*p)->print(stream_pairs, param, false);
-						
-						if (print_ccf_full)
-							(*p)->print(stream_pairs_distr, param, true);
-					}
-				}
-			}
+			if (record)
+				warn = execute(*record);
+			else
+				warn = execute(sink);
+			
+			if (!stream_pairs || !stream_sites)
+				throw std::runtime_error("Error while writing results");
+			
+			buffer_pairs.close();
+			buffer_sites.close();
+			
+			if (buffer_pairs_distr) buffer_pairs_distr->close();
+			if (buffer_sites_distr) buffer_sites_distr->close();
+			
+			if (record)
+				record->remove(); // run completed
 		}
 		
 		
@@ -16,19 +16,22 @@
 #include "LoadHMM.hpp"
 
 
-inline IBD::HMM::Model::Data load_hmm(const Gen::Grid::Data grid, const std::string & inits_file, const std::string & emiss_file, const size_t & Ne, const std::string & outfile, const bool print = false)
+inline IBD::HMM::Model::Data load_hmm(const Gen::Grid::Data grid, const std::string & inits_file, const std::string & emiss_file, const size_t & Ne, const std::string & outfile, const bool print = false, const bool verbose = true)
 {
-	std::cout << "Generating HMM probabilities from input files" << std::endl;
-	std::clog << "Generating HMM probabilities from input files"  << std::endl;
+	std::ostream to_out((verbose) ? std::cout.rdbuf(): nullptr); // progress, discarded unless verbose
+	std::ostream to_log((verbose) ? std::clog.rdbuf(): nullptr);
 	
-	std::cout << "<< " << inits_file << std::endl;
-	std::clog << "<< " << inits_file << std::endl;
+	to_out << "Generating HMM probabilities from input files" << std::endl;
+	to_log << "Generating HMM probabilities from input files"  << std::endl;
 	
-	std::cout << "<< " << emiss_file << std::endl;
-	std::clog << "<< " << emiss_file << std::endl;
+	to_out << "<< " << inits_file << std::endl;
+	to_log << "<< " << inits_file << std::endl;
 	
-	std::cout << " Effective population size,  Ne: " << Ne << std::endl;
-	std::clog << " Effective population size,  Ne: " << Ne << std::endl;
+	to_out << "<< " << emiss_file << std::endl;
+	to_log << "<< " << emiss_file << std::endl;
+	
+	to_out << " Effective population size,  Ne: " << Ne << std::endl;
+	to_log << " Effective population size,  Ne: " << Ne << std::endl;
 	
 	
 	const size_t Ns = grid->sample_size() * 2; // number of haplotypes
@@ -38,68 +41,68 @@ inline IBD::HMM::Model::Data load_hmm(const Gen::Grid::Data grid, const std::str
 	{
 		LoadHMM load(Ne, Ns);
 		
-		std::cout << std::endl;
-		std::clog << std::endl;
+		to_out << std::endl;
+		to_log << std::endl;
 		
 		// initial
 		
-		std::cout << " Initial state probabilities ... " << std::flush;
-		std::clog << " Initial state probabilities ... " << std::flush;
+		to_out << " Initial state probabilities ... " << std::flush;
+		to_log << " Initial state probabilities ... " << std::flush;
 		
 		load.make_initial(grid, inits_file);
 		
-		std::cout << "OK" << std::endl;
-		std::clog << "OK" << std::endl;
+		to_out << "OK" << std::endl;
+		to_log << "OK" << std::endl;
 		
 		
 		// emission
 		
-		std::cout << " Emission probabilities ... " << std::flush;
-		std::clog << " Emission probabilities ... " << std::flush;
+		to_out << " Emission probabilities ... " << std::flush;
+		to_log << " Emission probabilities ... " << std::flush;
 		
 		load.make_emission(grid, emiss_file);
 		
-		std::cout << "OK" << std::endl;
-		std::clog << "OK" << std::endl;
+		to_out << "OK" << std::endl;
+		to_log << "OK" << std::endl;
 		
 		
 		// transition
 		
-		std::cout << " Transition probabilities ... " << std::flush;
-		std::clog << " Transition probabilities ... " << std::flush;
+		to_out << " Transition probabilities ... " << std::flush;
+		to_log << " Transition probabilities ... " << std::flush;
 		
 		load.make_transition(grid);
 		
-		std::cout << "OK" << std::endl;
-		std::clog << "OK" << std::endl;
+		to_out << "OK" << std::endl;
+		to_log << "OK" << std::endl;
 		
-		std::cout << std::endl;
-		std::clog << std::endl;
+		to_out << std::endl;
+		to_log << std::endl;
 		
 		
 		if (print)
 		{
-			std::cout << "Writing HMM probabilities to file" << std::endl;
-			std::clog << "Writing HMM probabilities to file" << std::endl;
+			to_out << "Writing HMM probabilities to file" << std::endl;
+			to_log << "Writing HMM probabilities to file" << std::endl;
 			
 			const std::string out_inits = outfile + ".initial.txt";
 			const std::string out_emiss = outfile + ".emission.txt";
 			const std::string out_trans = outfile + ".transition.txt";
 		
-			std::cout << ">> " << out_inits << std::endl;
-			std::clog << ">> " << out_inits << std::endl;
+			to_out << ">> " << out_inits << std::endl;
+			to_log << ">> " << out_inits << std::endl;
 			load.print_initial(out_inits);
 			
-			std::cout << ">> " << out_emiss << std::endl;
-			std::clog << ">> " << out_emiss << std::endl;
+			to_out << ">> " << out_emiss << std::endl;
+			to_log << ">> " << out_emiss << std::endl;
 			load.print_emission(out_emiss);
 			
-			std::cout << ">> " << out_trans << std::endl;
-			std::clog << ">> " << out_trans << std::endl;
+			to_out << ">> " << out_trans << std::endl;
+			to_log << ">> " << out_trans << std::endl;
 			load.print_transition(out_trans);
 			
-			std::cout << std::endl;
-			std::clog << std::endl;
+			to_out << std::endl;
+			to_log << std::endl;
 		}
 		
 				
@@ -107,6 +110,9 @@ inline IBD::HMM::Model::Data load_hmm(const Gen::Grid::Data grid, const std::str
 	}
 	catch (const std::exception & error)
 	{
+		if (!verbose)
+			throw;
+		
 		std::cout << std::endl << "Error: " << error.what() << std::endl;
 		std::cerr << error.what() << std::endl << std::endl;
 		
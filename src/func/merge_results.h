@@ -0,0 +1,253 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef merge_results_h
+#define merge_results_h
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Reader.hpp"
+
+#include "AgeColumns.hpp"
+
+
+// Merge results of several runs (e.g. shards) into pairs and sites files, ordered by focal site
+//
+// Inputs are text (*.txt or *.txt.gz) or columnar (*.col) results files of pairs and/or sites.
+// Lines of each focal site are kept together and in their original order.
+
+inline void merge_results(const std::vector< std::string > & inputs, const std::string & output)
+{
+	std::cout << "Merging results files" << std::endl;
+	std::clog << "Merging results files" << std::endl;
+
+	for (const std::string & input : inputs)
+	{
+		std::cout << "<< " << input << std::endl;
+		std::clog << "<< " << input << std::endl;
+	}
+
+	std::cout << std::endl;
+	std::clog << std::endl;
+
+
+	// Text source of results
+	struct Source
+	{
+		std::string file;   // text file
+		std::string header; // first line
+		bool        temp;   // converted from input, removed when done
+	};
+
+	// Lines of focal site in source
+	struct Block
+	{
+		size_t         marker;
+		size_t         source;
+		std::streamoff begin;
+		std::streamoff end;
+	};
+
+
+	auto ends_with = [](const std::string & str, const std::string & end)
+	{
+		return (str.size() >= end.size() && str.compare(str.size() - end.size(), end.size(), end) == 0);
+	};
+
+
+	std::map< std::string, std::vector< Source > > tables; // sources per table, pairs or sites
+
+	std::vector< std::string > temps;
+
+	try
+	{
+		// convert inputs to text
+
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			Source src{ inputs[i], std::string(), false };
+
+			if (ends_with(inputs[i], ".col") || ends_with(inputs[i], ".gz"))
+			{
+				src.file = output + ".merge." + std::to_string(i) + ".tmp";
+				src.temp = true;
+
+				temps.push_back(src.file);
+
+				std::ofstream stream(src.file, std::ios::binary);
+
+				if (ends_with(inputs[i], ".col"))
+				{
+					Age::print_columns(inputs[i], stream);
+				}
+				else
+				{
+					Reader reader(inputs[i]);
+
+					while (reader.next())
+					{
+						stream << reader.line().str() << '\n';
+					}
+				}
+
+				if (!stream)
+					throw std::runtime_error("Error while writing file: " + src.file);
+			}
+
+			std::ifstream stream(src.file, std::ios::binary);
+
+			if (!stream)
+				throw std::runtime_error("Unable to open file: " + inputs[i]);
+
+			if (!std::getline(stream, src.header))
+				throw std::runtime_error("Empty results file: " + inputs[i]);
+
+			std::string table;
+
+			if (src.header.compare(0, 24, "MarkerID Clock Filtered ") == 0)
+				table = "sites";
+			else if (src.header.compare(0, 25, "MarkerID Clock SampleID0 ") == 0)
+				table = "pairs";
+			else
+				throw std::runtime_error("Unknown results file: " + inputs[i]);
+
+			if (!tables[table].empty() && tables[table].front().header != src.header)
+				throw std::runtime_error("Incompatible results files: " + inputs[i]);
+
+			tables[table].push_back(std::move(src));
+		}
+
+
+		// merge each table
+
+		std::map< std::string, std::vector< Source > >::const_iterator tab, tab_end = tables.cend();
+
+		for (tab = tables.cbegin(); tab != tab_end; ++tab)
+		{
+			const std::vector< Source > & sources = tab->second;
+
+			std::vector< Block > blocks;
+
+
+			// index lines of each focal site
+
+			for (size_t s = 0; s < sources.size(); ++s)
+			{
+				std::ifstream stream(sources[s].file, std::ios::binary);
+
+				std::string line;
+
+				std::getline(stream, line); // header
+
+				std::streamoff pos = stream.tellg();
+
+				while (std::getline(stream, line))
+				{
+					const std::streamoff end = stream.tellg();
+
+					std::istringstream iss(line);
+
+					size_t marker;
+
+					if (!(iss >> marker))
+					{
+						if (line.empty())
+						{
+							pos = end;
+							continue;
+						}
+
+						throw std::runtime_error("Unable to read line in results file: " + sources[s].file);
+					}
+
+					if (!blocks.empty() && blocks.back().source == s && blocks.back().marker == marker && blocks.back().end == pos)
+						blocks.back().end = (end < 0) ? pos + static_cast<std::streamoff>(line.size()): end; // extend
+					else
+						blocks.push_back(Block{ marker, s, pos, (end < 0) ? pos + static_cast<std::streamoff>(line.size()): end });
+
+					pos = end;
+				}
+			}
+
+			std::stable_sort(blocks.begin(), blocks.end(), [](const Block & a, const Block & b) { return a.marker < b.marker; });
+
+			for (size_t i = 1; i < blocks.size(); ++i)
+			{
+				if (blocks[i].marker == blocks[i - 1].marker)
+					throw std::runtime_error("Focal site " + std::to_string(blocks[i].marker) + " found in more than one results file");
+			}
+
+
+			// write blocks in order of focal site
+
+			const std::string file_text = output + '.' + tab->first + ".txt";
+
+			std::ofstream out(file_text, std::ios::binary);
+
+			if (!out)
+				throw std::runtime_error("Unable to create output file: " + file_text);
+
+			out << sources.front().header << '\n';
+
+			std::vector< std::ifstream > streams;
+
+			for (const Source & src : sources)
+			{
+				streams.emplace_back(src.file, std::ios::binary);
+			}
+
+			std::vector< char > buffer;
+
+			for (const Block & block : blocks)
+			{
+				std::ifstream & stream = streams[block.source];
+
+				buffer.resize(static_cast<size_t>(block.end - block.begin));
+
+				stream.clear();
+				stream.seekg(block.begin);
+				stream.read(buffer.data(), buffer.size());
+
+				out.write(buffer.data(), stream.gcount());
+
+				if (stream.gcount() > 0 && buffer[stream.gcount() - 1] != '\n')
+					out << '\n'; // last line without newline
+			}
+
+			if (!out.flush())
+				throw std::runtime_error("Error while writing output file: " + file_text);
+
+			std::cout << ">> " << file_text << " (" << blocks.size() << " sites from " << sources.size() << " files)" << std::endl;
+			std::clog << ">> " << file_text << " (" << blocks.size() << " sites from " << sources.size() << " files)" << std::endl;
+		}
+
+		std::cout << std::endl;
+		std::clog << std::endl;
+	}
+	catch (const std::exception & error)
+	{
+		for (const std::string & temp : temps)
+			std::remove(temp.c_str());
+
+		std::cout << std::endl << "Error: " << error.what() << std::endl;
+		std::cerr << error.what() << std::endl << std::endl;
+
+		throw std::runtime_error("[Terminated]");
+	}
+
+	for (const std::string & temp : temps)
+		std::remove(temp.c_str());
+}
+
+
+#endif /* merge_results_h */
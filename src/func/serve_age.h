@@ -0,0 +1,179 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef serve_age_h
+#define serve_age_h
+
+#include <algorithm>
+#include <exception>
+#include <set>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Clock.hpp"
+#include "Socket.hpp"
+
+#include "GenGrid.hpp"
+#include "GenShare.hpp"
+
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+
+// Age estimation for one batch of target positions, results as in sites file
+
+inline void serve_age_request(const Age::Param::Data param,
+							  const IBD::DetectMethod method,
+							  const decimal_t max_miss,
+							  const Gen::Grid::Data grid,
+							  const IBD::HMM::Model::Data hmm_model,
+							  const size_t threads,
+							  const size_t batch_limit,
+							  const std::string & request,
+							  std::ostream & response)
+{
+	Clock time;
+
+
+	// find target sites by position
+
+	Gen::Marker::Vector const & markers = grid->marker();
+	std::set< size_t > target;
+	std::vector< size_t > unknown;
+
+	std::istringstream stream(request);
+	std::string str;
+
+	while (stream >> str)
+	{
+		std::istringstream field(str);
+		size_t pos;
+
+		if (!(field >> pos))
+			throw std::invalid_argument("Invalid position in request: " + str);
+
+		Gen::Marker::Iterator marker = std::lower_bound(markers.cbegin(), markers.cend(), pos, [](const Gen::Marker & m, const size_t p) { return m.position < p; });
+
+		if (marker == markers.cend() || marker->position != pos)
+		{
+			std::cerr << "Warning: Target position not found: " << pos << std::endl;
+			unknown.push_back(pos);
+			continue;
+		}
+
+		target.insert(pos);
+	}
+
+
+	// stream sites through construction, inference and estimation
+
+	std::ostream discard(nullptr); // pairs are not returned
+
+	Age::Site::print_header(response, param, false);
+
+	for (size_t i = 0; i < unknown.size(); ++i)
+	{
+		response << "NotFound: " << unknown[i] << std::endl; // record in place of results
+	}
+
+	Gen::Share::Data share = std::make_shared< Gen::Share >(); // sharers of requested sites only
+
+	share->select(target, grid);
+
+	Age::Queue queue(share, grid, param);
+
+	Age::TextSink sink(param, discard, response);
+
+	Age::Pipeline pipeline(queue, param, method, max_miss, grid, hmm_model, nullptr, threads, batch_limit);
+
+	const size_t warn = pipeline.run(sink);
+
+	response << std::endl; // empty line terminates response
+
+	std::clog << " Request: " << target.size() << " sites, " << warn << " warnings, " << time.elapsed.str() << std::endl;
+}
+
+
+// Resident age estimation, batches of target positions read line by line from stdin or local socket
+
+inline void serve_age(const Age::Param::Data param,
+					  const IBD::DetectMethod method,
+					  const decimal_t max_miss,
+					  const Gen::Grid::Data grid,
+					  const IBD::HMM::Model::Data hmm_model,
+					  const std::string & socket_path, // empty for stdin
+					  std::ostream & output, // responses to stdin requests, nothing else is written to it
+					  const size_t threads = 1,
+					  const size_t batch_limit = 1000)
+{
+	static const std::string quit = "quit";
+
+	std::cout << "Serving age estimation requests" << std::endl;
+	std::clog << "Serving age estimation requests" << std::endl;
+
+	std::cout << "<< " << ((socket_path.empty()) ? std::string("stdin"): socket_path) << std::endl;
+	std::clog << "<< " << ((socket_path.empty()) ? std::string("stdin"): socket_path) << std::endl;
+
+	std::cout << std::endl;
+	std::clog << std::endl;
+
+
+	// one response per request line, errors are reported in place of results
+
+	auto answer = [&](const std::string & request, std::ostream & response)
+	{
+		try
+		{
+			serve_age_request(param, method, max_miss, grid, hmm_model, threads, batch_limit, request, response);
+		}
+		catch (const std::exception & error)
+		{
+			std::cerr << error.what() << std::endl;
+
+			response << "Error: " << error.what() << std::endl << std::endl;
+		}
+	};
+
+
+	std::string request;
+
+	if (socket_path.empty())
+	{
+		while (std::getline(std::cin, request))
+		{
+			if (request == quit)
+				break;
+
+			answer(request, output);
+
+			output << std::flush;
+		}
+
+		return;
+	}
+
+
+	Socket socket(socket_path);
+
+	while (socket.accept())
+	{
+		while (socket.read(request))
+		{
+			if (request == quit)
+				return;
+
+			std::ostringstream response;
+
+			answer(request, response);
+
+			if (!socket.write(response.str()))
+				break;
+		}
+	}
+}
+
+
+#endif /* serve_age_h */
@@ -0,0 +1,188 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef simulate_bin_h
+#define simulate_bin_h
+
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "Clock.hpp"
+#include "Progress.hpp"
+#include "Gen.hpp"
+#include "GenGrid.hpp"
+#include "GenSimulate.hpp"
+
+
+inline std::string simulate_bin(const Gen::Simulate::Param & param, const std::string & outfile, const size_t & buffer_limit, const bool compress = false, const bool local_tmp = false)
+{
+	std::cout << "Generating synthetic haplotype panel" << std::endl;
+	std::clog << "Generating synthetic haplotype panel" << std::endl;
+
+
+	const std::string grid_file  = outfile + ".bin"; // filename
+	const std::string map_file   = outfile + ".sim.map.txt";
+	const std::string age_file   = outfile + ".sim.age.txt";
+	const std::string truth_file = outfile + ".sim.truth.txt";
+
+	std::cout << ">> " << grid_file << std::endl;
+	std::clog << ">> " << grid_file << std::endl;
+
+	std::cout << ">> " << map_file << std::endl;
+	std::clog << ">> " << map_file << std::endl;
+
+	std::cout << ">> " << age_file << std::endl;
+	std::clog << ">> " << age_file << std::endl;
+
+	if (param.truth_sites > 0)
+	{
+		std::cout << ">> " << truth_file << std::endl;
+		std::clog << ">> " << truth_file << std::endl;
+	}
+
+	std::cout << std::endl;
+	std::clog << std::endl;
+
+
+	try
+	{
+		Clock time;
+		Gen::Simulate simulate(param);
+
+		const size_t sample_size = param.samples;
+		const size_t window_size = std::min(buffer_limit, param.markers);
+		const size_t buffer_size = static_cast<size_t>(static_cast<double>(sample_size * window_size) / static_cast<double>(1024 * 1024 * sizeof(Gen::value_t)));
+
+		std::cout << " Sample size: " << sample_size << " individuals" << std::endl;
+		std::clog << " Sample size: " << sample_size << " individuals" << std::endl;
+
+		std::cout << " Marker size: " << param.markers << " variants" << std::endl;
+		std::clog << " Marker size: " << param.markers << " variants" << std::endl;
+
+		std::cout << " Ne: " << param.Ne << ", mutation rate: " << param.mut << ", recombination rate: " << param.rec << ", missing: " << param.missing << std::endl;
+		std::clog << " Ne: " << param.Ne << ", mutation rate: " << param.mut << ", recombination rate: " << param.rec << ", missing: " << param.missing << std::endl;
+
+		std::cout << " Buffer window size: " << window_size << " variants (~" << buffer_size << " Mb)" << std::endl;
+		std::clog << " Buffer window size: " << window_size << " variants (~" << buffer_size << " Mb)" << std::endl;
+
+		std::cout << std::endl;
+		std::clog << std::endl;
+
+
+		// genetic map
+
+		{
+			std::ofstream stream(map_file);
+
+			if (!stream)
+				throw std::runtime_error("Unable to create output file: " + map_file);
+
+			simulate.print_map(stream);
+		}
+
+
+		// truth file
+
+		std::unique_ptr< std::ofstream > truth;
+
+		if (param.truth_sites > 0)
+		{
+			truth.reset(new std::ofstream(truth_file));
+
+			if (!(*truth))
+				throw std::runtime_error("Unable to create output file: " + truth_file);
+
+			Gen::Simulate::print_truth_header(*truth);
+		}
+
+
+		// make new grid
+
+		Gen::Grid::Make buffer(grid_file, sample_size, window_size, compress);
+
+		std::clog << " Running" << std::endl;
+
+		Progress progress(param.markers, "variants");
+
+		size_t ntmp = 0; // number of temporary files
+
+		while (simulate.next(buffer, truth.get()))
+		{
+			progress.update();
+
+			if (buffer.full)
+			{
+				progress.halt();
+
+				std::cout << " Saving buffer to temporary file ..." << std::flush;
+				std::clog << " Saving buffer to temporary file ..." << std::flush;
+
+				buffer.save(local_tmp);
+				++ntmp;
+
+				std::cout << " OK" << std::endl;
+				std::clog << " OK" << std::endl;
+			}
+		}
+
+
+		// concatenate files
+
+		progress.halt();
+
+		if (ntmp == 0)
+		{
+			std::cout << " Writing output file ..." << std::flush;
+			std::clog << " Writing output file ..." << std::flush;
+		}
+		else
+		{
+			std::cout << " Combining temporary files ..." << std::flush;
+			std::clog << " Combining temporary files ..." << std::flush;
+		}
+
+		buffer.finish(simulate.sample, simulate.marker);
+
+		std::cout << " OK" << std::endl;
+		std::clog << " OK" << std::endl;
+
+
+		// age of mutations
+
+		{
+			std::ofstream stream(age_file);
+
+			if (!stream)
+				throw std::runtime_error("Unable to create output file: " + age_file);
+
+			simulate.print_age(stream);
+		}
+
+		if (truth && !truth->flush())
+			throw std::runtime_error("Error while writing output file: " + truth_file);
+
+
+		progress.finish();
+		std::clog << " Done" << std::endl;
+		time.print(std::clog);
+	}
+	catch (const std::exception & error)
+	{
+		std::cout << std::endl << "Error: " << error.what() << std::endl;
+		std::cerr << error.what() << std::endl << std::endl;
+
+		throw std::runtime_error("[Terminated]");
+	}
+
+
+	return grid_file;
+}
+
+
+#endif /* simulate_bin_h */
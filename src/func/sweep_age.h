@@ -0,0 +1,150 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef sweep_age_h
+#define sweep_age_h
+
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Progress.hpp"
+#include "Output.hpp"
+
+#include "GenGrid.hpp"
+#include "GenShare.hpp"
+
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+#include "AgeSweep.hpp"
+
+
+// Age estimation under several combinations of effective size and mutation rate, in a single pass
+//
+// Results of each combination are written to NAME.<label>.pairs.txt and NAME.<label>.sites.txt, e.g. NAME.Ne10000.mut1e-08.sites.txt
+
+inline void sweep_age(const Age::Sweep::Data sweep,
+					  const IBD::DetectMethod method,
+					  const decimal_t max_miss,
+					  const std::string & output,
+					  const Gen::Share::Data share,
+					  const Gen::Grid::Data grid,
+					  const size_t threads = 1,
+					  const size_t batch_limit = 1000, // max. number of pairs queued for workers
+					  const bool compress = false) // BGZF compressed text output
+{
+	std::cout << "Age estimation, using " << IBD::HMM::name << ", parameter sweep" << std::endl;
+	std::clog << "Age estimation, using " << IBD::HMM::name << ", parameter sweep" << std::endl;
+
+	const std::string file_gzip = (compress) ? ".gz": "";
+
+	for (size_t k = 0; k < sweep->size(); ++k)
+	{
+		const std::string prefix = output + '.' + sweep->at(k).label;
+
+		std::cout << ">> " << prefix << ".pairs.txt" << file_gzip << " + " << prefix << ".sites.txt" << file_gzip << std::endl;
+		std::clog << ">> " << prefix << ".pairs.txt" << file_gzip << " + " << prefix << ".sites.txt" << file_gzip << std::endl;
+	}
+
+	std::cout << std::endl;
+	std::clog << std::endl;
+
+	std::cout << " # parameter combinations = " << sweep->size() << std::endl;
+	std::clog << " # parameter combinations = " << sweep->size() << std::endl;
+
+	if (threads > 1)
+	{
+		std::cout << " # threads = " << threads << std::endl;
+		std::clog << " # threads = " << threads << std::endl;
+	}
+
+
+	try
+	{
+		const Age::Param::Data param = sweep->at(0).param;
+
+
+		// queue for detection and inference, sites and pairs selected once
+
+		Age::Queue queue(share, grid, param);
+
+		std::cout << " # pairwise analyses = " << queue.size() << " (x" << sweep->size() << ")" << std::endl;
+		std::clog << " # pairwise analyses = " << queue.size() << " (x" << sweep->size() << ")" << std::endl;
+
+		std::cout << std::endl;
+		std::clog << std::endl;
+
+
+		// output files per combination
+
+		std::vector< std::unique_ptr< Output > >        buffers;
+		std::vector< std::unique_ptr< std::ostream > >  streams;
+		std::vector< std::unique_ptr< Age::TextSink > > sinks;
+
+		std::vector< Age::Sink * > targets;
+
+		for (size_t k = 0; k < sweep->size(); ++k)
+		{
+			const std::string prefix = output + '.' + sweep->at(k).label;
+
+			buffers.emplace_back(new Output(prefix + ".pairs.txt" + file_gzip, compress, threads));
+			streams.emplace_back(new std::ostream(buffers.back().get()));
+
+			buffers.emplace_back(new Output(prefix + ".sites.txt" + file_gzip, compress, threads));
+			streams.emplace_back(new std::ostream(buffers.back().get()));
+
+			std::ostream & stream_pairs = *streams[streams.size() - 2];
+			std::ostream & stream_sites = *streams[streams.size() - 1];
+
+			Age::Pair::print_header(stream_pairs, sweep->at(k).param, false);
+			Age::Site::print_header(stream_sites, sweep->at(k).param, false);
+
+			sinks.emplace_back(new Age::TextSink(sweep->at(k).param, stream_pairs, stream_sites));
+
+			targets.push_back(sinks.back().get());
+		}
+
+
+		// stream sites through construction, inference, estimation and output
+
+		Progress prog(queue.size());
+
+		Age::Pipeline pipeline(queue, param, method, max_miss, grid, sweep->at(0).model, nullptr, threads, batch_limit, 0, sweep);
+
+		Age::SweepSink sink(targets);
+
+		const size_t warn = pipeline.run(sink, &prog);
+
+		for (size_t i = 0; i < streams.size(); ++i)
+		{
+			if (!*streams[i])
+				throw std::runtime_error("Error while writing results");
+
+			buffers[i]->close();
+		}
+
+		prog.finish();
+
+		if (warn > 0)
+		{
+			std::cout << "[" << warn << " warnings - please check error file]" << std::endl;
+		}
+
+		std::cout << std::endl;
+		std::clog << std::endl;
+	}
+	catch (const std::exception & error)
+	{
+		std::cout << std::endl << "Error: " << error.what() << std::endl;
+		std::cerr << error.what() << std::endl << std::endl;
+
+		throw std::runtime_error("[Terminated]");
+	}
+}
+
+
+#endif /* sweep_age_h */
@@ -0,0 +1,150 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "GenColumns.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+using namespace Gen;
+
+
+// construct
+
+Columns::Columns(const Marker::Vector & markers, const size_t haplotypes)
+: Nm(markers.size())
+, Nh(haplotypes)
+, pos(markers.size())
+, gen(markers.size())
+, cnt(markers.size())
+, base_bytes(Memory::MARKER_COLUMN)
+, derived_bytes(Memory::MARKER_COLUMN)
+, scaled_bytes(Memory::MARKER_COLUMN)
+{
+	if (this->Nh == 0)
+	{
+		throw std::invalid_argument("Marker columns require a non-empty sample");
+	}
+
+	for (size_t i = 0; i < this->Nm; ++i)
+	{
+		Marker const & marker = markers[i];
+
+		if (marker.position > std::numeric_limits< uint32_t >::max() || marker.hap_count[H1] > this->Nh)
+		{
+			throw std::out_of_range("Unexpected marker attributes: " + marker.str());
+		}
+
+		this->pos[i] = static_cast<uint32_t>(marker.position);
+		this->gen[i] = marker.gen_dist;
+		this->cnt[i] = static_cast<uint32_t>(marker.hap_count[H1]);
+	}
+
+	this->base_bytes.set(this->Nm * (sizeof(uint32_t) + sizeof(decimal_t) + sizeof(uint32_t)));
+}
+
+
+// return number of markers/haplotypes
+
+size_t Columns::size() const
+{
+	return this->Nm;
+}
+
+size_t Columns::haplotypes() const
+{
+	return this->Nh;
+}
+
+
+// return per-marker columns
+
+Columns::column_t< uint32_t > const & Columns::position() const
+{
+	return this->pos;
+}
+
+Columns::column_t< decimal_t > const & Columns::gen_dist() const
+{
+	return this->gen;
+}
+
+Columns::column_t< uint32_t > const & Columns::fk() const
+{
+	return this->cnt;
+}
+
+
+// return columns derived on first access
+
+Columns::column_t< decimal_t > const & Columns::log_het() const
+{
+	this->derive();
+	return this->het;
+}
+
+Columns::column_t< decimal_t > const & Columns::log_hom() const
+{
+	this->derive();
+	return this->hom;
+}
+
+Columns::column_t< decimal_t > const & Columns::cum_log_hom() const
+{
+	this->derive();
+	return this->cum;
+}
+
+Columns::column_t< decimal_t > const & Columns::distance(const decimal_t scale) const
+{
+	std::lock_guard< std::mutex > lock(this->guard);
+	
+	std::unique_ptr< column_t< decimal_t > > & column = this->scaled[ scale ];
+	
+	if (!column)
+	{
+		column.reset(new column_t< decimal_t >(this->Nm));
+		
+		for (size_t i = 0; i < this->Nm; ++i)
+		{
+			(*column)[i] = this->gen[i] * scale;
+		}
+		
+		this->scaled_bytes.add(this->Nm * sizeof(decimal_t));
+	}
+	
+	return *column;
+}
+
+
+// derive frequency dependent columns
+
+void Columns::derive() const
+{
+	std::call_once(this->derived, [this]()
+	{
+		this->het.resize(this->Nh + 1, decimal_nil);
+		this->hom.resize(this->Nh + 1, decimal_nil);
+
+		for (size_t k = 0; k <= this->Nh; ++k)
+		{
+			const decimal_t frequency = static_cast<decimal_t>(k) / static_cast<decimal_t>(this->Nh);
+
+			this->het[k] = std::log(decimal_two * frequency * (decimal_one - frequency));
+
+			this->hom[k] = std::log(std::pow(frequency, decimal_two) + std::pow(decimal_one - frequency, decimal_two));
+		}
+
+		this->cum.resize(this->Nm, decimal_nil);
+
+		for (size_t i = 0; i < this->Nm; ++i)
+		{
+			this->cum[i] = ((i == 0) ? decimal_nil: this->cum[i - 1]) + this->hom[ this->cnt[i] ];
+		}
+
+		this->derived_bytes.set((this->het.size() + this->hom.size() + this->cum.size()) * sizeof(decimal_t));
+	});
+}
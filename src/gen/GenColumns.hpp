@@ -0,0 +1,112 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef GenColumns_hpp
+#define GenColumns_hpp
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Aligned.h"
+#include "Decimal.h"
+#include "Memory.hpp"
+
+#include "Gen.hpp"
+#include "GenMarker.hpp"
+
+
+namespace Gen
+{
+	// Marker attributes of a grid, stored by column
+	//
+	// Built once per grid and shared by the estimation parameters and the HMM; immutable once built.
+	// Attributes that depend on the allele count only are kept per count (fk), not per marker, and
+	// columns used by age estimation alone are derived on first access.
+	class Columns
+	{
+	public:
+
+		using Data = std::shared_ptr< const Columns >;
+
+		template < typename T >
+		using column_t = std::vector< T, Aligned< T > >;
+
+
+		// Column converted to decimal on access
+		template < typename T >
+		class View
+		{
+		public:
+
+			// construct
+			View(const column_t< T > & _data)
+			: data(&_data)
+			{}
+
+			// return value
+			decimal_t at(const size_t i) const { return static_cast<decimal_t>(this->data->at(i)); }
+			decimal_t operator [] (const size_t i) const { return static_cast<decimal_t>((*this->data)[i]); }
+
+			// return size
+			size_t size() const { return this->data->size(); }
+
+		private:
+
+			const column_t< T > * data;
+		};
+
+
+		// construct, from markers and number of haplotypes
+		Columns(const Marker::Vector &, const size_t);
+
+		// return number of markers/haplotypes
+		size_t size() const;
+		size_t haplotypes() const;
+
+		// return per-marker columns
+		column_t< uint32_t >  const & position() const; // physical position
+		column_t< decimal_t > const & gen_dist() const; // genetic distance (cM)
+		column_t< uint32_t >  const & fk() const;       // allele count (H1)
+
+		// return columns derived on first access
+		column_t< decimal_t > const & log_het() const;     // per allele count, log probability of heterozygote
+		column_t< decimal_t > const & log_hom() const;     // per allele count, log probability of homozygote
+		column_t< decimal_t > const & cum_log_hom() const; // per marker, cumulative sum of log_hom
+		column_t< decimal_t > const & distance(const decimal_t) const; // per marker, genetic distance times scale (e.g. 4Ne/100)
+
+
+	private:
+
+		// derive frequency dependent columns
+		void derive() const;
+
+
+		const size_t Nm; // number of markers
+		const size_t Nh; // number of haplotypes
+
+		column_t< uint32_t >  pos;
+		column_t< decimal_t > gen;
+		column_t< uint32_t >  cnt;
+
+		mutable column_t< decimal_t > het;
+		mutable column_t< decimal_t > hom;
+		mutable column_t< decimal_t > cum;
+
+		mutable std::map< decimal_t, std::unique_ptr< column_t< decimal_t > > > scaled; // per scale
+
+		mutable std::once_flag derived;
+		mutable std::mutex     guard;
+
+		Memory::Account base_bytes;            // tracked size of per-marker columns
+		mutable Memory::Account derived_bytes; // tracked size of derived columns
+		mutable Memory::Account scaled_bytes;  // tracked size of scaled distances
+	};
+}
+
+
+#endif /* GenColumns_hpp */
@@ -5,6 +5,8 @@
 
 #include "GenGrid.hpp"
 
+#include "Metrics.hpp"
+
 
 using namespace Gen;
 
@@ -17,6 +19,7 @@ const char Grid::checkpoint[4] = { 0x25, 0x50, 0x4b, 0x41 };
 
 Grid::Grid(const std::string & filename)
 : source(filename, Binary::mode::READ)
+, buffer_bytes(Memory::SAMPLE_CACHE)
 {
 	this->load();
 	this->load_sample();
@@ -35,12 +38,15 @@ Grid::Grid(Grid && other) // move
 , buffer(std::move(other.buffer))
 , buffer_limit(other.buffer_limit)
 , buffer_count(other.buffer_count)
+, buffer_bytes(std::move(other.buffer_bytes))
 , sample_list(std::move(other.sample_list))
 , marker_list(std::move(other.marker_list))
+, column_store(std::move(other.column_store))
 {}
 
 Grid::Grid(Binary && bin)
 : source(std::move(bin))
+, buffer_bytes(Memory::SAMPLE_CACHE)
 {
 	this->load();
 }
@@ -77,19 +83,34 @@ Grid::Vector Grid::read(const Sample::Key & key, const bool decompress)
 }
 
 
+// position of sequential reader
+
+Grid::Cursor::Cursor()
+: marker(0)
+, offset(0)
+, repeat(0)
+, value(0)
+{}
+
+
 // fetch from cache
 
 Variant::Vector::Data Grid::get(const Sample::Key & key)
 {
+	Metrics::Scope scope(Metrics::GRID_GET);
+	
 	guard_t lock(this->guard);
 	
 	Variant::Vector::Data & ptr = this->buffer.at(key.value);
 	
 	if (ptr)
 	{
+		Metrics::count(Metrics::CACHE_HITS);
 		return ptr;
 	}
 	
+	Metrics::count(Metrics::CACHE_MISSES);
+	
 	this->prune();
 	
 	this->source.jump(key);
@@ -103,6 +124,8 @@ Variant::Vector::Data Grid::get(const Sample::Key & key)
 	
 	this->source.read<Bin1>(raw.data(), raw_length); // data vector
 	
+	Metrics::count(Metrics::BYTES_READ, 4 + 3 * sizeof(Bin4) + raw_length);
+	
 	if (this->compression)
 	{
 		Vector out = decompress_genotype_vector(raw, raw_length, out_length);
@@ -119,10 +142,91 @@ Variant::Vector::Data Grid::get(const Sample::Key & key)
 
 	++this->buffer_count;
 	
+	this->buffer_bytes.set(this->buffer_count * (this->size_marker * (1 + ploidy) * sizeof(value_t) + (this->size_marker + 63) / 64 * sizeof(uint64_t))); // genotypes, haplotypes and missing mask
+	
 	return ptr;
 }
 
 
+// read genotypes of markers in range, resuming from cursor
+
+void Grid::span(const Sample::Key & key, Cursor & at, const size_t begin, const size_t end, gen_vector_t & out)
+{
+	static constexpr value_t off = static_cast<value_t>(CHAR_BIT * sizeof(value_t) / 2);
+	static constexpr value_t max = static_cast<value_t>((off << 2) - 1);
+	static constexpr value_t inv = ~max;
+	
+	Metrics::Scope scope(Metrics::GRID_GET);
+	
+	guard_t lock(this->guard);
+	
+	out.resize(end - begin);
+	
+	const Variant::Vector::Data & ptr = this->buffer.at(key.value);
+	
+	if (ptr)
+	{
+		Metrics::count(Metrics::CACHE_HITS);
+		std::copy(ptr->gen().begin() + begin, ptr->gen().begin() + end, out.begin());
+		return;
+	}
+	
+	Metrics::count(Metrics::CACHE_MISSES);
+	
+	if (begin < at.marker) // restart from begin of vector
+		at = Cursor();
+	
+	this->source.jump(key);
+	this->source.match<char>(checkpoint, 4);
+	this->source.match<Bin4>(key.value);
+	
+	const size_t out_length = this->source.read<Bin4, size_t>(); // marker size
+	const size_t raw_length = this->source.read<Bin4, size_t>(); // length
+	
+	if (end > out_length)
+		throw std::runtime_error("Marker range exceeds data vector");
+	
+	if (! this->compression)
+	{
+		this->source.skip<Bin1>(begin);
+		this->source.read<Bin1>(out.data(), end - begin);
+		
+		Metrics::count(Metrics::BYTES_READ, end - begin);
+		
+		at.marker = end;
+		return;
+	}
+	
+	this->source.skip<Bin1>(at.offset);
+	
+	const size_t first = at.offset;
+	
+	for (size_t m = at.marker; m < end; ++m)
+	{
+		if (at.repeat == 0)
+		{
+			if (at.offset == raw_length)
+				throw std::runtime_error("Unable to decompress data vector");
+			
+			const value_t v = this->source.read<Bin1, value_t>();
+			
+			at.value  = unmake_compressed(v & max);
+			at.repeat = ((v & inv) >> off) + 1;
+			++at.offset;
+		}
+		
+		if (m >= begin)
+			out[m - begin] = at.value;
+		
+		--at.repeat;
+	}
+	
+	Metrics::count(Metrics::BYTES_READ, at.offset - first);
+	
+	at.marker = end;
+}
+
+
 // limit cache size
 
 void Grid::cache(const size_t max)
@@ -159,6 +263,8 @@ void Grid::prune()
 			if (this->buffer_count == this->buffer_limit)
 				break;
 		}
+		
+		this->buffer_bytes.set(this->buffer_count * (this->size_marker * (1 + ploidy) * sizeof(value_t) + (this->size_marker + 63) / 64 * sizeof(uint64_t)));
 	}
 }
 
@@ -189,6 +295,21 @@ Marker::Vector const & Grid::marker() const
 }
 
 
+// get marker attributes by column, built on first access
+
+Columns::Data Grid::columns()
+{
+	guard_t lock(this->guard);
+	
+	if (!this->column_store)
+	{
+		this->column_store = std::make_shared< const Columns >(this->marker_list, this->size_sample * ploidy);
+	}
+	
+	return this->column_store;
+}
+
+
 // print samples/markers
 
 void Grid::print_sample(std::ostream & stream) const
@@ -18,11 +18,13 @@
 #include "Random.h"
 
 #include "Binary.hpp"
+#include "Memory.hpp"
 
 #include "Gen.hpp"
 #include "GenSample.hpp"
 #include "GenMarker.hpp"
 #include "GenVariant.hpp"
+#include "GenColumns.hpp"
 
 
 namespace Gen
@@ -38,6 +40,18 @@ namespace Gen
 		using Vector = value_vector_t; // vector of genotypes
 		
 		
+		// Position of sequential reader in data vector of an individual
+		struct Cursor
+		{
+			Cursor();
+			
+			size_t marker; // next marker to be decoded
+			size_t offset; // next value to be read from data vector
+			size_t repeat; // remaining repeats of current genotype
+			gen_t  value;  // current genotype
+		};
+		
+		
 		// constructs
 		Grid(const std::string &);
 		Grid(Grid &&); // move
@@ -50,6 +64,9 @@ namespace Gen
 		// fetch from cache
 		Variant::Vector::Data get(const Sample::Key &);
 		
+		// read genotypes of markers in range [begin, end), resuming from cursor
+		void span(const Sample::Key &, Cursor &, const size_t, const size_t, gen_vector_t &);
+		
 		// limit cache size
 		void cache(const size_t = 0);
 		
@@ -62,6 +79,9 @@ namespace Gen
 		Sample::Vector const & sample() const;
 		Marker::Vector const & marker() const;
 		
+		// get marker attributes by column, built on first access
+		Columns::Data columns();
+		
 		// return sample/marker size
 		size_t sample_size() const { return this->size_sample; }
 		size_t marker_size() const { return this->size_marker; }
@@ -108,9 +128,13 @@ namespace Gen
 		size_t buffer_limit; // max cache size
 		size_t buffer_count; // current cache count
 		
+		Memory::Account buffer_bytes; // tracked size of cache
+		
 		Sample::Vector sample_list; // vector of sample information
 		Marker::Vector marker_list; // vector of marker information
 		
+		Columns::Data column_store; // marker attributes by column
+		
 		std::mutex guard; // mutex lock
 		
 		// constant char sequence as identifier for binary file navigation
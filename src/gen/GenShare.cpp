@@ -464,7 +464,7 @@ void Share::subset_sites_index(Index & index, const size_t & max)
 		its.push_back(it);
 	}
 	
-	std::shuffle(its.begin(), its.end(), random_generator);
+	std::shuffle(its.begin(), its.end(), random_generator());
 	
 	
 	Index::Sites sub_sites;
@@ -509,7 +509,7 @@ void Share::subset_pairs_index(Index & index, const size_t & max)
 		its.push_back(it);
 	}
 	
-	std::shuffle(its.begin(), its.end(), random_generator);
+	std::shuffle(its.begin(), its.end(), random_generator());
 	
 	
 	Index::Pairs sub_pairs;
@@ -0,0 +1,507 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "GenSimulate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+
+using namespace Gen;
+
+
+namespace
+{
+	static constexpr size_t    map_window = 10000; // bp over which recombination rate is constant
+	static constexpr decimal_t map_spread = 1.0;   // log-normal spread of recombination rate between windows
+
+	static const char nucleotide[4] = { 'A', 'C', 'G', 'T' };
+}
+
+
+
+// Parameters
+
+Simulate::Param::Param(const size_t _samples, const size_t _markers)
+: samples(_samples)
+, markers(_markers)
+, Ne(10000)
+, mut(1e-08)
+, rec(1e-08)
+, missing(0.0)
+, truth_sites(0)
+, truth_pairs(100)
+, chromosome(1)
+{}
+
+
+
+// Synthetic haplotype panel
+
+// construct, draws marker positions and genetic map
+
+Simulate::Simulate(const Param & _param)
+: param(_param)
+, random(_param.samples, _param.markers)
+, current(0)
+, stride(0)
+, focal(0)
+, gap(std::numeric_limits<size_t>::max())
+{
+	if (this->param.samples < 1 || this->param.markers < 1)
+		throw std::invalid_argument("Simulated panel requires at least one individual and one marker");
+
+	if (this->param.markers >= std::numeric_limits<uint32_t>::max() || this->param.samples * 2 >= std::numeric_limits<uint32_t>::max())
+		throw std::invalid_argument("Simulated panel exceeds maximum size");
+
+	if (this->param.Ne == 0 || this->param.mut <= 0.0 || this->param.rec < 0.0)
+		throw std::invalid_argument("Invalid population parameters for simulation");
+
+	if (this->param.missing < 0.0 || this->param.missing >= 1.0)
+		throw std::invalid_argument("Invalid proportion of missing genotypes: " + std::to_string(this->param.missing));
+
+
+	const size_t    n  = this->param.samples * 2;
+	const decimal_t Ne = static_cast<decimal_t>(this->param.Ne);
+
+
+	// samples
+
+	this->sample.resize(this->param.samples);
+
+	for (size_t i = 0; i < this->param.samples; ++i)
+	{
+		this->sample[i].label = "SIM" + std::to_string(i + 1);
+		this->sample[i].phase = true;
+	}
+
+
+	// levels, sized from present to root; expected time when k lineages remain, 4Ne (1/k - 1/n)
+
+	std::vector< size_t > size(1, n);
+
+	while (size.back() > 1)
+		size.push_back((size.back() + branching - 1) / branching);
+
+	std::reverse(size.begin(), size.end());
+
+	this->level.resize(size.size());
+
+	for (size_t j = 0; j < size.size(); ++j)
+	{
+		Level & L = this->level[j];
+
+		L.size = size[j];
+		L.time = 4.0 * Ne * (1.0 / static_cast<decimal_t>(size[j]) - 1.0 / static_cast<decimal_t>(n));
+		L.rate = 0.0;
+
+		L.der.assign(L.size, 0);
+
+		if (j > 0)
+		{
+			const decimal_t K = static_cast<decimal_t>(size[j - 1]);
+
+			// recombination on branch to level above, switches to same ancestor are ignored
+			L.rate = (this->level[j - 1].time - L.time) * ((K - 1.0) / K) / 100.0;
+		}
+	}
+
+
+	// positions, expected density of segregating sites is 4Ne mut sum(1/i)
+
+	decimal_t harmonic = 0.0;
+
+	for (size_t i = 1; i < n; ++i)
+		harmonic += 1.0 / static_cast<decimal_t>(i);
+
+	std::exponential_distribution< decimal_t > spacing(4.0 * Ne * this->param.mut * std::max(harmonic, 1.0));
+	std::normal_distribution< decimal_t >      spread(-0.5 * map_spread * map_spread, map_spread);
+
+	this->position.resize(this->param.markers);
+	this->rate.resize(this->param.markers);
+	this->dist.resize(this->param.markers);
+
+	size_t    pos    = 0;
+	size_t    window = std::numeric_limits<size_t>::max();
+	decimal_t factor = 1.0;
+
+	for (size_t m = 0; m < this->param.markers; ++m)
+	{
+		pos += std::max(size_t(1), static_cast<size_t>(std::llround(spacing(this->random))));
+
+		if (pos / map_window != window)
+		{
+			window = pos / map_window;
+			factor = std::exp(spread(this->random)); // mean 1
+		}
+
+		this->position[m] = pos;
+		this->rate[m]     = this->param.rec * 1e8 * factor; // cM/Mb
+		this->dist[m]     = (m == 0) ? 0.0: this->dist[m - 1] + this->rate[m - 1] * static_cast<decimal_t>(this->position[m] - this->position[m - 1]) / 1e6;
+	}
+
+	this->branch.reserve(this->param.markers);
+	this->marker.reserve(this->param.markers);
+
+
+	// mutations on branch to level above, weighted by total branch length per level
+
+	std::vector< decimal_t > weight(this->level.size(), 0.0);
+
+	for (size_t j = 1; j < this->level.size(); ++j)
+		weight[j] = static_cast<decimal_t>(this->level[j].size) * (this->level[j - 1].time - this->level[j].time);
+
+	this->pick_level = std::discrete_distribution< size_t >(weight.cbegin(), weight.cend());
+
+
+	// initial sources
+
+	for (size_t j = 1; j < this->level.size(); ++j)
+	{
+		Level & L = this->level[j];
+
+		std::uniform_int_distribution< uint32_t > pick(0, static_cast<uint32_t>(this->level[j - 1].size - 1));
+
+		L.src.resize(L.size);
+		L.beg.assign(L.size, 0);
+		L.end.resize(L.size);
+
+		for (size_t h = 0; h < L.size; ++h)
+		{
+			L.src[h] = pick(this->random);
+			L.end[h] = this->next_switch(L, 0);
+		}
+	}
+
+
+	// focal sites and missing genotypes
+
+	if (this->param.truth_sites > 0)
+	{
+		this->stride = std::max(size_t(1), this->param.markers / this->param.truth_sites);
+		this->focal  = this->stride / 2;
+	}
+
+	if (this->param.missing > 0.0)
+	{
+		this->gap = std::geometric_distribution< size_t >(this->param.missing)(this->random);
+	}
+}
+
+
+// generate next marker, returns false when all markers are generated
+
+bool Simulate::next(Grid::Make & buffer, std::ostream * stream)
+{
+	const size_t m = this->current;
+
+	if (m == this->param.markers)
+		return false;
+
+	const size_t n = this->param.samples * 2;
+	const size_t L = this->level.size() - 1;
+
+
+	// switch ancestors
+
+	if (m > 0)
+	{
+		for (size_t j = 1; j <= L; ++j)
+		{
+			Level & lv = this->level[j];
+
+			const uint32_t K = static_cast<uint32_t>(this->level[j - 1].size);
+
+			for (size_t h = 0; h < lv.size; ++h)
+			{
+				if (lv.end[h] != m)
+					continue;
+
+				const uint32_t r = std::uniform_int_distribution< uint32_t >(0, K - 2)(this->random);
+
+				lv.src[h] = (r >= lv.src[h]) ? r + 1: r;
+				lv.beg[h] = static_cast<uint32_t>(m);
+				lv.end[h] = this->next_switch(lv, m);
+			}
+		}
+	}
+
+
+	// place mutation on branch
+
+	size_t j = L;
+	size_t k = 0;
+
+	for (size_t attempt = 0; attempt < 100; ++attempt)
+	{
+		j = this->pick_level(this->random);
+		k = this->mutate(j, std::uniform_int_distribution< size_t >(0, this->level[j].size - 1)(this->random));
+
+		if (k > 0 && k < n)
+			break;
+	}
+
+	if (k == 0 || k == n) // singleton
+	{
+		j = L;
+		k = this->mutate(j, std::uniform_int_distribution< size_t >(0, n - 1)(this->random));
+	}
+
+	this->branch.push_back(static_cast<uint8_t>(j));
+
+
+	// genotypes
+
+	Marker M;
+
+	const std::vector< uint8_t > & der = this->level[L].der;
+
+	for (size_t i = 0; i < this->param.samples; ++i)
+	{
+		gen_t gt = make_genotype(der[2 * i] ? '1': '0', der[2 * i + 1] ? '1': '0', true);
+
+		if (this->gap == 0)
+		{
+			gt = make_genotype('.', '.', true);
+
+			this->gap = std::geometric_distribution< size_t >(this->param.missing)(this->random);
+		}
+		else if (this->param.missing > 0.0)
+		{
+			--this->gap;
+		}
+
+		buffer.insert(gt);
+
+		M.count(gt);
+	}
+
+	if (!buffer.good)
+	{
+		throw std::runtime_error("Unexpected buffer error");
+	}
+
+	const size_t ref = std::uniform_int_distribution< size_t >(0, 3)(this->random);
+	const size_t alt = (ref + 1 + std::uniform_int_distribution< size_t >(0, 2)(this->random)) % 4;
+
+	M.label      = ".";
+	M.chromosome = this->param.chromosome;
+	M.position   = this->position[m];
+	M.allele.parse(std::string{ nucleotide[ref], ',', nucleotide[alt] });
+	M.rec_rate   = this->rate[m];
+	M.gen_dist   = this->dist[m];
+
+	this->marker.push_back(std::move(M));
+
+
+	// true segments at focal site
+
+	if (stream && this->stride > 0 && m >= this->focal && k >= 2)
+	{
+		this->truth(*stream);
+
+		while (this->focal <= m)
+			this->focal += this->stride;
+	}
+
+	++this->current;
+
+	return true;
+}
+
+
+// print genetic map, as accepted by --map
+
+void Simulate::print_map(std::ostream & stream) const
+{
+	stream << "Chromosome Position(bp) Rate(cM/Mb) Map(cM)" << std::endl;
+
+	for (size_t m = 0; m < this->param.markers; ++m)
+	{
+		stream << "chr" << this->param.chromosome << ' ';
+		stream << this->position[m] << ' ';
+		stream << std::setprecision(12) << this->rate[m] << ' ';
+		stream << std::setprecision(12) << this->dist[m] << std::endl;
+	}
+}
+
+
+// print branch of each mutation, as age interval in generations
+
+void Simulate::print_age(std::ostream & stream) const
+{
+	stream << "MarkerID Position Level AgeMin AgeMax" << std::endl;
+
+	for (size_t m = 0; m < this->branch.size(); ++m)
+	{
+		const size_t j = this->branch[m];
+
+		stream << m << ' ';
+		stream << this->position[m] << ' ';
+		stream << j << ' ';
+		stream << std::setprecision(12) << this->level[j].time << ' ';
+		stream << std::setprecision(12) << this->level[j - 1].time << std::endl;
+	}
+}
+
+
+// print header of truth file, as accepted by LoadSim
+
+void Simulate::print_truth_header(std::ostream & stream)
+{
+	stream << "MarkerID SampleID0 Chr0 SampleID1 Chr1 Shared TrueLHS TrueRHS" << std::endl;
+}
+
+
+// draw next switch of haplotype in level
+
+uint32_t Simulate::next_switch(const Level & L, const size_t m)
+{
+	if (L.rate <= 0.0)
+		return static_cast<uint32_t>(this->param.markers);
+
+	const decimal_t g = this->dist[m] + std::exponential_distribution< decimal_t >(L.rate)(this->random);
+
+	return static_cast<uint32_t>(std::upper_bound(this->dist.cbegin() + m + 1, this->dist.cend(), g) - this->dist.cbegin());
+}
+
+
+// place mutation in level, returns number of carriers at present
+
+size_t Simulate::mutate(const size_t j, const size_t h)
+{
+	std::fill(this->level[j].der.begin(), this->level[j].der.end(), 0);
+
+	this->level[j].der[h] = 1;
+
+	for (size_t i = j + 1; i < this->level.size(); ++i)
+	{
+		const std::vector< uint8_t > & above = this->level[i - 1].der;
+
+		Level & L = this->level[i];
+
+		for (size_t x = 0; x < L.size; ++x)
+			L.der[x] = above[L.src[x]];
+	}
+
+	const std::vector< uint8_t > & der = this->level.back().der;
+
+	return static_cast<size_t>(std::count(der.cbegin(), der.cend(), uint8_t(1)));
+}
+
+
+// true segment of pair of present haplotypes at current marker
+
+std::array< size_t, 2 > Simulate::segment(size_t a, size_t b) const
+{
+	size_t beg = 0;
+	size_t end = this->param.markers;
+
+	// segment ends where either lineage switches, up to the level where lineages coalesce
+	for (size_t j = this->level.size() - 1; j > 0; --j)
+	{
+		const Level & L = this->level[j];
+
+		beg = std::max(beg, static_cast<size_t>(std::max(L.beg[a], L.beg[b])));
+		end = std::min(end, static_cast<size_t>(std::min(L.end[a], L.end[b])));
+
+		a = L.src[a];
+		b = L.src[b];
+
+		if (a == b)
+			break;
+	}
+
+	// boundaries are first markers outside of segment, as detected
+	return std::array< size_t, 2 >{{ (beg == 0) ? 0: beg - 1, (end >= this->param.markers) ? this->param.markers - 1: end }};
+}
+
+
+// write pairs at focal site
+
+void Simulate::truth(std::ostream & stream)
+{
+	const std::vector< uint8_t > & der = this->level.back().der;
+
+	std::vector< size_t > share, other;
+
+	for (size_t x = 0; x < der.size(); ++x)
+		(der[x] ? share: other).push_back(x);
+
+	auto print = [&](const size_t a, const size_t b, const bool shared)
+	{
+		const std::array< size_t, 2 > seg = this->segment(a, b);
+
+		stream << this->current << ' ';
+		stream << a / 2 << ' ' << ((a % 2 == MATERNAL) ? 'M': 'P') << ' ';
+		stream << b / 2 << ' ' << ((b % 2 == MATERNAL) ? 'M': 'P') << ' ';
+		stream << shared << ' ' << seg[0] << ' ' << seg[1] << std::endl;
+	};
+
+	const size_t limit = this->param.truth_pairs;
+
+
+	// concordant pairs
+
+	const size_t n_share = share.size();
+
+	if (n_share * (n_share - 1) / 2 <= limit)
+	{
+		for (size_t i = 0; i < n_share; ++i)
+			for (size_t k = i + 1; k < n_share; ++k)
+				print(share[i], share[k], true);
+	}
+	else
+	{
+		std::uniform_int_distribution< size_t > pick(0, n_share - 1);
+		std::set< std::pair< size_t, size_t > > drawn;
+
+		while (drawn.size() < limit)
+		{
+			size_t a = pick(this->random);
+			size_t b = pick(this->random);
+
+			if (a == b)
+				continue;
+
+			if (a > b)
+				std::swap(a, b);
+
+			if (drawn.insert(std::make_pair(a, b)).second)
+				print(share[a], share[b], true);
+		}
+	}
+
+
+	// discordant pairs
+
+	const size_t n_other = other.size();
+
+	if (n_share * n_other <= limit)
+	{
+		for (size_t i = 0; i < n_share; ++i)
+			for (size_t k = 0; k < n_other; ++k)
+				print(share[i], other[k], false);
+	}
+	else
+	{
+		std::uniform_int_distribution< size_t > pick_share(0, n_share - 1);
+		std::uniform_int_distribution< size_t > pick_other(0, n_other - 1);
+		std::set< std::pair< size_t, size_t > > drawn;
+
+		while (drawn.size() < limit)
+		{
+			const size_t a = pick_share(this->random);
+			const size_t b = pick_other(this->random);
+
+			if (drawn.insert(std::make_pair(a, b)).second)
+				print(share[a], other[b], false);
+		}
+	}
+}
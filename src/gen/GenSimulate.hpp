@@ -0,0 +1,133 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef GenSimulate_hpp
+#define GenSimulate_hpp
+
+#include <stdint.h>
+
+#include <array>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Decimal.h"
+#include "Random.h"
+
+#include "Gen.hpp"
+#include "GenGrid.hpp"
+#include "GenMarker.hpp"
+#include "GenSample.hpp"
+
+
+namespace Gen
+{
+	// Synthetic haplotype panel
+	//
+	// Haplotypes descend through a hierarchy of ancestral levels, each level a fraction of the size of the next,
+	// placed at the expected coalescence times of a sample under constant Ne. Along the chromosome, each lineage
+	// copies from one ancestor of the level above, switching at recombination events of its branch. Each marker
+	// carries one mutation, placed on a branch with probability proportional to its length, which yields
+	// nested carrier sets and pairwise segments with known boundaries.
+	class Simulate
+	{
+	public:
+
+		static constexpr size_t branching = 2; // ratio of haplotypes in consecutive levels
+
+
+		// Parameters
+		struct Param
+		{
+			// construct
+			Param(const size_t, const size_t);
+
+			size_t samples; // number of individuals
+			size_t markers; // number of variable sites
+
+			size_t    Ne;      // effective population size
+			decimal_t mut;     // mutation rate, per site per generation
+			decimal_t rec;     // mean recombination rate, per site per generation
+			decimal_t missing; // proportion of missing genotypes
+
+			size_t truth_sites; // number of focal sites reported in truth file
+			size_t truth_pairs; // max. number of concordant and discordant pairs per focal site
+
+			int chromosome;
+		};
+
+
+		// construct, draws marker positions and genetic map
+		Simulate(const Param &);
+
+		// generate next marker, returns false when all markers are generated
+		bool next(Grid::Make &, std::ostream * = nullptr);
+
+		// print genetic map, as accepted by --map
+		void print_map(std::ostream &) const;
+
+		// print branch of each mutation, as age interval in generations
+		void print_age(std::ostream &) const;
+
+		// print header of truth file, as accepted by LoadSim
+		static void print_truth_header(std::ostream &);
+
+
+		const Param param;
+
+		Sample::Vector sample;
+		Marker::Vector marker;
+
+
+	private:
+
+		// Ancestral level
+		struct Level
+		{
+			size_t    size; // number of haplotypes
+			decimal_t time; // generations before present
+			decimal_t rate; // rate of switching ancestor, per cM
+
+			std::vector< uint32_t > src; // copied haplotype in level above
+			std::vector< uint32_t > beg; // first marker copied from current source
+			std::vector< uint32_t > end; // marker of next switch
+			std::vector< uint8_t >  der; // carries derived allele at current marker
+		};
+
+
+		// draw next switch of haplotype in level
+		uint32_t next_switch(const Level &, const size_t);
+
+		// place mutation in level, returns number of carriers at present
+		size_t mutate(const size_t, const size_t);
+
+		// true segment of pair of present haplotypes at current marker
+		std::array< size_t, 2 > segment(size_t, size_t) const;
+
+		// write pairs at focal site
+		void truth(std::ostream &);
+
+
+		random_stream random; // keyed by panel size
+
+		std::vector< Level > level; // from root to present
+
+		std::discrete_distribution< size_t > pick_level; // level of mutation, weighted by total branch length
+
+		std::vector< size_t >    position; // marker positions
+		std::vector< decimal_t > rate;     // recombination rate at marker, cM/Mb
+		std::vector< decimal_t > dist;     // genetic distance at marker, cM
+
+		std::vector< uint8_t > branch; // level of mutation at each marker
+
+		size_t current; // index of next marker
+		size_t stride;  // distance between focal sites
+		size_t focal;   // next marker considered as focal site
+		size_t gap;     // genotypes until next missing genotype
+	};
+}
+
+
+#endif /* GenSimulate_hpp */
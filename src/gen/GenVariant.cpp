@@ -97,6 +97,8 @@ Variant::Vector::Vector(gen_vector_t && gv, const bool phased)
 	{
 		throw std::runtime_error("Empty variant vector was supplied");
 	}
+	
+	this->mask();
 }
 
 Variant::Vector::Vector(const Vector & other)
@@ -104,6 +106,7 @@ Variant::Vector::Vector(const Vector & other)
 , h(other.h)
 , p(other.p)
 , n(other.n)
+, m(other.m)
 , good(other.good)
 {}
 
@@ -112,6 +115,7 @@ Variant::Vector::Vector(Vector && other)
 , h(std::move(other.h))
 , p(other.p)
 , n(other.n)
+, m(std::move(other.m))
 , good(other.good)
 {}
 
@@ -151,6 +155,8 @@ Variant::Vector & Variant::Vector::operator = (gen_vector_t && gv)
 	
 	this->p = phased;
 	
+	this->mask();
+	
 	this->guard.unlock();
 	
 	return *this;
@@ -279,3 +285,52 @@ size_t Variant::Vector::size() const
 	return this->n;
 }
 
+
+// count sites in range [begin, end) where genotype is missing in either vector
+
+size_t Variant::Vector::missing(const Vector & a, const Vector & b, const size_t begin, const size_t end)
+{
+	if (a.n != b.n || begin > end || end > a.n)
+	{
+		throw std::out_of_range("Invalid range of variant vectors");
+	}
+	
+	if (begin == end)
+	{
+		return 0;
+	}
+	
+	const size_t first = begin / 64;
+	const size_t last  = (end - 1) / 64;
+	
+	size_t r = 0;
+	
+	for (size_t w = first; w <= last; ++w)
+	{
+		uint64_t bits = a.m[w] | b.m[w];
+		
+		if (w == first) bits &= ~uint64_t(0) << (begin % 64);
+		if (w == last)  bits &= ~uint64_t(0) >> (63 - (end - 1) % 64);
+		
+		r += __builtin_popcountll(bits);
+	}
+	
+	return r;
+}
+
+
+// build mask of missing genotypes
+
+void Variant::Vector::mask()
+{
+	this->m.assign((this->n + 63) / 64, 0);
+	
+	for (size_t i = 0; i < this->n; ++i)
+	{
+		if (is_genotype<G_>(this->g[i]))
+		{
+			this->m[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
@@ -5,6 +5,7 @@
 #ifndef GenVariant_hpp
 #define GenVariant_hpp
 
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
@@ -62,16 +63,24 @@ namespace Gen
 			// return size
 			size_t size() const;
 			
+			// count sites in range [begin, end) where genotype is missing in either vector
+			static size_t missing(const Vector &, const Vector &, const size_t, const size_t);
+			
 			
 		private:
 			
 			using hap_paired_t = std::array< hap_vector_t, ploidy >;
+			using bit_vector_t = std::vector< uint64_t >;
+			
+			// build mask of missing genotypes
+			void mask();
 			
 			
 			gen_vector_t g;
 			hap_paired_t h;
 			bool         p;
 			size_t       n;
+			bit_vector_t m; // missing genotypes, one bit per site
 			
 			bool good;
 			
@@ -91,18 +91,18 @@ namespace IBD
 	
 	
 	
-	// Calculate missing rate in pairwise runs
+	// Calculate missing rate in pairwise runs, over sites in range [begin, end)
 	
-	inline decimal_t missing_rate(const Gen::gen_vector_t & a, const Gen::gen_vector_t & b, const size_t & n)
+	inline decimal_t missing_rate(const Gen::Variant::Vector & a, const Gen::Variant::Vector & b, const size_t & begin, const size_t & end)
 	{
-		size_t r = 0;
-		
-		for (size_t i = 0; i < n; ++i)
+		if (begin == end)
 		{
-			if (Gen::is_genotype<Gen::G_>(a.at(i)) || Gen::is_genotype<Gen::G_>(b.at(i))) ++r;
+			return decimal_nil;
 		}
 		
-		return static_cast<decimal_t>(r) / static_cast<decimal_t>(n);
+		const size_t r = Gen::Variant::Vector::missing(a, b, begin, end);
+		
+		return static_cast<decimal_t>(r) / static_cast<decimal_t>(end - begin);
 	}
 	
 	
@@ -4,6 +4,8 @@
 
 #include "IBD_HMM.hpp"
 
+#include "Metrics.hpp"
+
 
 //#define DEBUG_HMM
 
@@ -17,14 +19,34 @@ using namespace HMM;
 
 // construct
 
-HMM::Model::Model(const size_t & effective_size, const size_t & sample_size, inits_list && inits_data_con, inits_list && inits_data_dis, emiss_list && emiss_data, dists_list && dists_data)
+HMM::Model::Model(const size_t & effective_size, const size_t & sample_size, inits_list && inits_data_con, inits_list && inits_data_dis, emiss_list && emiss_data, const Gen::Columns::Data columns_data)
 : Ne(effective_size)
 , Nh(sample_size)
 , do_iterative(false)
 , inits_con(std::move(inits_data_con))
 , inits_dis(std::move(inits_data_dis))
 , emiss(std::move(emiss_data))
-, dists(std::move(dists_data))
+, columns(columns_data)
+, trans_bytes(Memory::HMM_TRANSITION)
+{
+	if (this->Nh != this->columns->haplotypes() ||
+		this->inits_con.size() != this->Nh + 1 ||
+		this->inits_dis.size() != this->Nh + 1 ||
+		this->emiss.size() != this->Nh + 1)
+	{
+		throw std::invalid_argument("HMM probabilities do not match sample size");
+	}
+}
+
+HMM::Model::Model(const Model & other, const size_t & effective_size)
+: Ne(effective_size)
+, Nh(other.Nh)
+, do_iterative(other.do_iterative)
+, inits_con(other.inits_con)
+, inits_dis(other.inits_dis)
+, emiss(other.emiss)
+, columns(other.columns)
+, trans_bytes(Memory::HMM_TRANSITION)
 {}
 
 
@@ -39,34 +61,36 @@ void HMM::Model::prepare_transition(const size_t & target)
 		return;
 	}
 
-	const size_t size = this->dists.size();
+	const size_t size = this->columns->size() - 1;
 
 	trans_list fk_trans(size);
 
 	for (size_t i = 0; i < size; ++i)
 	{
-		fk_trans[i] = this->calc_trans_matrix(target, this->Ne, this->Nh, this->dists[i]);
+		fk_trans[i] = this->calc_trans_matrix(target, this->Ne, this->Nh, this->distance(i));
 	}
 
 	this->trans[ target ] = std::move(fk_trans);
+
+	this->trans_bytes.add(size * sizeof(trans_type));
 }
 
 
-// return probabilities
+// return probabilities per site
 
-HMM::Model::inits_list const & HMM::Model::initial_con()
+HMM::Model::inits_site HMM::Model::initial_con() const
 {
-	return this->inits_con;
+	return inits_site(this->inits_con, this->columns->fk());
 }
 
-HMM::Model::inits_list const & HMM::Model::initial_dis()
+HMM::Model::inits_site HMM::Model::initial_dis() const
 {
-	return this->inits_dis;
+	return inits_site(this->inits_dis, this->columns->fk());
 }
 
-HMM::Model::emiss_list const & HMM::Model::emission()
+HMM::Model::emiss_site HMM::Model::emission() const
 {
-	return this->emiss;
+	return emiss_site(this->emiss, this->columns->fk());
 }
 
 HMM::Model::trans_list const & HMM::Model::transition(const size_t & target)
@@ -77,11 +101,31 @@ HMM::Model::trans_list const & HMM::Model::transition(const size_t & target)
 }
 
 
-// return genetic distance
+// return probabilities per allele count
+
+HMM::Model::inits_list const & HMM::Model::initial_con_fk() const
+{
+	return this->inits_con;
+}
+
+HMM::Model::inits_list const & HMM::Model::initial_dis_fk() const
+{
+	return this->inits_dis;
+}
+
+HMM::Model::emiss_list const & HMM::Model::emission_fk() const
+{
+	return this->emiss;
+}
+
+
+// return genetic distance between site and next site
 
 decimal_t HMM::Model::distance(const size_t & site) const
 {
-	return this->dists[site];
+	Gen::Columns::column_t< decimal_t > const & gen_dist = this->columns->gen_dist();
+
+	return (gen_dist[site + 1] - gen_dist[site]) + decimal_err;
 }
 
 
@@ -181,8 +225,12 @@ Algorithm::Algorithm(const hap_vector_t a, const hap_vector_t b, const Model::Da
 
 Segment Algorithm::detect(const size_t & fk_, const Marker::Key & site)
 {
+	Metrics::Scope scope(Metrics::HMM_DETECT);
+	
 	distr_n length = size_distr(site, this->size);
 	
+	Metrics::count(Metrics::MARKERS_SCANNED, length[LHS] + length[RHS]);
+	
 	this->fk = fk_;
 	this->focal = site;
 	
@@ -242,8 +290,8 @@ Segment Algorithm::detect(const size_t & fk_, const Marker::Key & site)
 	this->execute_viterbi(length[RHS], RHS);
 	
 	
-	// detect segment
-	Side< size_t > dist(1, 1);
+	// detect segment, focal site at chromosome boundary has no flanking marker
+	Side< size_t > dist(std::min(size_t(1), length[LHS] - 1), std::min(size_t(1), length[RHS] - 1));
 	
 	// LHS
 	for (size_t k = 1; k < length[LHS]; ++k)
@@ -735,7 +783,7 @@ Distribution const & Algorithm::bwd_weights() const
 
 void Algorithm::print(const Gen::Sample::Key::Pair & pair, const Gen::Marker::Key & site, std::ostream & stream) const
 {
-	Model::emiss_list const & Emiss = this->model->emission();
+	const Model::emiss_site Emiss = this->model->emission();
 
 	distr_n length = size_distr(site, this->size);
 
@@ -1043,8 +1091,8 @@ void Algorithm::execute_viterbi(const size_t & length, const LR side)
 
 	// get model
 
-	Model::inits_list const & Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
-	Model::emiss_list const & Emiss = this->model->emission();
+	const Model::inits_site Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
+	const Model::emiss_site Emiss = this->model->emission();
 	Model::trans_list const & Trans = (this->is_discord) ? this->model->transition(0): this->model->transition(this->fk);
 
 
@@ -1103,8 +1151,8 @@ void Algorithm::execute_viterbi_switch(const size_t & length, const LR side)
 	
 	// get model
 	
-	Model::inits_list const & Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
-	Model::emiss_list const & Emiss = this->model->emission();
+	const Model::inits_site Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
+	const Model::emiss_site Emiss = this->model->emission();
 	Model::trans_list const & Trans = (this->is_discord) ? this->model->transition(0): this->model->transition(this->fk);
 	
 	
@@ -1163,8 +1211,8 @@ void Algorithm::execute_forward(const size_t & length, const LR side)
 
 	// get model
 
-	Model::inits_list const & Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
-	Model::emiss_list const & Emiss = this->model->emission();
+	const Model::inits_site Inits = (this->is_discord) ? this->model->initial_dis(): this->model->initial_con();
+	const Model::emiss_site Emiss = this->model->emission();
 	Model::trans_list const & Trans = (this->is_discord) ? this->model->transition(0): this->model->transition(this->fk);
 
 
@@ -1207,7 +1255,7 @@ void Algorithm::execute_backward(const size_t & length, const LR side)
 
 	// get model
 
-	Model::emiss_list const & Emiss = this->model->emission();
+	const Model::emiss_site Emiss = this->model->emission();
 	Model::trans_list const & Trans = this->model->transition(this->fk);
 
 
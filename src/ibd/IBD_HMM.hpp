@@ -20,11 +20,13 @@
 #include <vector>
 
 #include "Decimal.h"
+#include "Memory.hpp"
 
 #include "IBD.hpp"
 
 #include "Gen.hpp"
 #include "GenMarker.hpp"
+#include "GenColumns.hpp"
 
 
 namespace IBD
@@ -189,29 +191,58 @@ namespace IBD
 
 			using inits_type = std::array< decimal_t, hidden_state_n >;
 			using emiss_type = std::array< std::array< decimal_t, obs_hap_pair_n >, hidden_state_n >;
-			using dists_type = decimal_t;
 			using trans_type = std::array< std::array< decimal_t, hidden_state_n >, hidden_state_n >;
 
-			using inits_list = std::vector< inits_type >;
-			using emiss_list = std::vector< emiss_type >;
-			using dists_list = std::vector< dists_type >;
+			using inits_list = std::vector< inits_type >; // per allele count
+			using emiss_list = std::vector< emiss_type >; // per allele count
 			using trans_list = std::vector< trans_type >;
 
 			using trans_map = std::unordered_map< size_t, trans_list >;
 
 
-			// construct
-			Model(const size_t &, const size_t &, inits_list &&, inits_list &&, emiss_list &&, dists_list &&);
+			// Probabilities of a site, looked up by its allele count
+			template < typename T >
+			class Lookup
+			{
+			public:
+
+				// construct
+				Lookup(const std::vector< T > & _table, const Gen::Columns::column_t< uint32_t > & _fk)
+				: table(_table)
+				, fk(_fk)
+				{}
+
+				// return probabilities of site
+				T const & at(const size_t site) const { return this->table[ this->fk.at(site) ]; }
+
+			private:
+
+				const std::vector< T > & table;
+				const Gen::Columns::column_t< uint32_t > & fk;
+			};
+
+			using inits_site = Lookup< inits_type >;
+			using emiss_site = Lookup< emiss_type >;
+
+
+			// construct, probabilities per allele count
+			Model(const size_t &, const size_t &, inits_list &&, inits_list &&, emiss_list &&, const Gen::Columns::Data);
+			Model(const Model &, const size_t &); // same probabilities, other effective size
 
 			// generate transitions for target
 			void prepare_transition(const size_t &);
 
-			// return probabilities
-			inits_list const & initial_con();
-			inits_list const & initial_dis();
-			emiss_list const & emission();
+			// return probabilities per site
+			inits_site initial_con() const;
+			inits_site initial_dis() const;
+			emiss_site emission() const;
 			trans_list const & transition(const size_t &);
 
+			// return probabilities per allele count
+			inits_list const & initial_con_fk() const;
+			inits_list const & initial_dis_fk() const;
+			emiss_list const & emission_fk() const;
+
 			// return genetic distance
 			decimal_t distance(const size_t &) const;
 
@@ -231,9 +262,12 @@ namespace IBD
 			inits_list inits_con; // concordant initial probabilties
 			inits_list inits_dis; // discordant initial probabilties
 			emiss_list emiss; // emission probabilties
-			dists_list dists; // intervariant distances
 			trans_map  trans; // transition probabilties per fk
 
+			Gen::Columns::Data columns; // allele counts and genetic distances of sites
+
+			Memory::Account trans_bytes; // tracked size of transitions
+
 			std::mutex guard;
 		};
 
@@ -29,7 +29,7 @@ Target::Target(const size_t & k, const Sample::Key::Pair & shared, const Marker:
 Marker::Key::Vector Target::shuffle(const Marker::Key::Set & focals)
 {
 	Marker::Key::Vector out(focals.begin(), focals.end());
-	std::shuffle(out.begin(), out.end(), random_generator);
+	std::shuffle(out.begin(), out.end(), random_generator());
 	return out;
 }
 
@@ -151,7 +151,7 @@ void Detect::run()
 	const Variant::Vector::Data a = this->source->get(this->target->pair.first);
 	const Variant::Vector::Data b = this->source->get(this->target->pair.second);
 	
-	this->target->missing = missing_rate(a->gen(), b->gen(), a->size());
+	this->target->missing = missing_rate(*a, *b, 0, a->size());
 	
 	if (this->target->missing <= this->max_missing_rate)
 	{
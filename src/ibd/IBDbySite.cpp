@@ -155,7 +155,7 @@ void Detect::run()
 			
 			const Sample::Key::Pair pair(*s0, *s1);
 			
-			const decimal_t miss = missing_rate(a->gen(), b->gen(), a->size());
+			const decimal_t miss = missing_rate(*a, *b, 0, a->size());
 			
 			if (miss < this->max_missing_rate)
 			{
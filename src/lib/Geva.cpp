@@ -0,0 +1,385 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Geva.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+
+#include "Random.h"
+
+#include "Gen.hpp"
+#include "GenGrid.hpp"
+#include "GenMarker.hpp"
+#include "GenShare.hpp"
+
+#include "IBD.hpp"
+#include "IBD_HMM.hpp"
+
+#include "Age.hpp"
+#include "AgeInfer.hpp"
+#include "AgePipeline.hpp"
+
+#include "load_hmm.h"
+
+
+using namespace Geva;
+
+
+namespace
+{
+	// Conversion of completed sites to result structs
+	class Relay : public Age::Sink
+	{
+	public:
+
+		// construct
+		Relay(Geva::Sink & _sink, const Gen::Grid::Data _grid, const Age::Param::Data _param)
+		: sink(_sink)
+		, grid(_grid)
+		, param(_param)
+		{}
+
+		// write site and its pairs
+		void write(const Age::Site::Data site)
+		{
+			if (!site->done)
+				return;
+
+			this->write(site, site->raw, 0);
+			this->write(site, site->adj, 1);
+
+			if (this->param->run_composite)
+				this->write(site, site->com, 2);
+
+
+			// pairs
+
+			Age::Pair::List::const_iterator p, p_end = site->list.cend();
+
+			for (p = site->list.cbegin(); p != p_end; ++p)
+			{
+				this->write(site, **p);
+			}
+		}
+
+		// report warning during estimation
+		void warn(const std::string & warning)
+		{
+			this->sink.warn(warning);
+		}
+
+
+	private:
+
+		// site result per clock
+		void write(const Age::Site::Data site, const std::array< Age::CLE, Age::n_clocks > & cle, const int filtered)
+		{
+			static constexpr double none = std::numeric_limits<double>::quiet_NaN();
+
+			const double scale = 2.0 * static_cast<double>(this->param->Ne);
+
+			for (int c = 0; c < Age::n_clocks; ++c)
+			{
+				Age::CLE const & out = cle[c];
+
+				if (!out.good)
+					continue;
+
+				SiteResult result;
+
+				result.marker   = site->focus.value;
+				result.position = this->grid->marker(site->focus).position;
+				result.clock    = clock_label(c);
+				result.filtered = filtered;
+
+				result.n_concordant = out.n_shared;
+				result.n_discordant = out.n_others;
+
+				result.mean   = (filtered == 2) ? none: static_cast<double>(out.mean) * scale;
+				result.mode   = static_cast<double>(out.mode) * scale;
+				result.median = (filtered == 2) ? none: static_cast<double>(out.median) * scale;
+
+				this->sink.site(result);
+			}
+		}
+
+		// pair result per clock
+		void write(const Age::Site::Data site, const Age::Pair & pair)
+		{
+			if (!pair.done)
+				return;
+
+			for (int c = 0; c < Age::n_clocks; ++c)
+			{
+				if (!pair.ccf[c].good)
+					continue;
+
+				PairResult result;
+
+				result.marker = site->focus.value;
+				result.clock  = clock_label(c);
+
+				result.sample0 = pair.pair.first.individual.value;
+				result.sample1 = pair.pair.second.individual.value;
+				result.chr0    = chr_label(pair.pair.first.chromosome);
+				result.chr1    = chr_label(pair.pair.second.chromosome);
+
+				result.shared = pair.sharing;
+				result.pass   = pair.ccf[c].pass;
+
+				result.segment_lhs = pair.segment[IBD::LHS].value;
+				result.segment_rhs = pair.segment[IBD::RHS].value;
+
+				result.shape = pair.ccf[c].shape;
+				result.rate  = static_cast<double>(pair.ccf[c].rate);
+
+				this->sink.pair(result);
+			}
+		}
+
+		static char clock_label(const int c)
+		{
+			return (c == 0) ? 'M': (c == 1) ? 'R': 'J';
+		}
+
+		static int chr_label(const Gen::ChrType chr)
+		{
+			switch (chr)
+			{
+				case Gen::MATERNAL: return 0;
+				case Gen::PATERNAL: return 1;
+				case Gen::UNPHASED: return 5;
+				case Gen::CHR_VOID: return 9;
+			}
+			return 9;
+		}
+
+
+		Geva::Sink & sink;
+
+		const Gen::Grid::Data  grid;
+		const Age::Param::Data param;
+	};
+
+
+	// Forwarding of pipeline stages to caller's executor
+	class Submit : public Age::Executor
+	{
+	public:
+
+		// construct
+		Submit(Geva::Executor & _executor)
+		: executor(_executor)
+		{}
+
+		// run function asynchronously
+		void submit(std::function< void() > func)
+		{
+			this->executor.submit(std::move(func));
+		}
+
+
+	private:
+
+		Geva::Executor & executor;
+	};
+}
+
+
+
+// Receiver of results
+
+Sink::~Sink() {}
+
+void Sink::pair(const PairResult &) {}
+
+void Sink::warn(const std::string & warning)
+{
+	std::cerr << "Warning: " << warning << std::endl;
+}
+
+
+// Execution of long-running functions
+
+Executor::~Executor() {}
+
+
+
+// Input data and HMM
+
+struct Session::State
+{
+	Options options;
+
+	Gen::Grid::Data       grid;
+	IBD::HMM::Model::Data model;
+	Age::Param::Data      param;
+
+
+	// marker ids of target positions, positions not found are skipped (and listed, if requested)
+	Gen::Marker::Key::Vector find(const size_t * positions, const size_t n, std::vector< size_t > * unknown = nullptr) const
+	{
+		Gen::Marker::Vector const & markers = this->grid->marker();
+		Gen::Marker::Key::Vector target;
+
+		target.reserve(n);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			const size_t pos = positions[i];
+
+			Gen::Marker::Iterator marker = std::lower_bound(markers.cbegin(), markers.cend(), pos, [](const Gen::Marker & m, const size_t p) { return m.position < p; });
+
+			if (marker != markers.cend() && marker->position == pos)
+				target.push_back(marker->index);
+			else if (unknown)
+				unknown->push_back(pos);
+		}
+
+		return target;
+	}
+};
+
+
+// construct
+
+Session::Session(const std::string & input_bin, const std::string & hmm_initial, const std::string & hmm_emission, const Options & options)
+: state(new State)
+{
+	this->state->options = options;
+
+	if (options.seed != 0)
+	{
+		set_random_seed(options.seed);
+	}
+
+
+	// input data
+
+	this->state->grid = std::make_shared< Gen::Grid >(input_bin);
+	this->state->grid->cache((options.cache == 0) ? std::numeric_limits<size_t>::max(): options.cache);
+
+
+	// HMM
+
+	this->state->model = load_hmm(this->state->grid, hmm_initial, hmm_emission, options.Ne, std::string(), false, false);
+
+
+	// age estimation parameters
+
+	this->state->param = std::make_shared< Age::Param >(this->state->grid, options.Ne, options.mutation);
+
+	this->state->param->limit_sharers = options.max_concord;
+	this->state->param->outgroup_size = options.max_discord;
+	this->state->param->run_composite = options.composite;
+	this->state->param->adaptive_grid = options.adaptive;
+	this->state->param->threads       = options.threads;
+}
+
+
+// destruct
+
+Session::~Session() {}
+
+
+// sample/marker size
+
+size_t Session::sample_size() const
+{
+	return this->state->grid->sample_size();
+}
+
+size_t Session::marker_size() const
+{
+	return this->state->grid->marker_size();
+}
+
+
+// sharing index of target positions
+
+std::vector< Target > Session::share(const size_t * positions, const size_t n) const
+{
+	const Gen::Marker::Key::Vector target = this->state->find(positions, n);
+
+	std::vector< Target > out(target.size());
+
+	for (size_t k = 0; k < target.size(); ++k)
+	{
+		out[k].marker   = target[k].value;
+		out[k].position = this->state->grid->marker(target[k]).position;
+	}
+
+	for (size_t i = 0; i < this->state->grid->sample_size(); ++i)
+	{
+		const Gen::Variant::Vector::Data data = this->state->grid->get(i);
+
+		for (size_t k = 0; k < target.size(); ++k)
+		{
+			const Gen::hap_pair_t h = Gen::genotype_to_haplotypes(data->gen(target[k]));
+
+			if (Gen::is_haplotype<Gen::H1>(h[Gen::MATERNAL]))
+				out[k].carriers.push_back(i);
+
+			if (Gen::is_haplotype<Gen::H1>(h[Gen::PATERNAL]))
+				out[k].carriers.push_back(i);
+		}
+	}
+
+	return out;
+}
+
+std::vector< Target > Session::share(const std::vector< size_t > & positions) const
+{
+	return this->share(positions.data(), positions.size());
+}
+
+
+// estimate allele age of target positions
+
+size_t Session::estimate(const size_t * positions, const size_t n, Geva::Sink & sink, Geva::Executor * executor)
+{
+	const Options & options = this->state->options;
+
+	std::vector< size_t > unknown;
+	std::set< size_t > target;
+
+	const Gen::Marker::Key::Vector found = this->state->find(positions, n, &unknown);
+
+	for (size_t k = 0; k < found.size(); ++k)
+	{
+		target.insert(this->state->grid->marker(found[k]).position);
+	}
+
+	for (size_t i = 0; i < unknown.size(); ++i)
+	{
+		sink.warn("Target position not found: " + std::to_string(unknown[i]));
+	}
+
+	Gen::Share::Data share = std::make_shared< Gen::Share >(); // sharers of requested sites only
+	share->select(target, this->state->grid);
+
+	Age::Queue queue(share, this->state->grid, this->state->param);
+
+	Age::Pipeline pipeline(queue, this->state->param, IBD::DETECT_HMM, options.max_missing, this->state->grid, this->state->model, nullptr, options.threads, options.batch_limit);
+
+	Relay relay(sink, this->state->grid, this->state->param);
+
+	if (executor)
+	{
+		Submit submit(*executor);
+
+		return unknown.size() + pipeline.run(relay, nullptr, nullptr, &submit);
+	}
+
+	return unknown.size() + pipeline.run(relay);
+}
+
+size_t Session::estimate(const std::vector< size_t > & positions, Geva::Sink & sink, Geva::Executor * executor)
+{
+	return this->estimate(positions.data(), positions.size(), sink, executor);
+}
@@ -0,0 +1,150 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Geva_hpp
+#define Geva_hpp
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+//
+// Embeddable interface of GEVA (libgeva); depends on standard library types only
+//
+namespace Geva
+{
+	// Parameters of age estimation
+	struct Options
+	{
+		size_t Ne           = 10000; // effective population size
+		double mutation     = 1e-08; // mutation rate, per site per generation
+		double max_missing  = 0.10;  // max. proportion of sites near focal site missing in either individual of a pair
+		size_t max_concord  = 100;   // max. number of concordant pairs
+		size_t max_discord  = 100;   // max. number of discordant pairs
+		bool   composite    = false; // composite posterior estimate (as in estimate.R)
+		bool   adaptive     = false; // adaptive time grid
+		size_t threads      = 1;     // number of worker threads
+		size_t batch_limit  = 1000;  // max. number of pairs in flight
+		size_t cache        = 0;     // max. number of individuals kept decompressed in memory; no limit if 0
+		size_t seed         = 0;     // seed for random operations, process-wide; 0 keeps current seed
+	};
+
+
+	// Target site and individuals carrying the focal allele, once per allele copy
+	struct Target
+	{
+		size_t marker;   // marker id
+		size_t position; // chromosomal position
+
+		std::vector< size_t > carriers; // sample ids
+	};
+
+
+	// Allele age estimate of target site, per clock; as in sites file
+	struct SiteResult
+	{
+		size_t marker;   // marker id
+		size_t position; // chromosomal position
+		char   clock;    // mutation (M), recombination (R), or joint (J)
+		int    filtered; // raw (0), after quality control (1), or composite posterior (2)
+
+		size_t n_concordant; // number of concordant pairs
+		size_t n_discordant; // number of discordant pairs
+
+		double mean;   // in generations; not a number if not given
+		double mode;   // in generations
+		double median; // in generations; not a number if not given
+	};
+
+
+	// Pairwise TMRCA posterior, per clock; as in pairs file
+	struct PairResult
+	{
+		size_t marker; // marker id
+		char   clock;  // mutation (M), recombination (R), or joint (J)
+
+		size_t sample0, sample1; // sample ids
+		int    chr0, chr1;       // maternal (0), paternal (1), unphased (5), or void (9)
+
+		bool shared; // concordant pair
+		bool pass;   // retained after quality control
+
+		size_t segment_lhs; // marker id of left segment boundary
+		size_t segment_rhs; // marker id of right segment boundary
+
+		size_t shape; // Gamma (Erlang) shape of TMRCA posterior
+		double rate;  // Gamma rate, in units of 2Ne generations
+	};
+
+
+	// Receiver of results, called on one thread in order of target sites
+	class Sink
+	{
+	public:
+
+		virtual ~Sink();
+
+		// completed target site
+		virtual void site(const SiteResult &) = 0;
+
+		// completed pair of target site, reported after its site results
+		virtual void pair(const PairResult &);
+
+		// warning during estimation, e.g. target position not found; written to std::cerr unless overridden
+		virtual void warn(const std::string &);
+	};
+
+
+	// Execution of long-running functions, e.g. on threads of a caller's pool
+	class Executor
+	{
+	public:
+
+		virtual ~Executor();
+
+		// run function asynchronously; up to (threads + 1) functions must run concurrently
+		virtual void submit(std::function< void() >) = 0;
+	};
+
+
+	// Input data and HMM, loaded once for any number of estimations
+	class Session
+	{
+	public:
+
+		// construct from pre-processed binary input file and HMM input files
+		Session(const std::string &, const std::string &, const std::string &, const Options & = Options());
+
+		// destruct
+		~Session();
+
+		Session(const Session &) = delete; // no copy
+
+
+		// sample/marker size
+		size_t sample_size() const;
+		size_t marker_size() const;
+
+		// sharing index of target positions; positions not found are skipped
+		std::vector< Target > share(const size_t *, const size_t) const;
+		std::vector< Target > share(const std::vector< size_t > &) const;
+
+		// estimate allele age of target positions, returns number of warnings
+		size_t estimate(const size_t *, const size_t, Sink &, Executor * = nullptr);
+		size_t estimate(const std::vector< size_t > &, Sink &, Executor * = nullptr);
+
+
+	private:
+
+		struct State;
+
+		std::unique_ptr< State > state;
+	};
+}
+
+
+#endif /* Geva_hpp */
@@ -258,18 +258,10 @@ void LoadHMM::make_initial(const Grid::Data grid, const std::string & filename,
 	}
 	
 	
-	// fill in for each site
+	// fill in for each allele count
 	
-	this->inits_con.resize(grid->marker().size());
-	this->inits_dis.resize(grid->marker().size());
-	
-	Marker::Vector::const_iterator M, M_end = grid->marker().cend();
-	
-	for (M = grid->marker().cbegin(); M != M_end; ++M)
-	{
-		this->inits_con[ M->index.value ] = this->input_inits_con[ M->hap_count[H1] ];
-		this->inits_dis[ M->index.value ] = this->input_inits_dis[ M->hap_count[H1] ];
-	}
+	this->inits_con = per_count(this->input_inits_con, N);
+	this->inits_dis = per_count(this->input_inits_dis, N);
 	
 	// print
 	if (file_ptr != nullptr)
@@ -300,18 +292,10 @@ void LoadHMM::make_initial(const Gen::Grid::Data grid)
 		this->input_inits_dis[ k ] = point;
 	}
 	
-	// fill in for each site
-	
-	this->inits_con.resize(grid->marker().size());
-	this->inits_dis.resize(grid->marker().size());
+	// fill in for each allele count
 	
-	Marker::Vector::const_iterator M, M_end = grid->marker().cend();
-	
-	for (M = grid->marker().cbegin(); M != M_end; ++M)
-	{
-		this->inits_con[ M->index.value ] = this->input_inits_con[ M->hap_count[H1] ];
-		this->inits_dis[ M->index.value ] = this->input_inits_dis[ M->hap_count[H1] ];
-	}
+	this->inits_con = per_count(this->input_inits_con, N);
+	this->inits_dis = per_count(this->input_inits_dis, N);
 	
 	// finish
 	this->inits_good = true;
@@ -519,16 +503,9 @@ void LoadHMM::make_emission(const Grid::Data grid, const std::string & filename,
 	}
 	
 	
-	// fill in for each site
+	// fill in for each allele count
 	
-	this->emiss.resize(grid->marker().size());
-	
-	Marker::Vector::const_iterator M, M_end = grid->marker().cend();
-	
-	for (M = grid->marker().cbegin(); M != M_end; ++M)
-	{
-		this->emiss[ M->index.value ] = this->input_emiss[ M->hap_count[H1] ];
-	}
+	this->emiss = per_count(this->input_emiss, N);
 	
 	// print
 	if (file_ptr != nullptr)
@@ -572,16 +549,9 @@ void LoadHMM::make_emission(const Gen::Grid::Data grid)
 		this->input_emiss[ k ] = point;
 	}
 	
-	// fill in for each site
-	
-	this->emiss.resize(grid->marker().size());
+	// fill in for each allele count
 	
-	Marker::Vector::const_iterator M, M_end = grid->marker().cend();
-	
-	for (M = grid->marker().cbegin(); M != M_end; ++M)
-	{
-		this->emiss[ M->index.value ] = this->input_emiss[ M->hap_count[H1] ];
-	}
+	this->emiss = per_count(this->input_emiss, N);
 	
 	// finish
 	this->emiss_good = true;
@@ -603,26 +573,19 @@ void LoadHMM::make_transition(const Gen::Grid::Data grid, std::ofstream * file_p
 		throw std::runtime_error("Unexpected sample size detected");
 	}
 	
-	const size_t size = grid->marker().size();
+	this->columns = grid->columns(); // distances derived from shared marker columns
 	
-	this->dists.resize(size - 1);
+	const Columns::column_t< decimal_t > & gen_dist = this->columns->gen_dist();
 	
-	for (size_t i = 1; i < size; ++i)
+	for (size_t i = 1; i < gen_dist.size(); ++i)
 	{
-		const decimal_t d0 = static_cast<decimal_t>(grid->marker(i-1).gen_dist);
-		const decimal_t d1 = static_cast<decimal_t>(grid->marker( i ).gen_dist);
-		
-		const decimal_t dist = d1 - d0; // delta in cM
+		const decimal_t dist = gen_dist[i] - gen_dist[i - 1]; // delta in cM
 		
 		// check negative
 		if (dist < decimal_nil)
 		{
 			throw std::logic_error("Gen distance between positions is negative");
 		}
-		
-		// insert into transition container
-		
-		this->dists[ i - 1 ] = dist + decimal_err;
 	}
 	
 	// print
@@ -652,7 +615,7 @@ Model::Data LoadHMM::make_model()
 	
 	this->done = true;
 	
-	return std::make_shared<Model>(this->Ne, this->Nh, std::move(this->inits_con), std::move(this->inits_dis), std::move(this->emiss), std::move(this->dists));
+	return std::make_shared<Model>(this->Ne, this->Nh, std::move(this->inits_con), std::move(this->inits_dis), std::move(this->emiss), this->columns);
 }
 
 
@@ -740,13 +703,13 @@ void LoadHMM::print_transition(std::ofstream & stream) const
 	
 	// content
 	
-	const size_t size = this->dists.size();
+	const Columns::column_t< decimal_t > & gen_dist = this->columns->gen_dist();
 	
-	for (size_t i = 0; i < size; ++i)
+	for (size_t i = 1; i < gen_dist.size(); ++i)
 	{
-		stream << i  << ' ';
-		stream << i + 1 << ' ';
-		stream << std::fixed << std::setprecision(8) << this->dists.at(i) << std::endl;
+		stream << i - 1 << ' ';
+		stream << i << ' ';
+		stream << std::fixed << std::setprecision(8) << (gen_dist[i] - gen_dist[i - 1]) + decimal_err << std::endl;
 	}
 }
 
@@ -72,13 +72,31 @@ private:
 	using emiss_input = std::map< size_t, IBD::HMM::Model::emiss_type >;
 	
 	
+	// probabilities per allele count, zero if not in input
+	template < typename T >
+	static std::vector< T > per_count(const std::map< size_t, T > & input, const size_t N)
+	{
+		std::vector< T > table(N + 1, T());
+		
+		typename std::map< size_t, T >::const_iterator it, ti = input.cend();
+		
+		for (it = input.cbegin(); it != ti && it->first <= N; ++it)
+		{
+			table[ it->first ] = it->second;
+		}
+		
+		return table;
+	}
+	
+	
 	const size_t Ne;
 	const size_t Nh;
 	
-	IBD::HMM::Model::inits_list inits_con; // concordant initial probabilties
-	IBD::HMM::Model::inits_list inits_dis; // discordant initial probabilties
-	IBD::HMM::Model::emiss_list emiss; // emission probabilties
-	IBD::HMM::Model::dists_list dists; // distances, to prepare transition probabilties
+	IBD::HMM::Model::inits_list inits_con; // concordant initial probabilties, per allele count
+	IBD::HMM::Model::inits_list inits_dis; // discordant initial probabilties, per allele count
+	IBD::HMM::Model::emiss_list emiss; // emission probabilties, per allele count
+	
+	Gen::Columns::Data columns; // marker columns, to prepare transition probabilties
 	
 	
 	// internal
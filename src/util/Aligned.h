@@ -0,0 +1,55 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Aligned_h
+#define Aligned_h
+
+#include <stdlib.h>
+
+#include <cstddef>
+#include <new>
+
+
+// Allocator of memory aligned to cache lines
+
+template < typename T, size_t A = 64 >
+struct Aligned
+{
+	using value_type = T;
+
+	template < typename U >
+	struct rebind
+	{
+		using other = Aligned< U, A >;
+	};
+
+	// constructs
+	Aligned() {}
+	template < typename U > Aligned(const Aligned< U, A > &) {}
+
+	// allocate/release
+	T * allocate(const size_t n)
+	{
+		void * ptr = nullptr;
+
+		if (posix_memalign(&ptr, A, n * sizeof(T)) != 0)
+		{
+			throw std::bad_alloc();
+		}
+
+		return static_cast< T * >(ptr);
+	}
+
+	void deallocate(T * ptr, const size_t)
+	{
+		free(ptr);
+	}
+
+	// compare
+	template < typename U > bool operator == (const Aligned< U, A > &) const { return true; }
+	template < typename U > bool operator != (const Aligned< U, A > &) const { return false; }
+};
+
+
+#endif /* Aligned_h */
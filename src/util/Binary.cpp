@@ -4,13 +4,20 @@
 
 #include "Binary.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 // constructs
 
 Binary::Binary(const std::string & filename, const Binary::mode m, const bool remove)
 try
 : name(filename)
-, file((m == Binary::WRITE) ? Binary::make(filename): Binary::open(filename))
+, length(0)
+, mapping((m == Binary::READ) ? Binary::view(filename, length): nullptr)
+, file((m == Binary::WRITE) ? Binary::make(filename): Binary::open(filename, mapping, length))
 , auto_delete(remove)
 {}
 catch (const std::exception & ex)
@@ -21,6 +28,7 @@ catch (const std::exception & ex)
 Binary::Binary()
 try
 : name(std::string())
+, length(0)
 , file(std::tmpfile(), std::fclose)
 , auto_delete(false)
 {}
@@ -32,6 +40,8 @@ catch (const std::exception & ex)
 Binary::Binary(Binary && other)
 try
 : name(std::move(other.name))
+, length(other.length)
+, mapping(std::move(other.mapping))
 , file(std::move(other.file))
 , map(std::move(other.map))
 , auto_delete(other.auto_delete)
@@ -70,14 +80,54 @@ Binary::file_ptr Binary::make(const std::string & filename)
 }
 
 
-// Open file with custom deleter for reading + updating
+// Open file with custom deleter for reading + updating, from read-only mapping if available
 
-Binary::file_ptr Binary::open(const std::string & filename)
+Binary::file_ptr Binary::open(const std::string & filename, const view_ptr & view, const size_t length)
 {
+	if (view)
+	{
+		std::FILE * stream = fmemopen(const_cast<char *>(view.get()), length, "rb");
+
+		if (stream)
+			return file_ptr(stream, std::fclose);
+	}
+
 	return file_ptr(std::fopen(filename.data(), "rb"), std::fclose);
 }
 
 
+// Map file read-only into memory, shared with other processes reading the same file; empty if not possible
+
+Binary::view_ptr Binary::view(const std::string & filename, size_t & length)
+{
+	const int fd = ::open(filename.data(), O_RDONLY);
+
+	if (fd < 0)
+		return nullptr;
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	const size_t size = static_cast<size_t>(info.st_size);
+
+	void * addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+	close(fd); // mapping remains valid
+
+	if (addr == MAP_FAILED)
+		return nullptr;
+
+	length = size;
+
+	return view_ptr(static_cast<const char *>(addr), [size](const char * ptr) { munmap(const_cast<char *>(ptr), size); });
+}
+
+
 // Get current file position
 
 void Binary::here(const Binary::file_map::key_type index)
@@ -29,14 +29,20 @@ private:
 	
 	typedef std::unique_ptr<std::FILE, int (*)(std::FILE *)> file_ptr;
 	typedef std::unordered_map< size_t, std::fpos_t >        file_map;
+	typedef std::shared_ptr<const char>                      view_ptr;
 	
 	// Make file with custom deleter for writing + updating
 	static file_ptr make(const std::string & filename);
 	
-	// Open file with custom deleter for reading + updating
-	static file_ptr open(const std::string & filename);
+	// Open file with custom deleter for reading + updating, from read-only mapping if available
+	static file_ptr open(const std::string & filename, const view_ptr & view, const size_t length);
+	
+	// Map file read-only into memory, shared with other processes reading the same file; empty if not possible
+	static view_ptr view(const std::string & filename, size_t & length);
 	
 	const std::string name; // filename
+	size_t          length; // size of mapped file
+	view_ptr       mapping; // mapped file
 	file_ptr          file; // file pointer
 	file_map           map; // indexed file positions
 	
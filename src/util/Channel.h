@@ -0,0 +1,133 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Channel_h
+#define Channel_h
+
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+
+
+// Bounded queue between concurrent producers and consumers
+
+template<class T>
+class Channel
+{
+public:
+
+	using value_t = T;
+
+
+	// construct
+	Channel(const size_t n = std::numeric_limits<size_t>::max())
+	: capacity((n == 0) ? 1: n)
+	, closed(false)
+	{}
+
+	Channel(const Channel &) = delete; // no copy
+
+
+	// append element, blocks while full; returns false when closed
+	bool push(value_t && value)
+	{
+		std::unique_lock<std::mutex> lock(this->guard);
+
+		this->not_full.wait(lock, [this] { return (this->closed || this->queue.size() < this->capacity); });
+
+		if (this->closed)
+			return false;
+
+		this->queue.push_back(std::move(value));
+
+		this->not_empty.notify_one();
+
+		return true;
+	}
+
+	bool push(const value_t & value)
+	{
+		value_t copy = value;
+		return this->push(std::move(copy));
+	}
+
+	// insert element at front, ignores capacity; returns false when closed
+	bool prepend(value_t && value)
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		if (this->closed)
+			return false;
+
+		this->queue.push_front(std::move(value));
+
+		this->not_empty.notify_one();
+
+		return true;
+	}
+
+	// remove element, blocks while empty; returns false when closed and drained
+	bool pop(value_t & value)
+	{
+		std::unique_lock<std::mutex> lock(this->guard);
+
+		this->not_empty.wait(lock, [this] { return (this->closed || !this->queue.empty()); });
+
+		if (this->queue.empty())
+			return false;
+
+		value = std::move(this->queue.front());
+		this->queue.pop_front();
+
+		this->not_full.notify_one();
+
+		return true;
+	}
+
+	// no further elements are accepted
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		this->closed = true;
+
+		this->not_full.notify_all();
+		this->not_empty.notify_all();
+	}
+
+	// discard pending elements and close
+	void abort()
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		this->queue.clear();
+		this->closed = true;
+
+		this->not_full.notify_all();
+		this->not_empty.notify_all();
+	}
+
+	// current number of elements
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+		return this->queue.size();
+	}
+
+
+private:
+
+	const size_t capacity; // max. number of queued elements
+	bool         closed;   // flag end of input
+
+	std::deque< value_t > queue;
+
+	std::mutex              guard;
+	std::condition_variable not_full;
+	std::condition_variable not_empty;
+};
+
+
+#endif /* Channel_h */
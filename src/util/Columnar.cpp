@@ -0,0 +1,496 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Columnar.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include <limits>
+
+
+using namespace Columnar;
+
+
+namespace
+{
+	static const char magic[8] = { 'G', 'E', 'V', 'A', 'C', 'O', 'L', '1' };
+
+
+	// append integral value to buffer, little endian
+	template< typename T >
+	void encode(std::string & buffer, const T value)
+	{
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			buffer.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xFF));
+		}
+	}
+
+	void encode(std::string & buffer, const std::string & str)
+	{
+		encode<uint32_t>(buffer, static_cast<uint32_t>(str.size()));
+		buffer.append(str);
+	}
+
+
+	// read integral value from buffer, little endian
+	template< typename T >
+	T decode(const std::string & buffer, size_t & at)
+	{
+		if (at + sizeof(T) > buffer.size())
+			throw std::runtime_error("Unexpected end of columnar footer");
+
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[at++])) << (8 * i);
+		}
+
+		return static_cast<T>(value);
+	}
+
+	std::string decode(const std::string & buffer, size_t & at)
+	{
+		const size_t n = decode<uint32_t>(buffer, at);
+
+		if (at + n > buffer.size())
+			throw std::runtime_error("Unexpected end of columnar footer");
+
+		const std::string str = buffer.substr(at, n);
+
+		at += n;
+
+		return str;
+	}
+
+
+	void write(FILE * file, const std::string & data)
+	{
+		if (!data.empty() && fwrite(data.data(), 1, data.size(), file) != data.size())
+			throw std::runtime_error("Error while writing columnar file");
+	}
+
+	void read(FILE * file, const uint64_t offset, std::string & data)
+	{
+		if (fseeko(file, static_cast<off_t>(offset), SEEK_SET) != 0)
+			throw std::runtime_error("Error while navigating columnar file");
+
+		if (!data.empty() && fread(&data[0], 1, data.size(), file) != data.size())
+			throw std::runtime_error("Error while reading columnar file");
+	}
+}
+
+
+
+// size in bytes
+
+size_t Columnar::width(const Type type)
+{
+	switch (type)
+	{
+		case UINT8:   return 1;
+		case UINT32:  return 4;
+		case UINT64:  return 8;
+		case FLOAT64: return 8;
+	}
+
+	throw std::runtime_error("Unknown column type");
+}
+
+
+
+// Write table, row by row
+
+// construct
+
+Writer::Writer(const std::string & filename, const std::string & table, const Schema & _schema, const size_t _group_size)
+: name(table)
+, schema(_schema)
+, group_size(_group_size)
+, file(fopen(filename.c_str(), "wb"), fclose)
+, column(_schema.size())
+, rows(0)
+{
+	if (!this->file)
+		throw std::runtime_error("Unable to create columnar file: " + filename);
+
+	if (this->group_size == 0)
+		throw std::invalid_argument("Row group size must be positive");
+
+	for (size_t i = 0; i < this->schema.size(); ++i)
+	{
+		this->column[i].reserve(this->group_size * width(this->schema[i].type));
+	}
+
+	write(this->file.get(), std::string(magic, sizeof(magic)));
+}
+
+
+// destruct, writes footer if not closed
+
+Writer::~Writer()
+{
+	if (!this->file)
+		return;
+
+	try
+	{
+		this->close();
+	}
+	catch (...) {}
+}
+
+
+// append value to column of current row
+
+void Writer::put(const size_t col, const uint64_t value)
+{
+	std::string & buffer = this->column.at(col);
+
+	switch (this->schema[col].type)
+	{
+		case UINT8:
+			if (value > std::numeric_limits<uint8_t>::max())
+				throw std::overflow_error("Value exceeds column type: " + this->schema[col].name);
+			encode<uint8_t>(buffer, static_cast<uint8_t>(value));
+			break;
+
+		case UINT32:
+			if (value > std::numeric_limits<uint32_t>::max())
+				throw std::overflow_error("Value exceeds column type: " + this->schema[col].name);
+			encode<uint32_t>(buffer, static_cast<uint32_t>(value));
+			break;
+
+		case UINT64:
+			encode<uint64_t>(buffer, value);
+			break;
+
+		case FLOAT64:
+			this->put(col, static_cast<double>(value));
+			break;
+	}
+}
+
+void Writer::put(const size_t col, const double value)
+{
+	if (this->schema.at(col).type != FLOAT64)
+		throw std::invalid_argument("Column is not of floating point type: " + this->schema[col].name);
+
+	static_assert(sizeof(double) == sizeof(uint64_t), "System not compatible (double != 64 bits)");
+
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	encode<uint64_t>(this->column[col], bits);
+}
+
+
+// complete current row
+
+void Writer::next()
+{
+	++this->rows;
+
+	if (this->rows == this->group_size)
+		this->flush();
+}
+
+
+// flush last row group and write footer
+
+void Writer::close()
+{
+	if (!this->file)
+		return;
+
+	this->flush();
+
+	const off_t begin = ftello(this->file.get());
+
+	if (begin < 0)
+		throw std::runtime_error("Error while writing columnar file");
+
+
+	std::string footer;
+
+	encode(footer, this->name);
+
+	encode<uint32_t>(footer, static_cast<uint32_t>(this->schema.size()));
+
+	for (size_t i = 0; i < this->schema.size(); ++i)
+	{
+		encode<uint8_t>(footer, this->schema[i].type);
+		encode(footer, this->schema[i].name);
+	}
+
+	encode<uint64_t>(footer, this->group_rows.size());
+
+	for (size_t g = 0; g < this->group_rows.size(); ++g)
+	{
+		encode<uint64_t>(footer, this->group_rows[g]);
+
+		for (size_t i = 0; i < this->schema.size(); ++i)
+		{
+			encode<uint64_t>(footer, this->group_chunk[g][i].offset);
+			encode<uint64_t>(footer, this->group_chunk[g][i].size);
+			encode<uint64_t>(footer, this->group_chunk[g][i].raw);
+		}
+	}
+
+	encode<uint64_t>(footer, static_cast<uint64_t>(begin));
+	footer.append(magic, sizeof(magic));
+
+	write(this->file.get(), footer);
+
+	FILE * raw = this->file.release();
+
+	if (fclose(raw) != 0)
+		throw std::runtime_error("Error while closing columnar file");
+}
+
+
+// compress and write current row group
+
+void Writer::flush()
+{
+	if (this->rows == 0)
+		return;
+
+	std::vector< Chunk > chunks(this->schema.size());
+
+	for (size_t i = 0; i < this->schema.size(); ++i)
+	{
+		std::string & buffer = this->column[i];
+
+		if (buffer.size() != this->rows * width(this->schema[i].type))
+			throw std::runtime_error("Incomplete row in column: " + this->schema[i].name);
+
+		uLongf size = compressBound(buffer.size());
+		std::string zip(size, '\0');
+
+		if (compress2(reinterpret_cast<Bytef *>(&zip[0]), &size, reinterpret_cast<const Bytef *>(buffer.data()), buffer.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+			throw std::runtime_error("Error while compressing column: " + this->schema[i].name);
+
+		zip.resize(size);
+
+		const off_t offset = ftello(this->file.get());
+
+		if (offset < 0)
+			throw std::runtime_error("Error while writing columnar file");
+
+		write(this->file.get(), zip);
+
+		chunks[i].offset = static_cast<uint64_t>(offset);
+		chunks[i].size   = zip.size();
+		chunks[i].raw    = buffer.size();
+
+		buffer.clear();
+	}
+
+	this->group_rows.push_back(this->rows);
+	this->group_chunk.push_back(std::move(chunks));
+
+	this->rows = 0;
+}
+
+
+
+// Read table, column by column
+
+// construct, reads footer
+
+Reader::Reader(const std::string & filename)
+: name(filename)
+, file(fopen(filename.c_str(), "rb"), fclose)
+{
+	if (!this->file)
+		throw std::runtime_error("Unable to open columnar file: " + filename);
+
+
+	// trailer
+
+	if (fseeko(this->file.get(), 0, SEEK_END) != 0)
+		throw std::runtime_error("Error while navigating columnar file");
+
+	const off_t end = ftello(this->file.get());
+
+	if (end < static_cast<off_t>(2 * sizeof(magic) + sizeof(uint64_t)))
+		throw std::runtime_error("Not a columnar file: " + filename);
+
+	std::string head(sizeof(magic), '\0');
+	std::string tail(sizeof(uint64_t) + sizeof(magic), '\0');
+
+	read(this->file.get(), 0, head);
+	read(this->file.get(), static_cast<uint64_t>(end) - tail.size(), tail);
+
+	if (head.compare(0, sizeof(magic), magic, sizeof(magic)) != 0 || tail.compare(sizeof(uint64_t), sizeof(magic), magic, sizeof(magic)) != 0)
+		throw std::runtime_error("Not a columnar file: " + filename);
+
+	size_t at = 0;
+
+	const uint64_t begin = decode<uint64_t>(tail, at);
+
+	if (begin < sizeof(magic) || begin > static_cast<uint64_t>(end) - tail.size())
+		throw std::runtime_error("Invalid footer in columnar file: " + filename);
+
+
+	// footer
+
+	std::string footer(static_cast<uint64_t>(end) - tail.size() - begin, '\0');
+
+	read(this->file.get(), begin, footer);
+
+	at = 0;
+
+	this->title = decode(footer, at);
+
+	const size_t n_fields = decode<uint32_t>(footer, at);
+
+	this->fields.resize(n_fields);
+
+	for (size_t i = 0; i < n_fields; ++i)
+	{
+		this->fields[i].type = static_cast<Type>(decode<uint8_t>(footer, at));
+		this->fields[i].name = decode(footer, at);
+
+		width(this->fields[i].type); // validate
+	}
+
+	const size_t n_groups = decode<uint64_t>(footer, at);
+
+	this->group_rows.resize(n_groups);
+	this->group_chunk.resize(n_groups, std::vector< Chunk >(n_fields));
+
+	for (size_t g = 0; g < n_groups; ++g)
+	{
+		this->group_rows[g] = decode<uint64_t>(footer, at);
+
+		for (size_t i = 0; i < n_fields; ++i)
+		{
+			Chunk & chunk = this->group_chunk[g][i];
+
+			chunk.offset = decode<uint64_t>(footer, at);
+			chunk.size   = decode<uint64_t>(footer, at);
+			chunk.raw    = decode<uint64_t>(footer, at);
+
+			if (chunk.raw != this->group_rows[g] * width(this->fields[i].type) || chunk.offset + chunk.size > begin)
+				throw std::runtime_error("Invalid footer in columnar file: " + filename);
+		}
+	}
+}
+
+
+// table name
+
+std::string const & Reader::table() const
+{
+	return this->title;
+}
+
+
+// columns
+
+Schema const & Reader::schema() const
+{
+	return this->fields;
+}
+
+
+// column index by name
+
+size_t Reader::find(const std::string & field) const
+{
+	for (size_t i = 0; i < this->fields.size(); ++i)
+	{
+		if (this->fields[i].name == field)
+			return i;
+	}
+
+	throw std::invalid_argument("Column not found in " + this->name + ": " + field);
+}
+
+
+// number of row groups and rows
+
+size_t Reader::groups() const
+{
+	return this->group_rows.size();
+}
+
+size_t Reader::rows(const size_t group) const
+{
+	return this->group_rows.at(group);
+}
+
+
+// read column of row group
+
+void Reader::get(const size_t group, const size_t col, std::vector< uint64_t > & values)
+{
+	const std::string buffer = this->load(group, col);
+	const size_t n = this->group_rows[group];
+
+	values.resize(n);
+
+	size_t at = 0;
+
+	switch (this->fields[col].type)
+	{
+		case UINT8:
+			for (size_t i = 0; i < n; ++i) values[i] = decode<uint8_t>(buffer, at);
+			break;
+
+		case UINT32:
+			for (size_t i = 0; i < n; ++i) values[i] = decode<uint32_t>(buffer, at);
+			break;
+
+		case UINT64:
+			for (size_t i = 0; i < n; ++i) values[i] = decode<uint64_t>(buffer, at);
+			break;
+
+		case FLOAT64:
+			throw std::invalid_argument("Column is of floating point type: " + this->fields[col].name);
+	}
+}
+
+void Reader::get(const size_t group, const size_t col, std::vector< double > & values)
+{
+	if (this->fields.at(col).type != FLOAT64)
+		throw std::invalid_argument("Column is not of floating point type: " + this->fields[col].name);
+
+	const std::string buffer = this->load(group, col);
+	const size_t n = this->group_rows[group];
+
+	values.resize(n);
+
+	size_t at = 0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		const uint64_t bits = decode<uint64_t>(buffer, at);
+		memcpy(&values[i], &bits, sizeof(bits));
+	}
+}
+
+
+// decompress column of row group
+
+std::string Reader::load(const size_t group, const size_t col)
+{
+	const Chunk & chunk = this->group_chunk.at(group).at(col);
+
+	std::string zip(chunk.size, '\0');
+	std::string raw(chunk.raw, '\0');
+
+	read(this->file.get(), chunk.offset, zip);
+
+	uLongf size = raw.size();
+
+	if (uncompress(reinterpret_cast<Bytef *>(&raw[0]), &size, reinterpret_cast<const Bytef *>(zip.data()), zip.size()) != Z_OK || size != raw.size())
+		throw std::runtime_error("Error while decompressing column: " + this->fields[col].name);
+
+	return raw;
+}
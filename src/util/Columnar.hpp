@@ -0,0 +1,152 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Columnar_hpp
+#define Columnar_hpp
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+//
+// Binary columnar table file; typed columns in compressed row groups, indexed by footer
+//
+// Layout:
+//  magic
+//  row group 0: column 0, column 1, ... (each compressed separately, zlib)
+//  row group 1: ...
+//  footer: table name, column names and types, per row group the number of rows and the offset/size of each column
+//  offset of footer, magic
+//
+namespace Columnar
+{
+	// Column types
+	enum Type : uint8_t { UINT8 = 1, UINT32 = 4, UINT64 = 8, FLOAT64 = 9 };
+
+	// size in bytes
+	size_t width(const Type);
+
+
+	// Column declaration
+	struct Field
+	{
+		std::string name;
+		Type        type;
+	};
+
+	using Schema = std::vector< Field >;
+
+
+	// Write table, row by row
+	class Writer
+	{
+	public:
+
+		// construct
+		Writer(const std::string &, const std::string &, const Schema &, const size_t = 65536);
+		Writer(const Writer &) = delete; // no copy
+
+		// destruct, writes footer if not closed
+		~Writer();
+
+
+		// append value to column of current row
+		void put(const size_t, const uint64_t);
+		void put(const size_t, const double);
+
+		// complete current row
+		void next();
+
+		// flush last row group and write footer
+		void close();
+
+
+	private:
+
+		// compress and write current row group
+		void flush();
+
+
+		struct Chunk
+		{
+			uint64_t offset;
+			uint64_t size; // compressed
+			uint64_t raw;  // uncompressed
+		};
+
+		const std::string name;
+		const Schema      schema;
+		const size_t      group_size; // rows per group
+
+		std::unique_ptr<FILE, int (*)(FILE *)> file;
+
+		std::vector< std::string > column; // uncompressed values of current row group
+
+		std::vector< uint64_t >             group_rows;
+		std::vector< std::vector< Chunk > > group_chunk;
+
+		size_t rows; // in current row group
+	};
+
+
+	// Read table, column by column
+	class Reader
+	{
+	public:
+
+		// construct, reads footer
+		Reader(const std::string &);
+		Reader(const Reader &) = delete; // no copy
+
+
+		// table name
+		std::string const & table() const;
+
+		// columns
+		Schema const & schema() const;
+
+		// column index by name
+		size_t find(const std::string &) const;
+
+		// number of row groups and rows
+		size_t groups() const;
+		size_t rows(const size_t) const;
+
+		// read column of row group
+		void get(const size_t, const size_t, std::vector< uint64_t > &);
+		void get(const size_t, const size_t, std::vector< double > &);
+
+
+	private:
+
+		// decompress column of row group
+		std::string load(const size_t, const size_t);
+
+
+		struct Chunk
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint64_t raw;
+		};
+
+		const std::string name;
+
+		std::unique_ptr<FILE, int (*)(FILE *)> file;
+
+		std::string title;
+		Schema      fields;
+
+		std::vector< uint64_t >             group_rows;
+		std::vector< std::vector< Chunk > > group_chunk;
+	};
+}
+
+
+#endif /* Columnar_hpp */
@@ -0,0 +1,55 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Hash_h
+#define Hash_h
+
+#include <stdint.h>
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+
+// FNV-1a hash over values
+
+class Hash
+{
+public:
+
+	template< typename T >
+	void add(const T & value)
+	{
+		unsigned char bytes[sizeof(T)];
+
+		memcpy(bytes, &value, sizeof(T));
+
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			this->value ^= bytes[i];
+			this->value *= 1099511628211ULL;
+		}
+	}
+
+	template< typename T, size_t N >
+	void add(const std::array< T, N > & values)
+	{
+		for (const T & v : values)
+			this->add(v);
+	}
+
+	template< typename T >
+	void add(const std::vector< T > & values)
+	{
+		this->add(uint64_t(values.size()));
+
+		for (const T & v : values)
+			this->add(v);
+	}
+
+	uint64_t value = 14695981039346656037ULL;
+};
+
+
+#endif /* Hash_h */
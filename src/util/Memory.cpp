@@ -0,0 +1,252 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Memory.hpp"
+
+#include <array>
+#include <iomanip>
+#include <sstream>
+
+
+namespace
+{
+	static const char * pool_name[Memory::n_pools] = { "sample_cache", "hmm_transition", "marker_column", "near_rank", "ccf" };
+
+
+	// Current and peak bytes of subsystems, last entry is total
+	struct Usage
+	{
+		Usage()
+		: limit(0)
+		{
+			for (int i = 0; i <= Memory::n_pools; ++i)
+			{
+				this->current[i] = 0;
+				this->peak[i]    = 0;
+			}
+		}
+
+		std::array< std::atomic< size_t >, Memory::n_pools + 1 > current;
+		std::array< std::atomic< size_t >, Memory::n_pools + 1 > peak;
+
+		std::atomic< size_t > limit;
+	};
+
+	Usage & usage()
+	{
+		static Usage use;
+		return use;
+	}
+
+
+	// add to value and raise high-water mark
+	void raise(std::atomic< size_t > & value, std::atomic< size_t > & peak, const size_t n)
+	{
+		const size_t now = value.fetch_add(n, std::memory_order_relaxed) + n;
+
+		size_t max = peak.load(std::memory_order_relaxed);
+
+		while (now > max && !peak.compare_exchange_weak(max, now, std::memory_order_relaxed));
+	}
+
+
+	// format bytes as Mb
+	std::string megabytes(const size_t bytes)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / static_cast<double>(1024 * 1024) << " Mb";
+		return oss.str();
+	}
+}
+
+
+
+// Bytes held by a single container
+
+// construct
+
+Memory::Account::Account(const Pool _pool)
+: pool(_pool)
+, bytes(0)
+{}
+
+Memory::Account::Account(const Account & other) // copy
+: pool(other.pool)
+, bytes(0)
+{
+	this->add(other.bytes);
+}
+
+Memory::Account::Account(Account && other) // move
+: pool(other.pool)
+, bytes(other.bytes)
+{
+	other.bytes = 0;
+}
+
+
+// destruct, releases held bytes
+
+Memory::Account::~Account()
+{
+	shrink(this->pool, this->bytes);
+}
+
+
+// set/add held bytes
+
+void Memory::Account::set(const size_t n)
+{
+	if (n > this->bytes)
+		grow(this->pool, n - this->bytes);
+	else
+		shrink(this->pool, this->bytes - n);
+
+	this->bytes = n;
+}
+
+void Memory::Account::add(const size_t n)
+{
+	grow(this->pool, n);
+
+	this->bytes += n;
+}
+
+
+// return held bytes
+
+size_t Memory::Account::size() const
+{
+	return this->bytes;
+}
+
+
+
+// return current and peak bytes per subsystem
+
+size_t Memory::current(const Pool pool)
+{
+	return usage().current[pool].load(std::memory_order_relaxed);
+}
+
+size_t Memory::peak(const Pool pool)
+{
+	return usage().peak[pool].load(std::memory_order_relaxed);
+}
+
+
+// return current and peak bytes in total
+
+size_t Memory::current()
+{
+	return usage().current[n_pools].load(std::memory_order_relaxed);
+}
+
+size_t Memory::peak()
+{
+	return usage().peak[n_pools].load(std::memory_order_relaxed);
+}
+
+
+// set limit on total bytes, zero for none
+
+void Memory::limit(const size_t bytes)
+{
+	usage().limit.store(bytes, std::memory_order_relaxed);
+}
+
+
+// return limit
+
+size_t Memory::limit()
+{
+	return usage().limit.load(std::memory_order_relaxed);
+}
+
+
+// return bytes held by subsystems not shrunk by scheduling, and by work in flight
+
+size_t Memory::fixed()
+{
+	return current(SAMPLE_CACHE) + current(HMM_TRANSITION) + current(MARKER_COLUMN);
+}
+
+size_t Memory::in_flight()
+{
+	return current(NEAR_RANK) + current(CCF);
+}
+
+
+// check if work in flight exceeds limit less fixed footprint
+
+bool Memory::exceeded()
+{
+	const size_t max  = limit();
+	const size_t base = fixed();
+
+	return (max > 0 && base < max && in_flight() > max - base);
+}
+
+
+// check if fixed footprint alone exceeds limit
+
+bool Memory::overrun()
+{
+	const size_t max = limit();
+
+	return (max > 0 && fixed() >= max);
+}
+
+
+// name of subsystem
+
+std::string Memory::name(const Pool pool)
+{
+	return pool_name[pool];
+}
+
+
+// print peak per subsystem to log
+
+void Memory::print(std::ostream & stream)
+{
+	stream << "Peak memory (tracked containers)" << std::endl;
+
+	for (int i = 0; i < n_pools; ++i)
+	{
+		stream << " " << std::left << std::setw(16) << pool_name[i] << std::right << megabytes(peak(static_cast<Pool>(i))) << std::endl;
+	}
+
+	stream << " " << std::left << std::setw(16) << "total" << std::right << megabytes(peak()) << std::endl;
+
+	if (limit() > 0)
+	{
+		stream << " " << std::left << std::setw(16) << "limit" << std::right << megabytes(limit()) << std::endl;
+	}
+}
+
+
+// update current and peak
+
+void Memory::grow(const Pool pool, const size_t n)
+{
+	if (n == 0)
+		return;
+
+	Usage & use = usage();
+
+	raise(use.current[pool], use.peak[pool], n);
+	raise(use.current[n_pools], use.peak[n_pools], n);
+}
+
+void Memory::shrink(const Pool pool, const size_t n)
+{
+	if (n == 0)
+		return;
+
+	Usage & use = usage();
+
+	use.current[pool].fetch_sub(n, std::memory_order_relaxed);
+	use.current[n_pools].fetch_sub(n, std::memory_order_relaxed);
+}
@@ -0,0 +1,105 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Memory_hpp
+#define Memory_hpp
+
+#include <stdint.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+
+//
+// Accounting of bytes held by the large containers, per subsystem
+//
+// Each container registers its size with an Account, which is released on destruction.
+// Current and peak (high-water mark) are kept per subsystem and in total.
+//
+class Memory
+{
+public:
+
+	// Tracked subsystems
+	enum Pool : int
+	{
+		SAMPLE_CACHE = 0, // cached genotype/haplotype vectors of individuals
+		HMM_TRANSITION,   // HMM transition tables per fk
+		MARKER_COLUMN,    // marker attribute columns, shared per grid
+		NEAR_RANK,        // haplotype chunks and rank lists of nearest neighbour selection, in flight
+		CCF,              // CCF vectors of pairs in flight
+		n_pools
+	};
+
+
+	// Bytes held by a single container
+	class Account
+	{
+	public:
+
+		// construct
+		explicit Account(const Pool);
+		Account(const Account &); // copy holds same size
+		Account(Account &&);
+
+		Account & operator = (const Account &) = delete;
+
+		// destruct, releases held bytes
+		~Account();
+
+		// set/add held bytes
+		void set(const size_t);
+		void add(const size_t);
+
+		// return held bytes
+		size_t size() const;
+
+	private:
+
+		const Pool pool;
+		size_t     bytes;
+	};
+
+
+	// return current and peak bytes per subsystem
+	static size_t current(const Pool);
+	static size_t peak(const Pool);
+
+	// return current and peak bytes in total
+	static size_t current();
+	static size_t peak();
+
+	// set limit on total bytes, zero for none
+	static void limit(const size_t);
+
+	// return limit
+	static size_t limit();
+
+	// return bytes held by subsystems not shrunk by scheduling (sample cache, HMM, marker columns), and by work in flight
+	static size_t fixed();
+	static size_t in_flight();
+
+	// check if work in flight exceeds limit less fixed footprint; never if fixed footprint alone exceeds limit
+	static bool exceeded();
+
+	// check if fixed footprint alone exceeds limit
+	static bool overrun();
+
+	// name of subsystem
+	static std::string name(const Pool);
+
+	// print peak per subsystem to log
+	static void print(std::ostream &);
+
+
+private:
+
+	// update current and peak
+	static void grow(const Pool, const size_t);
+	static void shrink(const Pool, const size_t);
+};
+
+
+#endif /* Memory_hpp */
@@ -0,0 +1,214 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Metrics.hpp"
+#include "Memory.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+
+namespace
+{
+	static const char * stage_name[Metrics::n_stages] = { "grid_get", "near", "hmm_detect", "density_estimate", "site_estimate", "print" };
+	static const char * count_name[Metrics::n_counts] = { "pairs", "markers_scanned", "cache_hits", "cache_misses", "bytes_read" };
+
+
+	// Totals of exited threads and list of running threads
+	struct Registry
+	{
+		std::mutex guard;
+
+		std::array< uint64_t, Metrics::n_stages > calls{};
+		std::array< uint64_t, Metrics::n_stages > wall{};
+		std::array< uint64_t, Metrics::n_stages > cpu{};
+		std::array< uint64_t, Metrics::n_counts > counts{};
+
+		size_t threads = 0; // threads that recorded measurements
+
+		std::set< const void * > running;
+	};
+
+	Registry & registry()
+	{
+		static Registry reg;
+		return reg;
+	}
+
+
+	// sum of atomic values
+	template< size_t N >
+	void accumulate(std::array< uint64_t, N > & sum, const std::array< std::atomic< uint64_t >, N > & values)
+	{
+		for (size_t i = 0; i < N; ++i)
+			sum[i] += values[i].load(std::memory_order_relaxed);
+	}
+}
+
+
+
+// Per-stage timing and counters, aggregated over threads
+
+Metrics::Block::Block()
+{
+	for (int s = 0; s < n_stages; ++s)
+	{
+		this->calls[s] = 0;
+		this->wall[s]  = 0;
+		this->cpu[s]   = 0;
+	}
+
+	for (int c = 0; c < n_counts; ++c)
+	{
+		this->counts[c] = 0;
+	}
+}
+
+
+// register thread
+
+Metrics::Local::Local()
+{
+	Registry & reg = registry();
+
+	std::lock_guard< std::mutex > lock(reg.guard);
+
+	reg.running.insert(&this->block);
+	++reg.threads;
+}
+
+
+// fold measurements of exiting thread into totals
+
+Metrics::Local::~Local()
+{
+	Registry & reg = registry();
+
+	std::lock_guard< std::mutex > lock(reg.guard);
+
+	accumulate(reg.calls,  this->block.calls);
+	accumulate(reg.wall,   this->block.wall);
+	accumulate(reg.cpu,    this->block.cpu);
+	accumulate(reg.counts, this->block.counts);
+
+	reg.running.erase(&this->block);
+}
+
+
+// enable/disable collection
+
+void Metrics::enable(const bool on)
+{
+	flag().store(on, std::memory_order_relaxed);
+}
+
+
+// add measurement to current thread
+
+void Metrics::add(const Stage stage, const int64_t wall, const int64_t cpu)
+{
+	Block & block = local();
+
+	increment(block.calls[stage], 1);
+	increment(block.wall[stage], static_cast<uint64_t>(std::max(wall, int64_t(0))));
+	increment(block.cpu[stage],  static_cast<uint64_t>(std::max(cpu,  int64_t(0))));
+}
+
+
+// measurements of current thread, registered on first use
+
+Metrics::Block & Metrics::local()
+{
+	thread_local Local current;
+
+	return current.block;
+}
+
+
+std::atomic< bool > & Metrics::flag()
+{
+	static std::atomic< bool > on(false);
+	return on;
+}
+
+
+// print report as JSON, summed over threads
+
+void Metrics::print(std::ostream & stream, const double elapsed)
+{
+	Registry & reg = registry();
+
+	std::lock_guard< std::mutex > lock(reg.guard);
+
+	std::array< uint64_t, n_stages > calls = reg.calls, wall = reg.wall, cpu = reg.cpu;
+	std::array< uint64_t, n_counts > counts = reg.counts;
+
+	for (const void * ptr : reg.running)
+	{
+		const Block & block = *static_cast<const Block *>(ptr);
+
+		accumulate(calls,  block.calls);
+		accumulate(wall,   block.wall);
+		accumulate(cpu,    block.cpu);
+		accumulate(counts, block.counts);
+	}
+
+
+	stream << "{" << std::endl;
+	stream << "  \"elapsed_seconds\": " << std::fixed << std::setprecision(3) << elapsed << "," << std::endl;
+	stream << "  \"threads\": " << reg.threads << "," << std::endl;
+
+	stream << "  \"stages\": {" << std::endl;
+
+	for (int s = 0; s < n_stages; ++s)
+	{
+		stream << "    \"" << stage_name[s] << "\": { \"calls\": " << calls[s];
+		stream << ", \"wall_seconds\": " << std::fixed << std::setprecision(6) << static_cast<double>(wall[s]) * 1e-9;
+		stream << ", \"cpu_seconds\": " << std::fixed << std::setprecision(6) << static_cast<double>(cpu[s]) * 1e-9 << " }";
+		stream << ((s + 1 < n_stages) ? "," : "") << std::endl;
+	}
+
+	stream << "  }," << std::endl;
+	stream << "  \"counters\": {" << std::endl;
+
+	for (int c = 0; c < n_counts; ++c)
+	{
+		stream << "    \"" << count_name[c] << "\": " << counts[c] << "," << std::endl;
+	}
+
+	const uint64_t pairs = counts[PAIRS];
+	const uint64_t reads = counts[CACHE_HITS] + counts[CACHE_MISSES];
+
+	stream << "    \"markers_per_pair\": " << std::fixed << std::setprecision(3) << ((pairs > 0) ? static_cast<double>(counts[MARKERS_SCANNED]) / pairs: 0.0) << "," << std::endl;
+	stream << "    \"cache_hit_rate\": " << std::fixed << std::setprecision(6) << ((reads > 0) ? static_cast<double>(counts[CACHE_HITS]) / reads: 0.0) << std::endl;
+	stream << "  }," << std::endl;
+	stream << "  \"memory_peak_bytes\": {" << std::endl;
+
+	for (int p = 0; p < Memory::n_pools; ++p)
+	{
+		stream << "    \"" << Memory::name(static_cast<Memory::Pool>(p)) << "\": " << Memory::peak(static_cast<Memory::Pool>(p)) << "," << std::endl;
+	}
+
+	stream << "    \"total\": " << Memory::peak() << "," << std::endl;
+	stream << "    \"limit\": " << Memory::limit() << std::endl;
+	stream << "  }" << std::endl;
+	stream << "}" << std::endl;
+}
+
+
+// write report to file
+
+void Metrics::print(const std::string & filename, const double elapsed)
+{
+	std::ofstream stream(filename);
+
+	if (!stream)
+		throw std::runtime_error("Unable to create output file: " + filename);
+
+	print(stream, elapsed);
+}
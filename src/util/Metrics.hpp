@@ -0,0 +1,161 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Metrics_hpp
+#define Metrics_hpp
+
+#include <stdint.h>
+#include <time.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+
+//
+// Per-stage timing and counters, aggregated over threads
+//
+// Disabled by default; each scope or count then costs a single flag test.
+// Times are inclusive of nested stages (e.g. Grid::get within Near) and summed over threads.
+//
+class Metrics
+{
+public:
+
+	// Instrumented stages
+	enum Stage : int
+	{
+		GRID_GET = 0,
+		NEAR,
+		HMM_DETECT,
+		DENSITY_ESTIMATE,
+		SITE_ESTIMATE,
+		PRINT,
+		n_stages
+	};
+
+	// Counters
+	enum Count : int
+	{
+		PAIRS = 0,       // pairs processed
+		MARKERS_SCANNED, // markers evaluated in HMM
+		CACHE_HITS,      // individuals fetched from cache
+		CACHE_MISSES,    // individuals read from file
+		BYTES_READ,      // bytes read from file
+		n_counts
+	};
+
+
+	// Scoped measurement of stage on current thread
+	class Scope
+	{
+	public:
+
+		// construct, starts measurement if enabled
+		explicit Scope(const Stage stage)
+		: which(stage)
+		, active(Metrics::enabled())
+		, wall()
+		, cpu(0)
+		{
+			if (this->active)
+			{
+				this->wall = std::chrono::steady_clock::now();
+				this->cpu  = Metrics::cpu_time();
+			}
+		}
+
+		Scope(const Scope &) = delete; // no copy
+
+		// destruct, adds measurement to thread
+		~Scope()
+		{
+			if (this->active)
+				Metrics::add(this->which, std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - this->wall).count(), Metrics::cpu_time() - this->cpu);
+		}
+
+	private:
+
+		const Stage which;
+		const bool  active;
+
+		std::chrono::steady_clock::time_point wall;
+		int64_t cpu;
+	};
+
+
+	// enable/disable collection
+	static void enable(const bool = true);
+
+	// check if enabled
+	static bool enabled()
+	{
+		return flag().load(std::memory_order_relaxed);
+	}
+
+	// add to counter of current thread
+	static void count(const Count what, const uint64_t n = 1)
+	{
+		if (enabled())
+			increment(local().counts[what], n);
+	}
+
+	// print report as JSON, summed over threads
+	static void print(std::ostream &, const double elapsed = 0.0);
+
+	// write report to file
+	static void print(const std::string &, const double elapsed = 0.0);
+
+
+private:
+
+	// Measurements of one thread, written by its thread only
+	struct Block
+	{
+		Block();
+
+		std::array< std::atomic< uint64_t >, n_stages > calls;
+		std::array< std::atomic< uint64_t >, n_stages > wall; // nanoseconds
+		std::array< std::atomic< uint64_t >, n_stages > cpu;  // nanoseconds
+		std::array< std::atomic< uint64_t >, n_counts > counts;
+	};
+
+
+	// single writer, no read-modify-write needed
+	static void increment(std::atomic< uint64_t > & value, const uint64_t n)
+	{
+		value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	// add measurement to current thread
+	static void add(const Stage, const int64_t, const int64_t);
+
+	// CPU time of current thread, in nanoseconds
+	static int64_t cpu_time()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+	}
+
+	// Registration of thread, folds measurements into totals when thread exits
+	struct Local
+	{
+		Local();
+		~Local();
+
+		Block block;
+	};
+
+
+	// measurements of current thread, registered on first use
+	static Block & local();
+
+	static std::atomic< bool > & flag();
+};
+
+
+#endif /* Metrics_hpp */
@@ -0,0 +1,451 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Output.hpp"
+
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace
+{
+	// BGZF block: gzip member with block size in extra field, max. 64 KiB
+	static constexpr size_t bgzf_header = 18;
+	static constexpr size_t bgzf_footer = 8;
+	static constexpr size_t bgzf_block  = 65536;
+	static constexpr size_t bgzf_input  = 65280; // uncompressed bytes per block, as in bgzip
+
+	// empty block marking end of file
+	static const unsigned char bgzf_eof[28] = { 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+
+	void put_u16(unsigned char * at, const size_t value)
+	{
+		at[0] = static_cast<unsigned char>(value & 0xFF);
+		at[1] = static_cast<unsigned char>((value >> 8) & 0xFF);
+	}
+
+	void put_u32(unsigned char * at, const size_t value)
+	{
+		put_u16(at, value & 0xFFFF);
+		put_u16(at + 2, (value >> 16) & 0xFFFF);
+	}
+}
+
+
+// construct, opens file; keeps given number of bytes of existing file and appends (resume), or creates file (0)
+
+Output::Output(const std::string & filename, const bool _compress, const size_t _threads, const uint64_t keep, const size_t size)
+: name(filename)
+, compress(_compress)
+, threads((_threads == 0) ? 1: _threads)
+, file(fopen(filename.c_str(), (keep > 0) ? "r+b": "wb"), fclose)
+, front((size == 0) ? 1: size)
+, back((size == 0) ? 1: size)
+, back_size(0)
+, pending(false)
+, finish(false)
+, error(nullptr)
+, job_data(nullptr)
+, job_size(0)
+, job_next(0)
+, job_left(0)
+, job_stop(false)
+, job_error(nullptr)
+{
+	if (!this->file)
+		throw std::runtime_error("Unable to create output file: " + filename);
+
+	if (keep > 0)
+	{
+		if (fseeko(this->file.get(), 0, SEEK_END) != 0 || ftello(this->file.get()) < static_cast<off_t>(keep))
+			throw std::runtime_error("Output file is shorter than expected: " + filename);
+
+		if (ftruncate(fileno(this->file.get()), static_cast<off_t>(keep)) != 0 || fseeko(this->file.get(), static_cast<off_t>(keep), SEEK_SET) != 0)
+			throw std::runtime_error("Unable to truncate output file: " + filename);
+	}
+
+	this->setp(this->front.data(), this->front.data() + this->front.size());
+
+	this->writer = std::thread(&Output::run, this);
+
+	if (this->compress)
+	{
+		for (size_t t = 1; t < this->threads; ++t)
+			this->packer.emplace_back(&Output::work, this);
+	}
+}
+
+
+// destruct, closes file if not closed
+
+Output::~Output()
+{
+	try
+	{
+		this->close();
+	}
+	catch (...) {}
+
+	if (this->writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->guard);
+
+			this->finish = true;
+			this->filled.notify_one();
+		}
+
+		this->writer.join();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->job_guard);
+
+		this->job_stop = true;
+		this->job_start.notify_all();
+	}
+
+	for (std::thread & t : this->packer)
+	{
+		if (t.joinable())
+			t.join();
+	}
+}
+
+
+// write buffered data to file, blocks until written; returns size of file
+
+uint64_t Output::flush()
+{
+	if (!this->file)
+		throw std::runtime_error("Output file already closed: " + this->name);
+
+	this->hand();
+
+	std::unique_lock<std::mutex> lock(this->guard);
+
+	this->wait(lock);
+
+	if (this->error)
+		std::rethrow_exception(this->error);
+
+	const off_t size = (fflush(this->file.get()) == 0) ? ftello(this->file.get()): -1;
+
+	if (size < 0)
+		throw std::runtime_error("Error while writing output file: " + this->name);
+
+	return static_cast<uint64_t>(size);
+}
+
+
+// flush and close file; compressed files are terminated by empty block
+
+void Output::close()
+{
+	if (!this->writer.joinable())
+		return;
+
+	this->hand();
+
+	{
+		std::lock_guard<std::mutex> lock(this->guard);
+
+		this->finish = true;
+		this->filled.notify_one();
+	}
+
+	this->writer.join();
+
+	if (this->error)
+	{
+		this->file.reset();
+		std::rethrow_exception(this->error);
+	}
+
+	if (this->compress && fwrite(bgzf_eof, 1, sizeof(bgzf_eof), this->file.get()) != sizeof(bgzf_eof))
+		throw std::runtime_error("Error while writing output file: " + this->name);
+
+	if (fclose(this->file.release()) != 0)
+		throw std::runtime_error("Error while closing output file: " + this->name);
+}
+
+
+// buffer full
+
+Output::int_type Output::overflow(int_type ch)
+{
+	this->hand();
+
+	if (traits_type::eq_int_type(ch, traits_type::eof()))
+		return traits_type::not_eof(ch);
+
+	*this->pptr() = traits_type::to_char_type(ch);
+	this->pbump(1);
+
+	return ch;
+}
+
+
+// append sequence
+
+std::streamsize Output::xsputn(const char * data, std::streamsize n)
+{
+	std::streamsize done = 0;
+
+	while (done < n)
+	{
+		if (this->pptr() == this->epptr())
+			this->hand();
+
+		const std::streamsize k = std::min<std::streamsize>(n - done, this->epptr() - this->pptr());
+
+		memcpy(this->pptr(), data + done, static_cast<size_t>(k));
+
+		this->pbump(static_cast<int>(k));
+
+		done += k;
+	}
+
+	return n;
+}
+
+
+// hand buffer to writer thread
+
+int Output::sync()
+{
+	this->hand();
+
+	return 0;
+}
+
+
+// hand filled buffer to writer thread, blocks while previous buffer is being written
+
+void Output::hand()
+{
+	const size_t n = static_cast<size_t>(this->pptr() - this->pbase());
+
+	if (n == 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(this->guard);
+
+	this->wait(lock);
+
+	if (!this->error) // otherwise discarded, error is reported on flush or close
+	{
+		this->front.swap(this->back);
+
+		this->back_size = n;
+		this->pending   = true;
+
+		this->filled.notify_one();
+	}
+
+	lock.unlock();
+
+	this->setp(this->front.data(), this->front.data() + this->front.size());
+}
+
+
+// wait for writer thread to finish current buffer
+
+void Output::wait(std::unique_lock<std::mutex> & lock)
+{
+	this->written.wait(lock, [this] { return !this->pending; });
+}
+
+
+// writer thread
+
+void Output::run()
+{
+	std::unique_lock<std::mutex> lock(this->guard);
+
+	while (true)
+	{
+		this->filled.wait(lock, [this] { return (this->pending || this->finish); });
+
+		if (!this->pending)
+			return;
+
+		lock.unlock();
+
+		std::exception_ptr failed = nullptr;
+
+		try
+		{
+			this->store(this->back, this->back_size);
+		}
+		catch (...)
+		{
+			failed = std::current_exception();
+		}
+
+		lock.lock();
+
+		if (failed && !this->error)
+			this->error = failed;
+
+		this->pending = false;
+		this->written.notify_all();
+	}
+}
+
+
+// write or compress buffer
+
+void Output::store(const std::vector<char> & buffer, const size_t n)
+{
+	if (!this->compress)
+	{
+		if (fwrite(buffer.data(), 1, n, this->file.get()) != n)
+			throw std::runtime_error("Error while writing output file: " + this->name);
+
+		return;
+	}
+
+
+	// compress blocks, shared with compression threads
+
+	{
+		std::unique_lock<std::mutex> lock(this->job_guard);
+
+		this->job_data  = buffer.data();
+		this->job_size  = n;
+		this->job_next  = 0;
+		this->job_left  = (n + bgzf_input - 1) / bgzf_input;
+		this->job_error = nullptr;
+
+		this->job_block.resize(this->job_left);
+
+		this->job_start.notify_all();
+
+		this->claim(lock);
+
+		this->job_done.wait(lock, [this] { return this->job_left == 0; });
+
+		if (this->job_error)
+			std::rethrow_exception(this->job_error);
+	}
+
+
+	// write blocks in order
+
+	for (const std::string & block : this->job_block)
+	{
+		if (fwrite(block.data(), 1, block.size(), this->file.get()) != block.size())
+			throw std::runtime_error("Error while writing output file: " + this->name);
+	}
+}
+
+
+// compression thread
+
+void Output::work()
+{
+	std::unique_lock<std::mutex> lock(this->job_guard);
+
+	while (true)
+	{
+		this->job_start.wait(lock, [this] { return (this->job_next < this->job_block.size() || this->job_stop); });
+
+		if (this->job_stop)
+			return;
+
+		this->claim(lock);
+	}
+}
+
+
+// compress unclaimed blocks of current buffer
+
+void Output::claim(std::unique_lock<std::mutex> & lock)
+{
+	while (this->job_next < this->job_block.size())
+	{
+		const size_t b  = this->job_next++;
+		const size_t at = b * bgzf_input;
+
+		lock.unlock();
+
+		std::exception_ptr failed = nullptr;
+
+		try
+		{
+			this->pack(this->job_data + at, std::min(bgzf_input, this->job_size - at), this->job_block[b]);
+		}
+		catch (...)
+		{
+			failed = std::current_exception();
+		}
+
+		lock.lock();
+
+		if (failed && !this->job_error)
+			this->job_error = failed;
+
+		if (--this->job_left == 0)
+			this->job_done.notify_all();
+	}
+}
+
+
+// compress section of buffer into BGZF blocks
+
+void Output::pack(const char * data, const size_t n, std::string & block) const
+{
+	for (int level : { Z_DEFAULT_COMPRESSION, Z_NO_COMPRESSION }) // stored if compressed data exceeds block
+	{
+		z_stream zs;
+
+		memset(&zs, 0, sizeof(zs));
+
+		if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			throw std::runtime_error("Error while initialising compression");
+
+		block.resize(bgzf_header + deflateBound(&zs, n) + bgzf_footer);
+
+		zs.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+		zs.avail_in  = static_cast<uInt>(n);
+		zs.next_out  = reinterpret_cast<Bytef *>(&block[bgzf_header]);
+		zs.avail_out = static_cast<uInt>(block.size() - bgzf_header - bgzf_footer);
+
+		const int status = ::deflate(&zs, Z_FINISH);
+		const size_t size = zs.total_out;
+
+		deflateEnd(&zs);
+
+		if (status != Z_STREAM_END)
+			throw std::runtime_error("Error while compressing output file: " + this->name);
+
+		const size_t total = bgzf_header + size + bgzf_footer;
+
+		if (total > bgzf_block)
+			continue;
+
+		block.resize(total);
+
+		unsigned char * head = reinterpret_cast<unsigned char *>(&block[0]);
+		unsigned char * tail = head + bgzf_header + size;
+
+		static const unsigned char gzip_head[16] = { 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00 };
+
+		memcpy(head, gzip_head, sizeof(gzip_head));
+		put_u16(head + 16, total - 1);
+
+		put_u32(tail, crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(data), static_cast<uInt>(n)));
+		put_u32(tail + 4, n);
+
+		return;
+	}
+
+	throw std::runtime_error("Error while compressing output file: " + this->name);
+}
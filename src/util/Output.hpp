@@ -0,0 +1,124 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Output_hpp
+#define Output_hpp
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//
+// Output file written on dedicated thread, double-buffered; optionally BGZF compressed (gzip compatible)
+//
+// The producer appends into a preallocated buffer, which is handed to the writer thread when full,
+// while the producer continues on the second buffer. Flushing the stream (std::flush, std::endl) hands
+// the buffer over without waiting for it to be written, so lines should end in '\n'; flush() and
+// close() block until data is written and report errors. Compression threads are kept for the
+// lifetime of the file and share the blocks of each buffer with the writer thread.
+//
+class Output : public std::streambuf
+{
+public:
+
+	// construct, opens file; keeps given number of bytes of existing file and appends (resume), or creates file (0)
+	Output(const std::string &, const bool = false, const size_t = 1, const uint64_t = 0, const size_t = 4194304);
+	Output(const Output &) = delete; // no copy
+
+	// destruct, closes file if not closed
+	~Output();
+
+
+	// write buffered data to file, blocks until written; returns size of file
+	uint64_t flush();
+
+	// flush and close file; compressed files are terminated by empty block
+	void close();
+
+
+protected:
+
+	// buffer full
+	int_type overflow(int_type);
+
+	// append sequence
+	std::streamsize xsputn(const char *, std::streamsize);
+
+	// hand buffer to writer thread
+	int sync();
+
+
+private:
+
+	// hand filled buffer to writer thread, blocks while previous buffer is being written
+	void hand();
+
+	// wait for writer thread to finish current buffer
+	void wait(std::unique_lock<std::mutex> &);
+
+	// writer thread
+	void run();
+
+	// compression thread
+	void work();
+
+	// compress unclaimed blocks of current buffer
+	void claim(std::unique_lock<std::mutex> &);
+
+	// write or compress buffer
+	void store(const std::vector<char> &, const size_t);
+
+	// compress section of buffer into BGZF blocks
+	void pack(const char *, const size_t, std::string &) const;
+
+
+	const std::string name;
+	const bool        compress;
+	const size_t      threads; // compression threads
+
+	std::unique_ptr<FILE, int (*)(FILE *)> file;
+
+	std::vector<char> front; // filled by producer
+	std::vector<char> back;  // written by writer thread
+
+	size_t back_size; // bytes in back buffer
+	bool   pending;   // back buffer to be written
+	bool   finish;    // stop writer thread
+
+	std::exception_ptr error;
+
+	std::mutex              guard;
+	std::condition_variable filled;  // back buffer handed to writer
+	std::condition_variable written; // back buffer written
+
+	std::thread writer;
+
+
+	const char *               job_data;  // buffer being compressed
+	size_t                     job_size;  // bytes in buffer
+	std::vector< std::string > job_block; // compressed blocks of buffer
+	size_t                     job_next;  // next block to be claimed
+	size_t                     job_left;  // blocks not yet compressed
+	bool                       job_stop;  // stop compression threads
+
+	std::exception_ptr job_error;
+
+	std::mutex              job_guard;
+	std::condition_variable job_start; // buffer handed to compression threads
+	std::condition_variable job_done;  // all blocks compressed
+
+	std::vector< std::thread > packer; // compression threads, besides writer
+};
+
+
+#endif /* Output_hpp */
@@ -7,9 +7,11 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <limits>
 #include <random>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -21,49 +23,118 @@ using random_output_t = size_t;
 using random_vector_t = std::vector< random_output_t >;
 
 
-//  random seed
-static random_engine_t random_seed = static_cast<random_engine_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count() % std::numeric_limits<random_engine_t>::max());
+// random seed and generator, shared across translation units
 
+inline random_engine_t & random_seed_state()
+{
+	static random_engine_t seed = static_cast<random_engine_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count() % std::numeric_limits<random_engine_t>::max());
+	return seed;
+}
 
-// random generators
-static random_engine_f random_generator(random_seed);
+inline random_engine_f & random_generator()
+{
+	static random_engine_f generator(random_seed_state());
+	return generator;
+}
 
 
 // get and set random seed
 
 inline void set_random_seed(const size_t seed)
 {
-	random_seed = static_cast<random_engine_t>(seed);
-	random_generator = random_engine_f(random_seed);
+	random_seed_state() = static_cast<random_engine_t>(seed);
+	random_generator() = random_engine_f(random_seed_state());
 }
 
 inline random_engine_t get_random_seed()
 {
-	return random_seed;
+	return random_seed_state();
+}
+
+
+// mix bits of 64-bit value (splitmix64 finaliser)
+
+inline uint64_t random_mix(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
 }
 
 
+// Counter-based random stream, keyed by seed and identifiers (e.g. site, pair)
+// Sequence is independent of thread scheduling and of other streams
+
+class random_stream
+{
+public:
+
+	using result_type = uint64_t;
+
+	static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+
+	// construct
+	template<class... Keys>
+	explicit random_stream(const Keys &... keys)
+	: state(random_mix(static_cast<uint64_t>(get_random_seed()) + golden))
+	{
+		this->key(keys...);
+	}
+
+	// next number
+	result_type operator () ()
+	{
+		this->state += golden;
+		return random_mix(this->state);
+	}
+
+
+private:
+
+	static constexpr uint64_t golden = 0x9E3779B97F4A7C15ULL;
+
+	void key() {}
+
+	template<class Key, class... Keys>
+	void key(const Key & k, const Keys &... keys)
+	{
+		this->state = random_mix(this->state ^ (static_cast<uint64_t>(k) + golden));
+		this->key(keys...);
+	}
+
+	uint64_t state;
+};
+
+
 // random number
 
 inline random_output_t random_number()
 {
-	return static_cast<random_output_t>(random_generator());
+	return static_cast<random_output_t>(random_generator()());
 }
 
 inline random_output_t random_number(const size_t upper)
 {
-	return std::uniform_int_distribution<random_output_t>(0, upper - 1)(random_generator);
+	return std::uniform_int_distribution<random_output_t>(0, upper - 1)(random_generator());
 }
 
 inline random_output_t random_number(const size_t lower, const size_t upper)
 {
-	return std::uniform_int_distribution<random_output_t>(lower, upper - 1)(random_generator);
+	return std::uniform_int_distribution<random_output_t>(lower, upper - 1)(random_generator());
+}
+
+inline random_output_t random_number(random_stream & stream, const size_t upper)
+{
+	return std::uniform_int_distribution<random_output_t>(0, upper - 1)(stream);
 }
 
 
-// random number vector
+// random number vector, drawn from given source of numbers
 
-inline random_vector_t random_vector(const size_t size, const bool unique = false, const bool sorted = false)
+template< typename Draw >
+inline random_vector_t random_vector_draw(Draw draw, const size_t size, const bool unique, const bool sorted)
 {
 	random_vector_t v(size);
 	
@@ -74,7 +145,7 @@ inline random_vector_t random_vector(const size_t size, const bool unique = fals
 		if (sorted)
 		{
 			while (u.size() < size)
-				u.insert(random_number());
+				u.insert(draw());
 			
 			v.assign(u.begin(), u.end());
 		}
@@ -82,12 +153,12 @@ inline random_vector_t random_vector(const size_t size, const bool unique = fals
 		{
 			for (size_t i = 0; i < size; ++i)
 			{
-				random_output_t n = random_number();
+				random_output_t n = draw();
 				u.insert(n);
 				
 				while (u.size() < i + 1)
 				{
-					n = random_number();
+					n = draw();
 					u.insert(n);
 				}
 				
@@ -98,7 +169,7 @@ inline random_vector_t random_vector(const size_t size, const bool unique = fals
 	else
 	{
 		for (size_t i = 0; i < size; ++i)
-			v[i] = random_number();
+			v[i] = draw();
 		
 		if (sorted)
 		{
@@ -109,102 +180,36 @@ inline random_vector_t random_vector(const size_t size, const bool unique = fals
 	return v;
 }
 
+
+// random number vector
+
+inline random_vector_t random_vector(const size_t size, const bool unique = false, const bool sorted = false)
+{
+	return random_vector_draw([]() { return random_number(); }, size, unique, sorted);
+}
+
 inline random_vector_t random_vector(const size_t size, const size_t upper, const bool unique = false, const bool sorted = false)
 {
-	random_vector_t v(size);
+	if (unique && upper < size)
+		throw std::logic_error("Random number vector size must be larger than limit");
 	
-	if (unique)
-	{
-		if (upper < size)
-			throw std::logic_error("Random number vector size must be larger than limit");
-		
-		std::set< random_output_t > u;
-		
-		if (sorted)
-		{
-			while (u.size() < size)
-				u.insert(random_number(upper));
-			
-			v.assign(u.begin(), u.end());
-		}
-		else
-		{
-			for (size_t i = 0; i < size; ++i)
-			{
-				random_output_t n = random_number(upper);
-				u.insert(n);
-				
-				while (u.size() < i + 1)
-				{
-					n = random_number(upper);
-					u.insert(n);
-				}
-				
-				v[i] = n;
-			}
-		}
-	}
-	else
-	{
-		for (size_t i = 0; i < size; ++i)
-			v[i] = random_number(upper);
-		
-		if (sorted)
-		{
-			std::sort(v.begin(), v.end());
-		}
-	}
+	return random_vector_draw([upper]() { return random_number(upper); }, size, unique, sorted);
+}
+
+inline random_vector_t random_vector(random_stream & stream, const size_t size, const size_t upper, const bool unique = false, const bool sorted = false)
+{
+	if (unique && upper < size)
+		throw std::logic_error("Random number vector size must be larger than limit");
 	
-	return v;
+	return random_vector_draw([&stream, upper]() { return random_number(stream, upper); }, size, unique, sorted);
 }
 
 inline random_vector_t random_vector(const size_t size, const size_t lower, const size_t upper, const bool unique = false, const bool sorted = false)
 {
-	random_vector_t v(size);
-	
-	if (unique)
-	{
-		if (upper - lower < size)
-			throw std::logic_error("Random number vector size must be larger than range");
-		
-		std::set< random_output_t > u;
-		
-		if (sorted)
-		{
-			while (u.size() < size)
-				u.insert(random_number(lower, upper));
-			
-			v.assign(u.begin(), u.end());
-		}
-		else
-		{
-			for (size_t i = 0; i < size; ++i)
-			{
-				random_output_t n = random_number(lower, upper);
-				u.insert(n);
-				
-				while (u.size() < i + 1)
-				{
-					n = random_number(lower, upper);
-					u.insert(n);
-				}
-				
-				v[i] = n;
-			}
-		}
-	}
-	else
-	{
-		for (size_t i = 0; i < size; ++i)
-			v[i] = random_number(lower, upper);
-		
-		if (sorted)
-		{
-			std::sort(v.begin(), v.end());
-		}
-	}
+	if (unique && upper - lower < size)
+		throw std::logic_error("Random number vector size must be larger than range");
 	
-	return v;
+	return random_vector_draw([lower, upper]() { return random_number(lower, upper); }, size, unique, sorted);
 }
 
 
@@ -213,13 +218,19 @@ inline random_vector_t random_vector(const size_t size, const size_t lower, cons
 inline bool random_coin()
 {
 	std::bernoulli_distribution distr;
-	return distr(random_generator);
+	return distr(random_generator());
 	
 	// static constexpr random_output_t half = static_cast<random_output_t>(((std::numeric_limits<random_engine_t>::max() - 1) / 2) + 1);
 	// return (random_number() < half);
 }
 
 
+inline bool random_coin(random_stream & stream)
+{
+	return (stream() >> 63) != 0;
+}
+
+
 // random string
 
 inline std::string random_string(const size_t n)
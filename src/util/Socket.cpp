@@ -0,0 +1,173 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#include "Socket.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+// construct, listen on path
+
+Socket::Socket(const std::string & _path)
+: path(_path)
+, server(-1)
+, client(-1)
+{
+	struct sockaddr_un addr;
+
+	if (this->path.size() >= sizeof(addr.sun_path))
+	{
+		throw std::invalid_argument("Socket path is too long: " + this->path);
+	}
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strncpy(addr.sun_path, this->path.c_str(), sizeof(addr.sun_path) - 1);
+
+	this->server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (this->server < 0)
+	{
+		throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+	}
+
+	::unlink(this->path.c_str()); // remove stale socket file
+
+	if (::bind(this->server, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+		::listen(this->server, 8) < 0)
+	{
+		const std::string error = std::strerror(errno);
+
+		::close(this->server);
+
+		throw std::runtime_error("Unable to listen on socket: " + this->path + " (" + error + ")");
+	}
+}
+
+
+// destruct
+
+Socket::~Socket()
+{
+	this->close();
+
+	if (this->server >= 0)
+	{
+		::close(this->server);
+		::unlink(this->path.c_str());
+	}
+}
+
+
+// wait for next client, closes current client
+
+bool Socket::accept()
+{
+	this->close();
+
+	while (true)
+	{
+		this->client = ::accept(this->server, nullptr, nullptr);
+
+		if (this->client >= 0)
+			return true;
+
+		if (errno != EINTR)
+			return false;
+	}
+}
+
+
+// read line from current client, returns false when client disconnects
+
+bool Socket::read(std::string & line)
+{
+	char buffer[4096];
+
+	while (true)
+	{
+		const size_t end = this->pending.find('\n');
+
+		if (end != std::string::npos)
+		{
+			line = this->pending.substr(0, end);
+			this->pending.erase(0, end + 1);
+			return true;
+		}
+
+		if (this->client < 0)
+			return false;
+
+		const ssize_t n = ::recv(this->client, buffer, sizeof(buffer), 0);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0)
+		{
+			std::string rest;
+
+			rest.swap(this->pending);
+
+			this->close();
+
+			if (rest.empty())
+				return false;
+
+			line.swap(rest); // last line without newline
+			return true;
+		}
+
+		this->pending.append(buffer, static_cast<size_t>(n));
+	}
+}
+
+
+// write to current client, returns false when client disconnects
+
+bool Socket::write(const std::string & data)
+{
+	size_t done = 0;
+
+	while (done < data.size())
+	{
+		if (this->client < 0)
+			return false;
+
+		const ssize_t n = ::send(this->client, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0)
+		{
+			this->close();
+			return false;
+		}
+
+		done += static_cast<size_t>(n);
+	}
+
+	return true;
+}
+
+
+// close current client
+
+void Socket::close()
+{
+	if (this->client >= 0)
+	{
+		::close(this->client);
+		this->client = -1;
+	}
+
+	this->pending.clear();
+}
@@ -0,0 +1,50 @@
+//
+//  Copyright (c) 2018 Patrick K. Albers. All rights reserved.
+//
+
+#ifndef Socket_hpp
+#define Socket_hpp
+
+#include <string>
+
+
+//
+// Local (Unix domain) stream socket, serving one client at a time
+//
+class Socket
+{
+public:
+
+	// construct, listen on path
+	Socket(const std::string &);
+	Socket(const Socket &) = delete; // no copy
+
+	// destruct
+	~Socket();
+
+
+	// wait for next client, closes current client
+	bool accept();
+
+	// read line from current client, returns false when client disconnects
+	bool read(std::string &);
+
+	// write to current client, returns false when client disconnects
+	bool write(const std::string &);
+
+	// close current client
+	void close();
+
+
+private:
+
+	const std::string path;
+
+	int server; // listening descriptor
+	int client; // connected descriptor
+
+	std::string pending; // received but not yet returned
+};
+
+
+#endif /* Socket_hpp */